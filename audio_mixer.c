@@ -0,0 +1,366 @@
+#include "audio_mixer.h"
+
+#include <string.h>
+
+#include "hardware/sync.h"
+#include "g711.h"
+
+// Voice sample formats; compressed voices are mixed from their s16 decode.
+enum {
+    MIX_U8 = 0,
+    MIX_S16,
+    MIX_ALAW,
+    MIX_ULAW,
+};
+
+// One sample in s16 scale; fmt is a constant wherever this sits in a loop.
+static inline int32_t mix_load(const uint8_t *p, uint fmt) {
+    switch (fmt) {
+    case MIX_U8:
+        return ((int32_t)p[0] - 128) * 256;
+    case MIX_S16:
+        return *(const int16_t *)p;
+    case MIX_ALAW:
+        return g711_alaw_to_s16[p[0]];
+    default:
+        return g711_ulaw_to_s16[p[0]];
+    }
+}
+
+// Accumulates frames of one voice for each channel layout. A mono voice
+// feeds both channels of a stereo mix through its two gains; a stereo voice
+// mixed to mono adds half its (L+R) sum.
+static inline void mix_frames(int32_t *acc, const uint8_t *src, size_t frames, const int32_t *gain, uint fmt,
+                              uint in, uint out) {
+    uint bytes = fmt == MIX_S16 ? 2u : 1u;
+    int32_t g0 = gain[0], g1 = gain[1];
+    if (out == 2) {
+        for (size_t i = 0; i < frames; ++i) {
+            int32_t l = mix_load(src + i * in * bytes, fmt);
+            int32_t r = in == 2 ? mix_load(src + (2 * i + 1) * bytes, fmt) : l;
+            acc[2 * i] += l * g0;
+            acc[2 * i + 1] += r * g1;
+        }
+    } else if (in == 2) {
+        for (size_t i = 0; i < frames; ++i) {
+            acc[i] += ((mix_load(src + 2 * i * bytes, fmt) + mix_load(src + (2 * i + 1) * bytes, fmt)) * g0) >> 1;
+        }
+    } else {
+        for (size_t i = 0; i < frames; ++i) {
+            acc[i] += mix_load(src + i * bytes, fmt) * g0;
+        }
+    }
+}
+
+#define MIX_KERNELS(name, fmt)                                                                              \
+    static void mix_##name##_mono(int32_t *acc, const uint8_t *src, size_t frames, const int32_t *gain) {   \
+        mix_frames(acc, src, frames, gain, fmt, 1, 1);                                                      \
+    }                                                                                                       \
+    static void mix_##name##_mono_pan(int32_t *acc, const uint8_t *src, size_t frames, const int32_t *gain) { \
+        mix_frames(acc, src, frames, gain, fmt, 1, 2);                                                      \
+    }                                                                                                       \
+    static void mix_##name##_downmix(int32_t *acc, const uint8_t *src, size_t frames, const int32_t *gain) { \
+        mix_frames(acc, src, frames, gain, fmt, 2, 1);                                                      \
+    }                                                                                                       \
+    static void mix_##name##_stereo(int32_t *acc, const uint8_t *src, size_t frames, const int32_t *gain) { \
+        mix_frames(acc, src, frames, gain, fmt, 2, 2);                                                      \
+    }
+
+MIX_KERNELS(u8, MIX_U8)
+MIX_KERNELS(s16, MIX_S16)
+MIX_KERNELS(alaw, MIX_ALAW)
+MIX_KERNELS(ulaw, MIX_ULAW)
+
+// Voice kernels by format, then [channels - 1][mixer channels - 1].
+static const audio_mix_kernel_t mix_kernels[][2][2] = {
+    [MIX_U8] = {{mix_u8_mono, mix_u8_mono_pan}, {mix_u8_downmix, mix_u8_stereo}},
+    [MIX_S16] = {{mix_s16_mono, mix_s16_mono_pan}, {mix_s16_downmix, mix_s16_stereo}},
+    [MIX_ALAW] = {{mix_alaw_mono, mix_alaw_mono_pan}, {mix_alaw_downmix, mix_alaw_stereo}},
+    [MIX_ULAW] = {{mix_ulaw_mono, mix_ulaw_mono_pan}, {mix_ulaw_downmix, mix_ulaw_stereo}},
+};
+
+static bool is_decoded(const wav_info_t *wav) {
+    return wav->encoding == WAV_ENCODING_IMA_ADPCM || wav->encoding == WAV_ENCODING_QOA;
+}
+
+static audio_mix_kernel_t select_mix_kernel(const wav_info_t *wav, uint out) {
+    int fmt = -1;
+    if (wav->channels < 1 || wav->channels > 2) {
+        return NULL;
+    }
+    if (is_decoded(wav)) {
+        fmt = MIX_S16;
+    } else if (wav->encoding == WAV_ENCODING_ALAW || wav->encoding == WAV_ENCODING_MULAW) {
+        fmt = wav->bits_per_sample != 8 ? -1 : wav->encoding == WAV_ENCODING_ALAW ? MIX_ALAW : MIX_ULAW;
+    } else if (wav->encoding == WAV_ENCODING_PCM && !wav->is_float) {
+        fmt = wav->bits_per_sample == 8 ? MIX_U8 : wav->bits_per_sample == 16 ? MIX_S16 : -1;
+    }
+    return fmt < 0 ? NULL : mix_kernels[fmt][wav->channels - 1][out - 1];
+}
+
+static uint16_t clamp_volume(uint16_t volume) {
+    return volume > AUDIO_MIXER_VOLUME_MAX ? AUDIO_MIXER_VOLUME_MAX : volume;
+}
+
+static int16_t clamp_pan(int16_t pan) {
+    return pan < -AUDIO_MIXER_PAN_MAX ? -AUDIO_MIXER_PAN_MAX : pan > AUDIO_MIXER_PAN_MAX ? AUDIO_MIXER_PAN_MAX : pan;
+}
+
+// Channel gains from volume and pan, packed as audio_voice_t.gains; a mono
+// mix only uses gain[0]. Both fit 16 bits, as volume is at most 1024.
+static uint32_t pack_gains(const audio_mixer_t *mixer, int32_t volume, int32_t pan) {
+    if (mixer->channels == 1) {
+        return (uint32_t)volume | (uint32_t)volume << 16;
+    }
+    uint32_t left = (uint32_t)(volume * (AUDIO_MIXER_PAN_MAX - (pan > 0 ? pan : 0)) / AUDIO_MIXER_PAN_MAX);
+    uint32_t right = (uint32_t)(volume * (AUDIO_MIXER_PAN_MAX + (pan < 0 ? pan : 0)) / AUDIO_MIXER_PAN_MAX);
+    return left | right << 16;
+}
+
+// Back to the clip's first frame.
+static void voice_rewind(audio_voice_t *voice) {
+    const wav_info_t *wav = &voice->wav;
+    voice->cursor = wav->data;
+    voice->remaining = wav->data_size;
+    if (wav->encoding == WAV_ENCODING_IMA_ADPCM) {
+        ima_adpcm_init(&voice->adpcm, wav->data, wav->data_size, wav->channels, wav->block_align);
+    } else if (wav->encoding == WAV_ENCODING_QOA) {
+        qoa_init(&voice->qoa, wav->data, wav->data_size, wav->channels);
+    }
+    voice->decoded_pos = voice->decoded_len = 0;
+}
+
+// Up to want frames of a voice in its kernel's format, as the player's
+// next_frames() hands them out. NULL at the end of the data.
+static const uint8_t *voice_frames(audio_voice_t *voice, size_t want, size_t *got) {
+    size_t n;
+    const uint8_t *p;
+    if (!is_decoded(&voice->wav)) {
+        n = voice->remaining / voice->frame_stride;
+        if (n > want) {
+            n = want;
+        }
+        p = voice->cursor;
+        voice->cursor += n * voice->frame_stride;
+        voice->remaining -= n * voice->frame_stride;
+    } else {
+        if (voice->decoded_pos == voice->decoded_len) {
+            voice->decoded_len = (uint16_t)(voice->wav.encoding == WAV_ENCODING_QOA
+                                                ? qoa_decode(&voice->qoa, voice->decoded, AUDIO_MIXER_BLOCK_FRAMES)
+                                                : ima_adpcm_decode(&voice->adpcm, voice->decoded,
+                                                                   AUDIO_MIXER_BLOCK_FRAMES));
+            voice->decoded_pos = 0;
+        }
+        n = (size_t)(voice->decoded_len - voice->decoded_pos);
+        if (n > want) {
+            n = want;
+        }
+        p = (const uint8_t *)(voice->decoded + (size_t)voice->decoded_pos * voice->wav.channels);
+        voice->decoded_pos = (uint16_t)(voice->decoded_pos + n);
+    }
+    *got = n;
+    return n ? p : NULL;
+}
+
+// Adds frames of one voice to the accumulator, restarting a looping voice
+// at the end of its data and ending any other. A loop that yields nothing
+// right after a restart ends too.
+static void mix_voice(audio_mixer_t *mixer, audio_voice_t *voice, size_t frames) {
+    uint32_t gains = voice->gains;
+    const int32_t gain[2] = {(int32_t)(gains & 0xffffu), (int32_t)(gains >> 16)};
+    size_t pos = 0;
+    bool rewound = false;
+    while (pos < frames) {
+        size_t got;
+        const uint8_t *src = voice_frames(voice, frames - pos, &got);
+        if (src) {
+            voice->kernel(mixer->acc + pos * mixer->channels, src, got, gain);
+            pos += got;
+            rewound = false;
+        } else if (voice->loop && !rewound) {
+            voice_rewind(voice);
+            rewound = true;
+        } else {
+            voice->active = false;
+            return;
+        }
+    }
+}
+
+bool audio_mixer_init(audio_mixer_t *mixer, uint32_t sample_rate, bool stereo) {
+    if (!mixer || sample_rate == 0) {
+        return false;
+    }
+    memset(mixer, 0, sizeof(*mixer));
+    mixer->sample_rate = sample_rate;
+    mixer->channels = stereo ? 2u : 1u;
+    return true;
+}
+
+wav_info_t audio_mixer_output(const audio_mixer_t *mixer) {
+    return (wav_info_t){
+        .sample_rate = mixer->sample_rate,
+        .bits_per_sample = 16,
+        .channels = mixer->channels,
+        .encoding = WAV_ENCODING_PCM,
+    };
+}
+
+static size_t mixer_read_frames(void *ctx, int16_t *dst, size_t frames) {
+    return audio_mixer_render(ctx, dst, frames);
+}
+
+static const audio_source_ops_t mixer_source_ops = {mixer_read_frames, NULL};
+
+audio_source_t audio_mixer_source(audio_mixer_t *mixer) {
+    return (audio_source_t){
+        .ops = &mixer_source_ops,
+        .ctx = mixer,
+        .sample_rate = mixer->sample_rate,
+        .channels = mixer->channels,
+    };
+}
+
+// The voice is claimed and set up with interrupts off, so a trigger from an
+// IRQ cannot take the same one. A render on core 1 skips it until the final
+// store hands it over.
+int audio_mixer_play(audio_mixer_t *mixer, const wav_info_t *wav, uint16_t volume, int16_t pan, bool loop) {
+    if (!mixer || !wav || wav->sample_rate != mixer->sample_rate) {
+        return -1;
+    }
+    audio_mix_kernel_t kernel = select_mix_kernel(wav, mixer->channels);
+    uint16_t stride = (uint16_t)(wav->bits_per_sample / 8u * wav->channels);
+    if (!kernel || (!is_decoded(wav) && stride == 0)) {
+        return -1;
+    }
+    uint32_t irq_state = save_and_disable_interrupts();
+    int v = 0;
+    while (v < AUDIO_MIXER_VOICES && mixer->voices[v].active) {
+        ++v;
+    }
+    if (v < AUDIO_MIXER_VOICES) {
+        audio_voice_t *voice = &mixer->voices[v];
+        voice->wav = *wav;
+        voice->kernel = kernel;
+        voice->frame_stride = stride;
+        voice->loop = loop;
+        voice->volume = clamp_volume(volume);
+        voice->pan = clamp_pan(pan);
+        voice->gains = pack_gains(mixer, voice->volume, voice->pan);
+        voice_rewind(voice);
+        __dmb();
+        voice->active = true;
+    }
+    restore_interrupts(irq_state);
+    return v < AUDIO_MIXER_VOICES ? v : -1;
+}
+
+void audio_mixer_stop(audio_mixer_t *mixer, int voice) {
+    if (mixer && voice >= 0 && voice < AUDIO_MIXER_VOICES) {
+        mixer->voices[voice].active = false;
+    }
+}
+
+void audio_mixer_stop_all(audio_mixer_t *mixer) {
+    for (int v = 0; v < AUDIO_MIXER_VOICES; ++v) {
+        audio_mixer_stop(mixer, v);
+    }
+}
+
+// Both gains go out in one 32-bit store, which a render reads once per block.
+void audio_mixer_set_volume(audio_mixer_t *mixer, int voice, uint16_t volume) {
+    if (!mixer || voice < 0 || voice >= AUDIO_MIXER_VOICES) {
+        return;
+    }
+    audio_voice_t *v = &mixer->voices[voice];
+    v->volume = clamp_volume(volume);
+    v->gains = pack_gains(mixer, v->volume, v->pan);
+}
+
+void audio_mixer_set_pan(audio_mixer_t *mixer, int voice, int16_t pan) {
+    if (!mixer || voice < 0 || voice >= AUDIO_MIXER_VOICES) {
+        return;
+    }
+    audio_voice_t *v = &mixer->voices[voice];
+    v->pan = clamp_pan(pan);
+    v->gains = pack_gains(mixer, v->volume, v->pan);
+}
+
+int audio_mixer_play_at(audio_mixer_t *mixer, const wav_info_t *wav, uint16_t volume, int16_t pan, bool loop,
+                        uint64_t *frame) {
+    if (!mixer || !frame) {
+        return -1;
+    }
+    uint64_t oldest = mixer->frames_mixed > AUDIO_MIXER_HISTORY_FRAMES
+                          ? mixer->frames_mixed - AUDIO_MIXER_HISTORY_FRAMES
+                          : 0;
+    if (*frame < oldest) {
+        *frame = oldest;
+    } else if (*frame > mixer->frames_mixed) {
+        *frame = mixer->frames_mixed;
+    }
+    return audio_mixer_play(mixer, wav, volume, pan, loop);
+}
+
+// The voice alone goes through the accumulator, then onto the kept sums.
+void audio_mixer_remix(audio_mixer_t *mixer, int voice, uint64_t frame, int16_t *dst, size_t frames) {
+    uint channels = mixer->channels;
+    audio_voice_t *v = &mixer->voices[voice];
+    for (size_t done = 0; done < frames;) {
+        size_t n = frames - done;
+        if (n > AUDIO_MIXER_BLOCK_FRAMES) {
+            n = AUDIO_MIXER_BLOCK_FRAMES;
+        }
+        memset(mixer->acc, 0, n * channels * sizeof(mixer->acc[0]));
+        if (v->active) {
+            mix_voice(mixer, v, n);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            int32_t *h = mixer->history + ((frame + done + i) & (AUDIO_MIXER_HISTORY_FRAMES - 1u)) * channels;
+            for (uint c = 0; c < channels; ++c) {
+                int32_t sum = h[c] + mixer->acc[i * channels + c];
+                int32_t s = sum >> 8;
+                h[c] = sum;
+                dst[(done + i) * channels + c] = (int16_t)(s > 32767 ? 32767 : s < -32768 ? -32768 : s);
+            }
+        }
+        done += n;
+    }
+}
+
+bool audio_mixer_is_playing(const audio_mixer_t *mixer, int voice) {
+    return mixer && voice >= 0 && voice < AUDIO_MIXER_VOICES && mixer->voices[voice].active;
+}
+
+// Sum of all voices in 1/256 s16 steps, kept for audio_mixer_remix() and
+// saturated once at the end.
+size_t audio_mixer_render(audio_mixer_t *mixer, int16_t *dst, size_t frames) {
+    uint channels = mixer->channels;
+    for (size_t done = 0; done < frames;) {
+        size_t n = frames - done;
+        if (n > AUDIO_MIXER_BLOCK_FRAMES) {
+            n = AUDIO_MIXER_BLOCK_FRAMES;
+        }
+        // A block stops at the end of the history, so its sums are one run.
+        size_t at = (size_t)(mixer->frames_mixed & (AUDIO_MIXER_HISTORY_FRAMES - 1u));
+        if (n > AUDIO_MIXER_HISTORY_FRAMES - at) {
+            n = AUDIO_MIXER_HISTORY_FRAMES - at;
+        }
+        memset(mixer->acc, 0, n * channels * sizeof(mixer->acc[0]));
+        for (uint v = 0; v < AUDIO_MIXER_VOICES; ++v) {
+            if (mixer->voices[v].active) {
+                mix_voice(mixer, &mixer->voices[v], n);
+            }
+        }
+        int16_t *out = dst + done * channels;
+        int32_t *history = mixer->history + at * channels;
+        for (size_t i = 0; i < n * channels; ++i) {
+            int32_t s = mixer->acc[i] >> 8;
+            history[i] = mixer->acc[i];
+            out[i] = (int16_t)(s > 32767 ? 32767 : s < -32768 ? -32768 : s);
+        }
+        mixer->frames_mixed += n;
+        done += n;
+    }
+    return frames;
+}
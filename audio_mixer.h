@@ -0,0 +1,142 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio_source.h"
+#include "ima_adpcm.h"
+#include "qoa.h"
+#include "wav.h"
+
+// Software mixer for a player (audio_pwm_dma_config_t.mixer): a fixed pool
+// of voices, each playing a clip at its own volume and pan, summed into one
+// s16 stream that the player's refill path turns into PWM levels like any
+// other 16-bit source, dither and sigma-delta included.
+//
+// Voices take the formats clips are stored in flash: u8 and s16 PCM,
+// A-law, mu-law, IMA ADPCM and QOA, mono or stereo, all at the mixer's
+// sample rate (there is no resampling; convert clips beforehand). Each
+// voice sample is multiplied by its channel gain and summed into a 32-bit
+// accumulator per output sample, then saturated once to s16.
+//
+// Cycle budget: the per-format voice kernels cost a load, a multiply and
+// an add per voice and output sample, so 8 PCM or G.711 voices at 44.1 kHz
+// stay under 10% of a 125 MHz core (35 cycles per voice and sample;
+// refill_bench prints the figures). ADPCM and QOA voices add their decode
+// cost on top.
+
+#define AUDIO_MIXER_VOICES 8
+
+// Frames mixed per pass; the accumulator and each voice's decode buffer
+// hold this many.
+#define AUDIO_MIXER_BLOCK_FRAMES 64
+
+// Mixed frames the mixer keeps as 32-bit sums, a power of two. A voice can
+// be started back into this many of them (audio_mixer_play_at()), which is
+// how audio_pwm_dma_trigger() gets it into audio already queued for the
+// DMA. Costs 8 bytes per frame; it should cover the player's ring plus
+// AUDIO_PWM_DMA_DECODE_FRAMES, or triggers land later than asked.
+#ifndef AUDIO_MIXER_HISTORY_FRAMES
+#define AUDIO_MIXER_HISTORY_FRAMES 2048
+#endif
+
+// Volume is linear in 1/256 steps: AUDIO_MIXER_UNITY plays a voice as
+// recorded, up to AUDIO_MIXER_VOLUME_MAX (4x) boosts it.
+#define AUDIO_MIXER_UNITY 256
+#define AUDIO_MIXER_VOLUME_MAX 1024
+
+// Pan runs from -AUDIO_MIXER_PAN_MAX (left only) through 0 (centre, both
+// channels at full volume) to AUDIO_MIXER_PAN_MAX (right only); panning
+// towards one side turns the other down linearly. Mono mixers ignore it.
+#define AUDIO_MIXER_PAN_MAX 127
+
+// Adds frames of a voice's samples times gain (per output channel) to acc.
+typedef void (*audio_mix_kernel_t)(int32_t *acc, const uint8_t *src, size_t frames, const int32_t *gain);
+
+typedef struct {
+    volatile bool active;
+    bool loop;
+    wav_info_t wav;
+    const uint8_t *cursor;
+    size_t remaining;
+    uint16_t frame_stride;
+    audio_mix_kernel_t kernel;
+    // Channel gains, gain[0] | gain[1] << 16, so both change in one store.
+    volatile uint32_t gains;
+    uint16_t volume;
+    int16_t pan;
+    // Compressed voices decode here first, as the player does.
+    union {
+        ima_adpcm_decoder_t adpcm;
+        qoa_decoder_t qoa;
+    };
+    int16_t decoded[AUDIO_MIXER_BLOCK_FRAMES * 2];
+    uint16_t decoded_pos;
+    uint16_t decoded_len;
+} audio_voice_t;
+
+typedef struct audio_mixer {
+    uint32_t sample_rate;
+    uint16_t channels;
+    audio_voice_t voices[AUDIO_MIXER_VOICES];
+    int32_t acc[AUDIO_MIXER_BLOCK_FRAMES * 2];
+    // Frames rendered since init, and the sums of the latest of them.
+    uint64_t frames_mixed;
+    int32_t history[AUDIO_MIXER_HISTORY_FRAMES * 2];
+} audio_mixer_t;
+
+// Sets up an idle mixer for sample_rate, mixing to stereo or mono.
+bool audio_mixer_init(audio_mixer_t *mixer, uint32_t sample_rate, bool stereo);
+
+// The mixer as a source (see audio_source.h) that renders on each read and
+// never ends. Mixer players read it.
+audio_source_t audio_mixer_source(audio_mixer_t *mixer);
+
+// The mixer's output as a source description: s16 at its rate and
+// channel count, with no data. audio_pwm_dma_init_with_config() uses it.
+wav_info_t audio_mixer_output(const audio_mixer_t *mixer);
+
+// Starts wav on a free voice and returns the voice's id, or -1 if every
+// voice is busy or the clip's format or rate does not fit the mixer. A
+// looping voice restarts at the clip's start until it is stopped; the
+// others end with their data, and their id is then handed out again.
+// Safe to call while the mixer plays, from a thread and an IRQ handler on
+// the same core: the free voice is claimed with interrupts off. Callers on
+// the other core need a lock of their own.
+int audio_mixer_play(audio_mixer_t *mixer, const wav_info_t *wav, uint16_t volume, int16_t pan, bool loop);
+
+// Starts wav as audio_mixer_play() does, but as if it had started at
+// *frame, a frame already rendered: one of the last
+// AUDIO_MIXER_HISTORY_FRAMES, else *frame is moved up to the oldest of them.
+// The caller must then bring every frame from *frame up to frames_mixed
+// up to date with audio_mixer_remix(), in order, before the next render.
+int audio_mixer_play_at(audio_mixer_t *mixer, const wav_info_t *wav, uint16_t volume, int16_t pan, bool loop,
+                        uint64_t *frame);
+
+// Adds the next frames of a voice started with audio_mixer_play_at() to the
+// rendered frames from frame on, and writes the new mix of those frames to
+// dst as audio_mixer_render() would have.
+void audio_mixer_remix(audio_mixer_t *mixer, int voice, uint64_t frame, int16_t *dst, size_t frames);
+
+// Stops a voice at once. Ids that are not playing are ignored.
+void audio_mixer_stop(audio_mixer_t *mixer, int voice);
+
+// Stops every voice.
+void audio_mixer_stop_all(audio_mixer_t *mixer);
+
+// Changes a playing voice's volume or pan from the next mixed block on.
+// A render on either core sees both channel gains old or both new.
+void audio_mixer_set_volume(audio_mixer_t *mixer, int voice, uint16_t volume);
+void audio_mixer_set_pan(audio_mixer_t *mixer, int voice, int16_t pan);
+
+// True while the voice plays.
+bool audio_mixer_is_playing(const audio_mixer_t *mixer, int voice);
+
+// Mixes the next frames of every playing voice into interleaved s16 frames
+// at dst (silence when none plays). This is the player's refill path; it
+// is exposed for benchmarks and offline rendering. Returns frames.
+size_t audio_mixer_render(audio_mixer_t *mixer, int16_t *dst, size_t frames);
+
+#endif
@@ -1,174 +1,1781 @@
 #include "audio_pwm_dma.h"
 
+#include <string.h>
+
 #include "hardware/clocks.h"
 #include "hardware/dma.h"
 #include "hardware/irq.h"
 #include "hardware/pwm.h"
+#include "hardware/sync.h"
 #include "pico/stdlib.h"
+#include "cycle_counter.h"
+#include "g711.h"
+#include "pace_solver.h"
+#if AUDIO_PWM_DMA_PIPELINE
+#include "pico/multicore.h"
+#endif
+
+// Let a DMA pacing timer replace the PWM pacing slice when it hits the
+// sample rate more closely.
+#ifndef AUDIO_PWM_DMA_PACE_TIMER
+#define AUDIO_PWM_DMA_PACE_TIMER 1
+#endif
+
+// The shared DMA IRQ dispatcher routes each channel's completion to the
+// player that owns it. Slices are claimed per player (output and pacing) so
+// instances cannot trample each other's PWM settings.
+static audio_player_t *players_by_chan[NUM_DMA_CHANNELS];
+static uint32_t claimed_slices;
+
+// The player whose ring core 1 refills, if any.
+static audio_player_t *pipeline_owner;
 
-// Two DMA buffers allow refill while the other channel streams.
-#define DMA_SAMPLES 512
-static uint16_t dma_samples_a[DMA_SAMPLES];
-static uint16_t dma_samples_b[DMA_SAMPLES];
-// IRQ handler needs a stable pointer to the active player.
-static audio_player_t *g_player;
+// Claim the highest unclaimed PWM slice as the DMA pacing clock, leaving the
+// low slices (GPIO 0-7) free for further outputs. A player without one has
+// pace_slice equal to its output slice. False if every slice is taken.
+static bool claim_pace_slice(audio_player_t *player) {
+    if (player->pace_slice != player->slice_num) {
+        return true;
+    }
+    for (int slice = NUM_PWM_SLICES - 1; slice >= 0; --slice) {
+        if (!(claimed_slices & (1u << slice))) {
+            player->pace_slice = (uint)slice;
+            claimed_slices |= 1u << slice;
+            return true;
+        }
+    }
+    return false;
+}
 
-// Pick a different PWM slice to use as the DMA pacing clock.
-static uint pick_pace_slice(uint audio_slice) {
-    uint pace_slice = (audio_slice + 1u) & 0x7u;
-    if (pace_slice == audio_slice) {
-        pace_slice = (audio_slice + 2u) & 0x7u;
+static void release_pace_slice(audio_player_t *player) {
+    if (player->pace_slice != player->slice_num) {
+        pwm_set_enabled(player->pace_slice, false);
+        claimed_slices &= ~(1u << player->pace_slice);
+        player->pace_slice = player->slice_num;
     }
-    return pace_slice;
 }
 
-// Configure PWM on the audio GPIO at a high carrier frequency.
-static void init_audio_pwm(uint gpio, uint *slice_out, uint *channel_out) {
+// Configure PWM on the audio GPIO (and its B-channel neighbour for stereo
+// or differential output) at a high carrier frequency. Differential output
+// inverts channel B, so the pair swings in complementary phase.
+static void init_audio_pwm(uint gpio, bool pair, bool invert_b, uint *slice_out, uint *channel_out) {
     gpio_set_function(gpio, GPIO_FUNC_PWM);
+    if (pair) {
+        gpio_set_function(gpio + 1u, GPIO_FUNC_PWM);
+    }
     uint slice = pwm_gpio_to_slice_num(gpio);
     uint channel = pwm_gpio_to_channel(gpio);
 
     pwm_config cfg = pwm_get_default_config();
     pwm_config_set_wrap(&cfg, 255); // 8-bit duty cycle
     pwm_config_set_clkdiv(&cfg, 1.0f); // high carrier for PWM audio
+    pwm_config_set_output_polarity(&cfg, false, invert_b);
     pwm_init(slice, &cfg, true);
-    pwm_set_gpio_level(gpio, 128); // idle midpoint
+    pwm_set_both_levels(slice, 128, 128); // idle midpoint
 
     *slice_out = slice;
     *channel_out = channel;
 }
 
-// Configure a PWM slice to generate the sample-rate DMA pacing DREQ.
-static void init_pace_pwm(uint32_t sample_rate, uint slice) {
+// Sigma-delta carrier: levels per period, at most the 8-bit wrap, and at
+// least enough for a multi-bit quantizer to stay stable.
+#define SD_LEVELS_MIN 32u
+#define SD_LEVELS_MAX 256u
+
+// Sigma-delta output paces itself: the output slice wraps once per
+// oversampled step, so each level lasts exactly one PWM period. The period
+// comes out of the divider/period search, and with it the level count.
+static bool init_sigma_delta_pacing(audio_player_t *player, uint32_t clk_hz) {
+    pace_solution_t pace;
+    uint32_t carrier_hz = player->wav.sample_rate * player->oversample;
+    if (!pace_solve_carrier(clk_hz, carrier_hz, SD_LEVELS_MIN, SD_LEVELS_MAX, &pace)) {
+        return false;
+    }
+
     pwm_config cfg = pwm_get_default_config();
+    pwm_config_set_wrap(&cfg, pace.pwm_wrap);
+    pwm_config_set_clkdiv_int_frac(&cfg, pace.pwm_div_int, pace.pwm_div_frac);
+    pwm_config_set_output_polarity(&cfg, false, player->differential_output);
+    pwm_init(player->slice_num, &cfg, false);
+    player->sd_levels = (uint16_t)(pace.pwm_wrap + 1u);
+    player->level_mid = (uint16_t)(player->sd_levels / 2u);
+    pwm_set_both_levels(player->slice_num, player->level_mid, player->level_mid);
+    pwm_set_enabled(player->slice_num, true);
+
+    player->pace_timer = -1;
+    player->pace_dreq = DREQ_PWM_WRAP0 + player->slice_num;
+    player->pace_rate_millihz = pace.rate_millihz;
+    player->pace_error_ppb = pace.error_ppb;
+    return true;
+}
+
+// Generate the sample-rate DMA pacing DREQ, choosing the fractional PWM
+// divider/wrap pair or DMA timer fraction closest to the WAV rate. A pacing
+// slice is only claimed when PWM pacing is chosen.
+static bool init_pacing(audio_player_t *player) {
     uint32_t clk_hz = clock_get_hz(clk_sys);
-    uint32_t wrap = clk_hz / sample_rate;
-    if (wrap == 0) {
-        wrap = 1;
+    if (player->oversample > 1) {
+        return init_sigma_delta_pacing(player, clk_hz);
     }
-    if (wrap > 0x10000u) {
-        wrap = 0x10000u;
+    pace_solution_t pace;
+    if (!pace_solve(clk_hz, player->wav.sample_rate, AUDIO_PWM_DMA_PACE_TIMER, &pace)) {
+        return false;
     }
-    pwm_config_set_wrap(&cfg, (uint16_t)(wrap - 1u));
-    pwm_config_set_clkdiv(&cfg, 1.0f);
-    pwm_init(slice, &cfg, true);
+
+    player->pace_timer = -1;
+    if (pace.source == PACE_SOURCE_DMA_TIMER) {
+        int timer = dma_claim_unused_timer(false);
+        if (timer < 0) {
+            // Every pacing timer is taken; settle for the best PWM fit.
+            if (!pace_solve(clk_hz, player->wav.sample_rate, false, &pace)) {
+                return false;
+            }
+        } else {
+            dma_timer_set_fraction((uint)timer, pace.timer_num, pace.timer_den);
+            player->pace_timer = timer;
+            player->pace_dreq = dma_get_timer_dreq((uint)timer);
+        }
+    }
+
+    if (pace.source == PACE_SOURCE_PWM) {
+        if (!claim_pace_slice(player)) {
+            return false;
+        }
+        pwm_config cfg = pwm_get_default_config();
+        pwm_config_set_wrap(&cfg, pace.pwm_wrap);
+        pwm_config_set_clkdiv_int_frac(&cfg, pace.pwm_div_int, pace.pwm_div_frac);
+        pwm_init(player->pace_slice, &cfg, true);
+        player->pace_dreq = DREQ_PWM_WRAP0 + player->pace_slice;
+    } else {
+        release_pace_slice(player);
+    }
+
+    player->pace_rate_millihz = pace.rate_millihz;
+    player->pace_error_ppb = pace.error_ppb;
+    return true;
 }
 
-// Convert WAV samples into 8-bit PWM levels for DMA streaming.
-static void fill_dma_buffer(audio_player_t *player, uint16_t *buffer, size_t count) {
-    for (size_t i = 0; i < count; ++i) {
-        if (player->remaining < player->frame_stride) {
-            player->done = true;
-            buffer[i] = 128;
-            continue;
+// Refill kernels: each converts a run of whole frames with no per-sample
+// bounds or format checks. Mono output downmixes stereo sources to (L+R)/2,
+// which cannot clip: the sum is halved before it is narrowed. Stereo output
+// writes an A/B level pair per frame (one 32-bit CC word), duplicating mono
+// sources.
+static void kernel_u8_mono(uint16_t *dst, const uint8_t *src, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+static void kernel_u8_downmix(uint16_t *dst, const uint8_t *src, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        dst[i] = (uint16_t)((src[2 * i] + src[2 * i + 1]) >> 1);
+    }
+}
+
+static void kernel_s16_mono(uint16_t *dst, const uint8_t *src, size_t frames) {
+    const int16_t *s = (const int16_t *)src;
+    for (size_t i = 0; i < frames; ++i) {
+        dst[i] = (uint16_t)(((int32_t)s[i] + 32768) >> 8);
+    }
+}
+
+static void kernel_s16_downmix(uint16_t *dst, const uint8_t *src, size_t frames) {
+    const int16_t *s = (const int16_t *)src;
+    for (size_t i = 0; i < frames; ++i) {
+        dst[i] = (uint16_t)(((int32_t)s[2 * i] + s[2 * i + 1] + 65536) >> 9);
+    }
+}
+
+static void kernel_u8_mono_dual(uint16_t *dst, const uint8_t *src, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        dst[2 * i] = dst[2 * i + 1] = src[i];
+    }
+}
+
+static void kernel_u8_stereo_pair(uint16_t *dst, const uint8_t *src, size_t frames) {
+    for (size_t i = 0; i < 2 * frames; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+static void kernel_s16_mono_dual(uint16_t *dst, const uint8_t *src, size_t frames) {
+    const int16_t *s = (const int16_t *)src;
+    for (size_t i = 0; i < frames; ++i) {
+        dst[2 * i] = dst[2 * i + 1] = (uint16_t)(((int32_t)s[i] + 32768) >> 8);
+    }
+}
+
+static void kernel_s16_stereo_pair(uint16_t *dst, const uint8_t *src, size_t frames) {
+    const int16_t *s = (const int16_t *)src;
+    for (size_t i = 0; i < 2 * frames; ++i) {
+        dst[i] = (uint16_t)(((int32_t)s[i] + 32768) >> 8);
+    }
+}
+
+// Sample formats past u8/s16. Wide samples are read a byte at a time (24-bit
+// frames and WAV data in general need not be word-aligned, and the M0+
+// faults on unaligned loads) and brought to s24 scale, which keeps every bit
+// that truncation and dither use. G.711 bytes expand through a table.
+enum {
+    SAMPLE_U8 = 0,
+    SAMPLE_S16,
+    SAMPLE_S24,
+    SAMPLE_S32,
+    SAMPLE_F32,
+    SAMPLE_ALAW,
+    SAMPLE_ULAW,
+};
+
+static uint sample_format(const wav_info_t *wav) {
+    if (wav->encoding == WAV_ENCODING_ALAW || wav->encoding == WAV_ENCODING_MULAW) {
+        return wav->encoding == WAV_ENCODING_ALAW ? SAMPLE_ALAW : SAMPLE_ULAW;
+    }
+    if (wav->is_float) {
+        return wav->bits_per_sample == 32 ? SAMPLE_F32 : SAMPLE_U8;
+    }
+    switch (wav->bits_per_sample) {
+    case 16:
+        return SAMPLE_S16;
+    case 24:
+        return SAMPLE_S24;
+    case 32:
+        return SAMPLE_S32;
+    default:
+        return SAMPLE_U8;
+    }
+}
+
+static inline uint sample_bytes(uint fmt) {
+    if (fmt == SAMPLE_U8 || fmt == SAMPLE_ALAW || fmt == SAMPLE_ULAW) {
+        return 1u;
+    }
+    return fmt == SAMPLE_S16 ? 2u : fmt == SAMPLE_S24 ? 3u : 4u;
+}
+
+// IEEE float to s24 scale, truncating towards zero and saturating at +-1.0
+// (NaN plays as silence). The RP2040 has no FPU, so this works on the bits:
+// x * 2^23 is the 24-bit mantissa shifted right by 127 - exponent. With an
+// FPU (RP2350 Arm cores) the scale is an exact power of two and the result
+// is the same.
+static inline int32_t f32_to_s24(uint32_t bits) {
+#if defined(__ARM_FP)
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    float y = x * 8388608.0f;
+    if (y != y) {
+        return 0;
+    }
+    if (y >= 8388607.0f) {
+        return 0x7fffff;
+    }
+    if (y <= -8388607.0f) {
+        return -0x7fffff;
+    }
+    return (int32_t)y;
+#else
+    uint32_t e = (bits >> 23) & 0xffu;
+    int32_t v;
+    if (e == 0xffu && (bits & 0x7fffffu)) {
+        return 0;
+    }
+    if (e >= 127u) {
+        v = 0x7fffff;
+    } else if (e < 127u - 23u) {
+        v = 0;
+    } else {
+        v = (int32_t)(((bits & 0x7fffffu) | 0x800000u) >> (127u - e));
+    }
+    return (bits >> 31) ? -v : v;
+#endif
+}
+
+// One sample in s24 scale; fmt is a constant wherever this sits in a loop.
+static inline int32_t load_s24(const uint8_t *p, uint fmt) {
+    switch (fmt) {
+    case SAMPLE_U8:
+        return ((int32_t)p[0] - 128) * 65536;
+    case SAMPLE_S16:
+        return (int32_t)*(const int16_t *)p * 256;
+    case SAMPLE_S24:
+        return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+    case SAMPLE_S32:
+        // The low byte is below anything an 8-bit level or its dither sees.
+        return (int32_t)(((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24)) >> 8;
+    case SAMPLE_ALAW:
+        return (int32_t)g711_alaw_to_s16[p[0]] * 256;
+    case SAMPLE_ULAW:
+        return (int32_t)g711_ulaw_to_s16[p[0]] * 256;
+    default:
+        return f32_to_s24((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+                          ((uint32_t)p[3] << 24));
+    }
+}
+
+// Truncated level of one sample. For integer formats that is the top byte
+// with its sign flipped, so the lower bytes are never read; G.711 has its
+// own level tables.
+static inline uint16_t load_level(const uint8_t *p, uint fmt) {
+    if (fmt == SAMPLE_ALAW) {
+        return g711_alaw_to_level[p[0]];
+    }
+    if (fmt == SAMPLE_ULAW) {
+        return g711_ulaw_to_level[p[0]];
+    }
+    if (fmt == SAMPLE_S24 || fmt == SAMPLE_S32) {
+        return (uint16_t)(p[fmt == SAMPLE_S24 ? 2 : 3] ^ 0x80u);
+    }
+    return (uint16_t)((load_s24(p, fmt) + 0x800000) >> 16);
+}
+
+// Refill for s24/s32/f32 and G.711 sources in every channel layout, with the same
+// rounding as the s16 kernels: mono truncates, downmix halves the full
+// precision sum, then truncates.
+static inline void convert_wide(uint16_t *dst, const uint8_t *src, size_t frames, uint fmt, uint in,
+                                bool stereo_output) {
+    uint bytes = sample_bytes(fmt);
+    if (stereo_output) {
+        for (size_t i = 0; i < frames; ++i) {
+            dst[2 * i] = load_level(src + i * in * bytes, fmt);
+            dst[2 * i + 1] = in == 2 ? load_level(src + (2 * i + 1) * bytes, fmt) : dst[2 * i];
         }
+    } else if (in == 2) {
+        for (size_t i = 0; i < frames; ++i) {
+            int32_t sum = load_s24(src + 2 * i * bytes, fmt) + load_s24(src + (2 * i + 1) * bytes, fmt);
+            dst[i] = (uint16_t)((sum + 0x1000000) >> 17);
+        }
+    } else {
+        for (size_t i = 0; i < frames; ++i) {
+            dst[i] = load_level(src + i * bytes, fmt);
+        }
+    }
+}
 
-        uint16_t level = 128;
-        if (player->wav.bits_per_sample == 8) {
-            level = player->cursor[0];
-        } else {
-            const int16_t *s = (const int16_t *)player->cursor;
-            level = (uint16_t)(((int32_t)*s + 32768) >> 8);
+static void kernel_s24_mono(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_S24, 1, false);
+}
+
+static void kernel_s24_downmix(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_S24, 2, false);
+}
+
+static void kernel_s24_mono_dual(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_S24, 1, true);
+}
+
+static void kernel_s24_stereo_pair(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_S24, 2, true);
+}
+
+static void kernel_s32_mono(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_S32, 1, false);
+}
+
+static void kernel_s32_downmix(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_S32, 2, false);
+}
+
+static void kernel_s32_mono_dual(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_S32, 1, true);
+}
+
+static void kernel_s32_stereo_pair(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_S32, 2, true);
+}
+
+static void kernel_f32_mono(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_F32, 1, false);
+}
+
+static void kernel_f32_downmix(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_F32, 2, false);
+}
+
+static void kernel_f32_mono_dual(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_F32, 1, true);
+}
+
+static void kernel_f32_stereo_pair(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_F32, 2, true);
+}
+
+static void kernel_alaw_mono(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_ALAW, 1, false);
+}
+
+static void kernel_alaw_downmix(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_ALAW, 2, false);
+}
+
+static void kernel_alaw_mono_dual(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_ALAW, 1, true);
+}
+
+static void kernel_alaw_stereo_pair(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_ALAW, 2, true);
+}
+
+static void kernel_ulaw_mono(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_ULAW, 1, false);
+}
+
+static void kernel_ulaw_downmix(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_ULAW, 2, false);
+}
+
+static void kernel_ulaw_mono_dual(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_ULAW, 1, true);
+}
+
+static void kernel_ulaw_stereo_pair(uint16_t *dst, const uint8_t *src, size_t frames) {
+    convert_wide(dst, src, frames, SAMPLE_ULAW, 2, true);
+}
+
+// Dithered requantization works on levels in 1/512 LSB units, which holds
+// a 16-bit sample (x2) and the (L+R) downmix sum alike without rounding.
+#define DITHER_SEED 0x2545f491u
+#define DITHER_ERR_LIMIT 2048
+
+// xorshift32; one step supplies both 9-bit uniforms of a TPDF sample.
+static inline uint32_t dither_next(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Quantizes x (0..131071) to a level with TPDF dither r and order-th error
+// feedback through err. The error is bounded so clipping cannot wind it up.
+static inline uint16_t dither_quantize(int32_t x, uint32_t r, int32_t *err, int order) {
+    int32_t u = x;
+    if (order == 1) {
+        u -= err[0];
+    } else if (order == 2) {
+        u -= 2 * err[0] - err[1];
+    }
+    int32_t d = (int32_t)(r & 0x1ffu) + (int32_t)((r >> 9) & 0x1ffu) - 511;
+    int32_t y = (u + d + 256) >> 9;
+    if (y < 0) {
+        y = 0;
+    } else if (y > 255) {
+        y = 255;
+    }
+    if (order) {
+        int32_t e = y * 512 - u;
+        if (e > DITHER_ERR_LIMIT) {
+            e = DITHER_ERR_LIMIT;
+        } else if (e < -DITHER_ERR_LIMIT) {
+            e = -DITHER_ERR_LIMIT;
         }
+        err[1] = err[0];
+        err[0] = e;
+    }
+    return (uint16_t)y;
+}
 
-        buffer[i] = level;
-        player->cursor += player->frame_stride;
-        player->remaining -= player->frame_stride;
+// Dithered refill for every channel layout; order and fmt are constants in
+// each caller, so the feedback taps compile away where unused. An s24
+// sample is x = (s + 2^23) >> 7 in 1/512 LSB units, exactly 2 * (s16 + 32768)
+// for 16-bit sources.
+static inline void dither_frames(audio_player_t *player, uint16_t *dst, const uint8_t *src, size_t frames, int order,
+                                 uint fmt) {
+    uint bytes = sample_bytes(fmt);
+    uint32_t rng = player->dither_rng;
+    int32_t err[2][2] = {{player->dither_err[0][0], player->dither_err[0][1]},
+                         {player->dither_err[1][0], player->dither_err[1][1]}};
+    uint in = player->wav.channels;
+    if (player->stereo_output) {
+        for (size_t i = 0; i < frames; ++i) {
+            for (uint c = 0; c < 2; ++c) {
+                int32_t x = (load_s24(src + (i * in + (in == 2 ? c : 0)) * bytes, fmt) + 0x800000) >> 7;
+                dst[2 * i + c] = dither_quantize(x, dither_next(&rng), err[c], order);
+            }
+        }
+    } else if (in == 2) {
+        for (size_t i = 0; i < frames; ++i) {
+            int32_t x = (load_s24(src + 2 * i * bytes, fmt) + load_s24(src + (2 * i + 1) * bytes, fmt) + 0x1000000) >> 8;
+            dst[i] = dither_quantize(x, dither_next(&rng), err[0], order);
+        }
+    } else {
+        for (size_t i = 0; i < frames; ++i) {
+            int32_t x = (load_s24(src + i * bytes, fmt) + 0x800000) >> 7;
+            dst[i] = dither_quantize(x, dither_next(&rng), err[0], order);
+        }
+    }
+    player->dither_rng = rng;
+    for (uint c = 0; c < 2; ++c) {
+        player->dither_err[c][0] = err[c][0];
+        player->dither_err[c][1] = err[c][1];
     }
 }
 
-// Refill the buffer that just finished and re-arm its DMA channel.
-static void __isr dma_irq_handler(void) {
-    if (!g_player) {
+// One dither loop per source format, picked outside the loop.
+static inline void dither_any(audio_player_t *player, uint16_t *dst, const uint8_t *src, size_t frames, int order) {
+    switch (player->sample_format) {
+    case SAMPLE_S16:
+        dither_frames(player, dst, src, frames, order, SAMPLE_S16);
+        break;
+    case SAMPLE_S24:
+        dither_frames(player, dst, src, frames, order, SAMPLE_S24);
+        break;
+    case SAMPLE_S32:
+        dither_frames(player, dst, src, frames, order, SAMPLE_S32);
+        break;
+    case SAMPLE_ALAW:
+        dither_frames(player, dst, src, frames, order, SAMPLE_ALAW);
+        break;
+    case SAMPLE_ULAW:
+        dither_frames(player, dst, src, frames, order, SAMPLE_ULAW);
+        break;
+    default:
+        dither_frames(player, dst, src, frames, order, SAMPLE_F32);
+        break;
+    }
+}
+
+static void kernel_tpdf(audio_player_t *player, uint16_t *dst, const uint8_t *src, size_t frames) {
+    dither_any(player, dst, src, frames, 0);
+}
+
+static void kernel_shaped1(audio_player_t *player, uint16_t *dst, const uint8_t *src, size_t frames) {
+    dither_any(player, dst, src, frames, 1);
+}
+
+static void kernel_shaped2(audio_player_t *player, uint16_t *dst, const uint8_t *src, size_t frames) {
+    dither_any(player, dst, src, frames, 2);
+}
+
+// Kernels by sample format, then [channels - 1][stereo_output].
+static const audio_kernel_t kernels[][2][2] = {
+    [SAMPLE_U8] = {{kernel_u8_mono, kernel_u8_mono_dual}, {kernel_u8_downmix, kernel_u8_stereo_pair}},
+    [SAMPLE_S16] = {{kernel_s16_mono, kernel_s16_mono_dual}, {kernel_s16_downmix, kernel_s16_stereo_pair}},
+    [SAMPLE_S24] = {{kernel_s24_mono, kernel_s24_mono_dual}, {kernel_s24_downmix, kernel_s24_stereo_pair}},
+    [SAMPLE_S32] = {{kernel_s32_mono, kernel_s32_mono_dual}, {kernel_s32_downmix, kernel_s32_stereo_pair}},
+    [SAMPLE_F32] = {{kernel_f32_mono, kernel_f32_mono_dual}, {kernel_f32_downmix, kernel_f32_stereo_pair}},
+    [SAMPLE_ALAW] = {{kernel_alaw_mono, kernel_alaw_mono_dual}, {kernel_alaw_downmix, kernel_alaw_stereo_pair}},
+    [SAMPLE_ULAW] = {{kernel_ulaw_mono, kernel_ulaw_mono_dual}, {kernel_ulaw_downmix, kernel_ulaw_stereo_pair}},
+};
+
+static audio_kernel_t select_kernel(const wav_info_t *wav, bool stereo_output) {
+    uint fmt = sample_format(wav);
+    if (wav->channels < 1 || wav->channels > 2 || wav->bits_per_sample != sample_bytes(fmt) * 8u ||
+        wav->is_float != (fmt == SAMPLE_F32)) {
+        return NULL;
+    }
+    return kernels[fmt][wav->channels - 1][stereo_output];
+}
+
+static audio_dither_kernel_t select_dither_kernel(uint fmt, audio_pwm_dma_dither_t dither) {
+    if (fmt == SAMPLE_U8) {
+        return NULL;
+    }
+    switch (dither) {
+    case AUDIO_PWM_DMA_DITHER_TPDF:
+        return kernel_tpdf;
+    case AUDIO_PWM_DMA_DITHER_SHAPED1:
+        return kernel_shaped1;
+    case AUDIO_PWM_DMA_DITHER_SHAPED2:
+        return kernel_shaped2;
+    default:
+        return NULL;
+    }
+}
+
+static uint output_channels(const audio_player_t *player) {
+    return player->stereo_output ? 2u : 1u;
+}
+
+// Compressed sources are decoded into player->decoded; the rest are read in
+// place by the kernels.
+static bool is_decoded(const wav_info_t *wav) {
+    return wav->encoding == WAV_ENCODING_IMA_ADPCM || wav->encoding == WAV_ENCODING_QOA;
+}
+
+// Mixer, ring and source players play a stream rather than a clip.
+static bool is_stream(const audio_player_t *player) {
+    return player->mixer || player->ring || (player->source.ops && !is_decoded(&player->wav));
+}
+
+static const int16_t ring_silence[AUDIO_PWM_DMA_DECODE_FRAMES * 2];
+
+// Hands the ring span the kernels have read back to the producer and takes
+// the next one, at most AUDIO_PWM_DMA_DECODE_FRAMES long so the player holds
+// no more of the ring than a decoder would. An empty ring plays that much
+// silence, unless it is closed: then the stream ends.
+static void next_ring_span(audio_player_t *player) {
+    audio_ring_t *ring = player->ring;
+    if (player->ring_span && player->ring_span != ring_silence) {
+        audio_ring_consume(ring, player->decoded_len);
+    }
+    size_t n;
+    const int16_t *span = audio_ring_read_span(ring, &n);
+    if (n > AUDIO_PWM_DMA_DECODE_FRAMES) {
+        n = AUDIO_PWM_DMA_DECODE_FRAMES;
+    }
+    if (n == 0 && !audio_ring_ended(ring)) {
+        span = ring_silence;
+        n = AUDIO_PWM_DMA_DECODE_FRAMES;
+        // The consumer is the only writer, so no read-modify-write is needed.
+        uint32_t starved = atomic_load_explicit(&ring->starved, memory_order_relaxed);
+        atomic_store_explicit(&ring->starved, starved + (uint32_t)n, memory_order_relaxed);
+    }
+    player->ring_span = n ? span : NULL;
+    player->decoded_len = (uint16_t)n;
+    player->decoded_pos = 0;
+}
+
+// Hands out up to want source frames in the kernels' format and advances
+// past them: straight from the WAV data or a ring span, or from the decode
+// buffer, which the player's source refills once it is used up. Returns
+// NULL at the end of the data; a mixer has no end, a ring ends once closed
+// and read.
+static const uint8_t *next_frames(audio_player_t *player, size_t want, size_t *got) {
+    size_t n;
+    const uint8_t *p;
+    if (player->ring) {
+        if (player->decoded_pos == player->decoded_len) {
+            next_ring_span(player);
+        }
+        n = (size_t)(player->decoded_len - player->decoded_pos);
+        if (n > want) {
+            n = want;
+        }
+        p = n ? (const uint8_t *)(player->ring_span + (size_t)player->decoded_pos * player->wav.channels) : NULL;
+        player->decoded_pos = (uint16_t)(player->decoded_pos + n);
+    } else if (!player->source.ops) {
+        n = player->remaining / player->frame_stride;
+        if (n > want) {
+            n = want;
+        }
+        p = player->cursor;
+        player->cursor += n * player->frame_stride;
+        player->remaining -= n * player->frame_stride;
+    } else {
+        if (player->decoded_pos == player->decoded_len) {
+            const audio_source_t *source = &player->source;
+            size_t decoded = source->ops->read_u8
+                                 ? source->ops->read_u8(source->ctx, (uint8_t *)player->decoded,
+                                                        AUDIO_PWM_DMA_DECODE_FRAMES)
+                                 : source->ops->read_frames(source->ctx, player->decoded, AUDIO_PWM_DMA_DECODE_FRAMES);
+            player->decoded_len = (uint16_t)decoded;
+            player->decoded_pos = 0;
+        }
+        n = (size_t)(player->decoded_len - player->decoded_pos);
+        if (n > want) {
+            n = want;
+        }
+        p = (const uint8_t *)player->decoded + (size_t)player->decoded_pos * player->frame_stride;
+        player->decoded_pos = (uint16_t)(player->decoded_pos + n);
+    }
+    *got = n;
+    return n ? p : NULL;
+}
+
+// Sigma-delta modulator state works in 1/1024 level units. SD_MARGIN levels
+// stay free at each end: second-order error feedback adds up to 1.5 levels
+// to the input, so a full-scale sample never reaches the quantizer's clamp.
+#define SD_FRAC_BITS 10
+#define SD_MARGIN 2
+#define SD_ERR_LIMIT (2 << SD_FRAC_BITS)
+
+// Next modulator input per output channel, s16 scale: the next frame, then
+// the end-of-stream ramp from the last frame to zero, then zero.
+static void sd_next_input(audio_player_t *player, int32_t *in) {
+    size_t got;
+    const uint8_t *p = player->done ? NULL : next_frames(player, 1, &got);
+    if (p) {
+        int32_t v[2] = {0, 0};
+        uint bytes = sample_bytes(player->sample_format);
+        for (uint c = 0; c < player->wav.channels; ++c) {
+            v[c] = load_s24(p + c * bytes, player->sample_format) >> 8;
+        }
+        if (player->stereo_output) {
+            in[0] = v[0];
+            in[1] = player->wav.channels == 2 ? v[1] : v[0];
+        } else {
+            in[0] = player->wav.channels == 2 ? (v[0] + v[1]) >> 1 : v[0];
+            in[1] = in[0];
+        }
+        player->sd_last[0] = in[0];
+        player->sd_last[1] = in[1];
         return;
     }
 
-    uint32_t status = dma_hw->ints0;
-    if (status & (1u << g_player->dma_chan_a)) {
-        dma_hw->ints0 = 1u << g_player->dma_chan_a;
-        fill_dma_buffer(g_player, dma_samples_a, DMA_SAMPLES);
-        dma_channel_set_read_addr(g_player->dma_chan_a, dma_samples_a, false);
-        dma_channel_set_trans_count(g_player->dma_chan_a, DMA_SAMPLES, false);
+    player->done = true;
+    int32_t left = 0;
+    if (player->ramp_pos < AUDIO_PWM_DMA_RAMP_SAMPLES) {
+        player->ramp_pos++;
+        left = AUDIO_PWM_DMA_RAMP_SAMPLES - player->ramp_pos;
     }
-    if (status & (1u << g_player->dma_chan_b)) {
-        dma_hw->ints0 = 1u << g_player->dma_chan_b;
-        fill_dma_buffer(g_player, dma_samples_b, DMA_SAMPLES);
-        dma_channel_set_read_addr(g_player->dma_chan_b, dma_samples_b, false);
-        dma_channel_set_trans_count(g_player->dma_chan_b, DMA_SAMPLES, false);
+    for (uint c = 0; c < 2; ++c) {
+        in[c] = player->sd_last[c] * left / AUDIO_PWM_DMA_RAMP_SAMPLES;
     }
 }
 
-// Initialize PWM output, pacing PWM, and chained DMA channels.
-bool audio_pwm_dma_init(audio_player_t *player, const wav_info_t *wav, uint gpio) {
-    if (!player || !wav) {
-        return false;
+// Second-order sigma-delta refill: each source frame is linearly
+// interpolated over oversample steps and requantized to sd_levels with
+// (1 - z^-1)^2 error feedback, which pushes the quantization noise far above
+// the audio band. count is in levels per channel at the carrier rate.
+static void fill_sigma_delta(audio_player_t *player, uint16_t *buffer, size_t count) {
+    uint channels = output_channels(player);
+    uint shift = (uint)__builtin_ctz(player->oversample);
+    int32_t top = player->sd_levels;
+    int32_t mid = top << (SD_FRAC_BITS - 1);
+    int32_t span = top - 2 * SD_MARGIN;
+
+    for (size_t i = 0; i < (count >> shift); ++i) {
+        int32_t in[2];
+        sd_next_input(player, in);
+        for (uint c = 0; c < channels; ++c) {
+            // s16 full scale maps onto span levels: s * span * 1024 / 65536.
+            int32_t from = mid + ((player->sd_prev[c] * span) >> 6);
+            int32_t to = mid + ((in[c] * span) >> 6);
+            int32_t acc = from << shift;
+            int32_t e1 = player->sd_err[c][0], e2 = player->sd_err[c][1];
+            uint16_t *dst = buffer + ((i << shift) * channels) + c;
+            for (uint k = 0; k < player->oversample; ++k) {
+                acc += to - from;
+                int32_t u = (acc >> shift) - 2 * e1 + e2;
+                int32_t y = (u + (1 << (SD_FRAC_BITS - 1))) >> SD_FRAC_BITS;
+                if (y < 0) {
+                    y = 0;
+                } else if (y > top) {
+                    y = top;
+                }
+                int32_t e = (y << SD_FRAC_BITS) - u;
+                if (e > SD_ERR_LIMIT) {
+                    e = SD_ERR_LIMIT;
+                } else if (e < -SD_ERR_LIMIT) {
+                    e = -SD_ERR_LIMIT;
+                }
+                e2 = e1;
+                e1 = e;
+                dst[k * channels] = (uint16_t)y;
+            }
+            player->sd_err[c][0] = e1;
+            player->sd_err[c][1] = e2;
+            player->sd_prev[c] = in[c];
+        }
     }
+}
 
-    *player = (audio_player_t){
-        .wav = *wav,
-        .cursor = wav->data,
-        .remaining = wav->data_size,
-        .frame_stride = (uint16_t)((wav->bits_per_sample / 8) * wav->channels),
-        .gpio = gpio,
-        .done = false,
-    };
+// Pad the rest of a buffer with the idle midpoint once the data has run out.
+static void fill_silence(uint16_t *dst, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = 128;
+    }
+}
 
-    if (player->frame_stride == 0) {
-        return false;
+// Linear ramp from the last played levels to the idle midpoint, so stopping
+// the PWM output does not click. Returns the number of frames written.
+static size_t fill_ramp(audio_player_t *player, uint16_t *dst, size_t frames) {
+    uint channels = output_channels(player);
+    size_t n = 0;
+    while (n < frames && player->ramp_pos < AUDIO_PWM_DMA_RAMP_SAMPLES) {
+        player->ramp_pos++;
+        for (uint c = 0; c < channels; ++c) {
+            int32_t delta = (int32_t)player->ramp_from[c] - 128;
+            dst[n * channels + c] = (uint16_t)(128 + delta * (AUDIO_PWM_DMA_RAMP_SAMPLES - player->ramp_pos) /
+                                                         AUDIO_PWM_DMA_RAMP_SAMPLES);
+        }
+        ++n;
+    }
+    return n;
+}
+
+static void convert_frames(audio_player_t *player, uint16_t *dst, const uint8_t *src, size_t frames) {
+    if (player->dither_kernel) {
+        player->dither_kernel(player, dst, src, frames);
+    } else {
+        player->kernel(dst, src, frames);
+    }
+}
+
+// Convert WAV samples into 8-bit PWM levels for DMA streaming. The kernel
+// runs over whole frames: one run per refill for PCM (the end of data is
+// located once), one per decoded run for compressed sources. After EOF the
+// buffer gets the ramp to midpoint followed by silence. count is in output
+// frames, which are level pairs in stereo output mode.
+static void fill_dma_buffer(audio_player_t *player, uint16_t *buffer, size_t count) {
+    if (player->oversample > 1) {
+        fill_sigma_delta(player, buffer, count);
+        return;
     }
+    uint channels = output_channels(player);
+    size_t frames = 0;
+    if (!player->done) {
+        size_t got;
+        const uint8_t *src;
+        while (frames < count && (src = next_frames(player, count - frames, &got)) != NULL) {
+            convert_frames(player, buffer + frames * channels, src, got);
+            frames += got;
+        }
+        if (frames) {
+            for (uint c = 0; c < channels; ++c) {
+                player->last_level[c] = buffer[(frames - 1) * channels + c];
+            }
+        }
+        if (frames < count) {
+            player->done = true;
+            player->ramp_from[0] = player->last_level[0];
+            player->ramp_from[1] = player->last_level[1];
+        }
+    }
+
+    if (frames < count) {
+        size_t ramp = fill_ramp(player, buffer + frames * channels, count - frames);
+        fill_silence(buffer + (frames + ramp) * channels, (count - frames - ramp) * channels);
+    }
+}
+
+void audio_pwm_dma_fill(audio_player_t *player, uint16_t *buffer, size_t count) {
+    fill_dma_buffer(player, buffer, count);
+}
+
+static bool pipelined(const audio_player_t *player) {
+    return player->pipeline && !player->zero_copy;
+}
+
+// Keeps core 1 off the stream: clears pipe_run, then waits out a buffer it
+// is filling. Core 1 raises pipe_busy before it reads pipe_run and this
+// reads pipe_busy after clearing it (both sequentially consistent), so one
+// of the two always sees the other.
+static void pipeline_stop(audio_player_t *player) {
+    if (!player->pipeline) {
+        return;
+    }
+    atomic_store(&player->pipe_run, false);
+    while (atomic_load(&player->pipe_busy)) {
+        tight_loop_contents();
+    }
+}
+
+// Converts a sample count into microseconds at the achieved pacing rate.
+static uint64_t pace_samples_to_us(const audio_player_t *player, uint64_t samples) {
+    return (samples * 1000000000u) / player->pace_rate_millihz;
+}
+
+// Samples paced in us microseconds, rounded down. Whole seconds and the
+// rest are scaled apart: us * rate alone would pass 2^64 after a few hours
+// at sigma-delta carrier rates, and players of streams run indefinitely.
+static uint64_t pace_us_to_samples(const audio_player_t *player, uint64_t us) {
+    uint64_t rate = player->pace_rate_millihz;
+    return ((us / 1000000u) * rate + (us % 1000000u) * rate / 1000000u) / 1000u;
+}
 
-    init_audio_pwm(gpio, &player->slice_num, &player->pwm_channel);
-    player->pace_slice = pick_pace_slice(player->slice_num);
-    init_pace_pwm(wav->sample_rate, player->pace_slice);
+// Clear EN on both channels before aborting, so neither can chain-trigger
+// the other on the way down.
+static void halt_dma(audio_player_t *player) {
+    uint chans[2] = {player->dma_chan_a, player->dma_chan_b};
+    for (int i = 0; i < 2; ++i) {
+        dma_channel_set_irq0_enabled(chans[i], false);
+        dma_channel_config cfg = dma_get_channel_config(chans[i]);
+        channel_config_set_enable(&cfg, false);
+        dma_channel_set_config(chans[i], &cfg, false);
+    }
+    for (int i = 0; i < 2; ++i) {
+        dma_channel_abort(chans[i]);
+        dma_channel_acknowledge_irq0(chans[i]);
+    }
+}
 
-    player->dma_chan_a = dma_claim_unused_channel(true);
-    player->dma_chan_b = dma_claim_unused_channel(true);
+// End of stream: stop both channels, their IRQs and the pacing DREQ, park
+// the pin at midpoint, then tell whoever is waiting. DMA_IRQ_0 itself stays
+// enabled since other players share it.
+static void finish_playback(audio_player_t *player, bool notify) {
+    pipeline_stop(player);
+    halt_dma(player);
+    if (player->zero_copy_alarm > 0) {
+        cancel_alarm(player->zero_copy_alarm);
+        player->zero_copy_alarm = 0;
+    }
+    if (player->pace_timer >= 0) {
+        dma_timer_set_fraction((uint)player->pace_timer, 0, 0);
+    } else if (player->pace_slice != player->slice_num) {
+        pwm_set_enabled(player->pace_slice, false);
+    }
+    pwm_set_both_levels(player->slice_num, player->level_mid, player->level_mid);
+    player->state = AUDIO_PLAYER_IDLE;
+    player->halted = true;
 
-    fill_dma_buffer(player, dma_samples_a, DMA_SAMPLES);
-    fill_dma_buffer(player, dma_samples_b, DMA_SAMPLES);
+    if (notify) {
+        if (player->on_done) {
+            player->on_done(player, player->on_done_data);
+        }
+        __sev();
+    }
+}
 
-    // Point DMA at the correct half-word (A/B) of the PWM CC register.
-    uint16_t *cc_half = ((uint16_t *)&pwm_hw->slice[player->slice_num].cc) + player->pwm_channel;
+// Plays the zero-copy ramp out of player->ramp on channel A; its completion
+// IRQ then finishes playback.
+static void start_zero_copy_ramp(audio_player_t *player) {
+    player->ramp_from[0] = player->zero_copy_level;
+    player->ramp_pos = 0;
+    fill_ramp(player, player->ramp, AUDIO_PWM_DMA_RAMP_SAMPLES);
 
-    // Configure both DMA channels with identical settings, chained A->B and B->A.
     dma_channel_config cfg = dma_channel_get_default_config(player->dma_chan_a);
     channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
     channel_config_set_read_increment(&cfg, true);
     channel_config_set_write_increment(&cfg, false);
-    channel_config_set_dreq(&cfg, DREQ_PWM_WRAP0 + player->pace_slice);
+    channel_config_set_dreq(&cfg, player->pace_dreq);
+    dma_channel_configure(
+        player->dma_chan_a,
+        &cfg,
+        player->cc_half,
+        player->ramp,
+        AUDIO_PWM_DMA_RAMP_SAMPLES,
+        false);
 
+    player->state = AUDIO_PLAYER_DRAINING;
+    dma_channel_set_irq0_enabled(player->dma_chan_a, true);
+    dma_channel_start(player->dma_chan_a);
+}
+
+// Zero-copy end of stream: both channels stop on their transfer counts, so
+// the pin holds the last sample however late this runs. An alarm aimed half
+// a sample after the last byte starts the ramp; a shot that finds the
+// channels still running re-aims from channel B's count, so timing drift
+// never accumulates.
+static int64_t zero_copy_alarm(alarm_id_t id, void *user_data) {
+    (void)id;
+    audio_player_t *player = user_data;
+    if (dma_channel_is_busy(player->dma_chan_a) || dma_channel_is_busy(player->dma_chan_b)) {
+        uint32_t left = dma_channel_hw_addr(player->dma_chan_b)->transfer_count;
+        int64_t us = (int64_t)pace_samples_to_us(player, (uint64_t)left * 2u + 1u) / 2;
+        return us > 0 ? us : 1;
+    }
+
+    player->zero_copy_alarm = 0;
+    halt_dma(player);
+    player->cursor = player->wav.data + player->wav.data_size;
+    player->remaining = 0;
+    player->done = true;
+    start_zero_copy_ramp(player);
+    return 0;
+}
+
+// Zero-copy u8 mono: on each pacing DREQ, channel B copies a RAM staging
+// half-word into the PWM CC half-word, and channel A moves the next PCM byte
+// from the XIP-mapped WAV data into the staging half-word's low byte. The
+// staging step is needed because narrow writes to the PWM block are
+// replicated across byte lanes, so a byte written straight to CC would read
+// back as 0xVVVV. B is high priority, so it always takes the byte A staged a
+// sample earlier, however long A's flash read takes. Start stages the first
+// byte and gives each channel its count, so the hardware stops at the end of
+// the data on its own. No buffers and no per-block IRQ.
+static void arm_zero_copy_dma(audio_player_t *player) {
+    player->zero_copy_level = 128;
+
+    dma_channel_config cfg = dma_channel_get_default_config(player->dma_chan_a);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, player->pace_dreq);
+    dma_channel_configure(
+        player->dma_chan_a,
+        &cfg,
+        &player->zero_copy_level,
+        player->wav.data,
+        0,
+        false);
+
+    cfg = dma_channel_get_default_config(player->dma_chan_b);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, player->pace_dreq);
+    channel_config_set_high_priority(&cfg, true);
+    dma_channel_configure(
+        player->dma_chan_b,
+        &cfg,
+        player->cc_half,
+        &player->zero_copy_level,
+        0,
+        false);
+}
+
+// Stages the first byte from the cursor, which audio_pwm_dma_seek() may
+// have moved since arming, and starts both channels on the same DREQ: B
+// plays every byte left, A loads all but the staged one.
+static void start_zero_copy_dma(audio_player_t *player) {
+    size_t left = player->remaining;
+    if (left == 0) {
+        return;
+    }
+    player->zero_copy_level = player->cursor[0];
+    dma_channel_set_read_addr(player->dma_chan_a, player->cursor + 1, false);
+    dma_channel_set_trans_count(player->dma_chan_a, (uint32_t)(left - 1u), false);
+    dma_channel_set_trans_count(player->dma_chan_b, (uint32_t)left, false);
+    dma_start_channel_mask((left > 1u ? 1u << player->dma_chan_a : 0u) | 1u << player->dma_chan_b);
+}
+
+static uint16_t *ring_buffer(const audio_player_t *player, uint index) {
+    return player->buffers + (size_t)index * player->buffer_samples * output_channels(player);
+}
+
+// Mixer frame after the last one handed to the kernels: the render count
+// less the frames still waiting in decoded.
+static uint64_t mixer_frames_used(const audio_player_t *player) {
+    return player->mixer->frames_mixed - (uint64_t)(player->decoded_len - player->decoded_pos);
+}
+
+// Refill the ring buffer that will play as sequence number seq. The buffer
+// whose refill completes the end-of-stream ramp is the drain buffer:
+// playback stops once it has played out.
+static void refill_ring_buffer(audio_player_t *player, uint64_t seq) {
+    uint index = (uint)(seq & (player->buffer_count - 1u));
+    if (player->mixer) {
+        player->ring_mix_frame[index] = mixer_frames_used(player);
+    }
+    fill_dma_buffer(player, ring_buffer(player, index), player->buffer_samples);
+    if (player->done) {
+        player->state = AUDIO_PLAYER_DRAINING;
+        if (player->ramp_pos == AUDIO_PWM_DMA_RAMP_SAMPLES && player->drain_seq < 0) {
+            player->drain_seq = (int64_t)seq;
+        }
+    }
+}
+
+// Hands a ring filled on this core to core 1, which goes on from the next
+// sequence once started.
+static void pipeline_publish(audio_player_t *player) {
+    if (!pipelined(player)) {
+        return;
+    }
+    player->pipe_next = player->buffer_count;
+    player->pipe_seen = player->buffer_count;
+    atomic_store(&player->pipe_filled, player->buffer_count);
+    atomic_store(&player->pipe_drain, player->drain_seq >= 0 ? (uint32_t)player->drain_seq + 1u : 0u);
+    atomic_store(&player->pipe_done, 0);
+}
+
+// Buffered playback runs a ring of buffer_count buffers. dma_chan_a streams
+// one buffer into the CC half-word, then chains dma_chan_b, which reads the
+// next address from ring_list (read ring wrap, hence the power-of-two count
+// and the list alignment) into dma_chan_a's READ_ADDR trigger alias. The CPU
+// never re-arms a channel; it only refills buffers behind the read position.
+static void arm_ring_dma(audio_player_t *player) {
+    for (uint i = 0; i < player->buffer_count; ++i) {
+        player->ring_list[i] = (uint32_t)(uintptr_t)ring_buffer(player, i);
+        refill_ring_buffer(player, i);
+    }
+    player->refill_seq = 0;
+    pipeline_publish(player);
+
+    // Stereo output writes each A/B pair to the whole CC register in one
+    // 32-bit transfer, so it costs the same DMA bandwidth as mono.
+    volatile void *cc = player->cc_half;
+    enum dma_channel_transfer_size size = DMA_SIZE_16;
+    if (player->stereo_output) {
+        cc = &pwm_hw->slice[player->slice_num].cc;
+        size = DMA_SIZE_32;
+    }
+
+    dma_channel_config cfg = dma_channel_get_default_config(player->dma_chan_a);
+    channel_config_set_transfer_data_size(&cfg, size);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, player->pace_dreq);
     channel_config_set_chain_to(&cfg, player->dma_chan_b);
     dma_channel_configure(
         player->dma_chan_a,
         &cfg,
-        cc_half,
-        dma_samples_a,
-        DMA_SAMPLES,
+        cc,
+        ring_buffer(player, 0),
+        player->buffer_samples,
         false);
 
-    channel_config_set_chain_to(&cfg, player->dma_chan_a);
+    cfg = dma_channel_get_default_config(player->dma_chan_b);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_ring(&cfg, false, (uint)__builtin_ctz(player->buffer_count * sizeof(player->ring_list[0])));
     dma_channel_configure(
         player->dma_chan_b,
         &cfg,
-        cc_half,
-        dma_samples_b,
-        DMA_SAMPLES,
+        &dma_hw->ch[player->dma_chan_a].al3_read_addr_trig,
+        player->ring_list,
+        1,
         false);
 
-    g_player = player;
     dma_channel_set_irq0_enabled(player->dma_chan_a, true);
-    dma_channel_set_irq0_enabled(player->dma_chan_b, true);
+}
+
+// Index of the ring buffer dma_chan_a is playing: the control channel's read
+// pointer is already one entry past it. Read just as a buffer ends, before
+// the control channel has run, this lags by one, which only delays a refill.
+static uint ring_playing(const audio_player_t *player) {
+    uintptr_t next = dma_channel_hw_addr(player->dma_chan_b)->read_addr;
+    uint entry = (uint)((next - (uintptr_t)player->ring_list) / sizeof(player->ring_list[0]));
+    return (entry + player->buffer_count - 1u) & (player->buffer_count - 1u);
+}
+
+// Buffers dma_chan_a has finished since start. The ring position gives this
+// modulo buffer_count; elapsed time at the pacing rate (centred half a
+// buffer back, since the first DREQ lags the start) picks the lap, so a
+// service held off for whole laps still counts every buffer.
+static uint64_t ring_buffers_done(const audio_player_t *player) {
+    uint64_t samples = pace_us_to_samples(player, time_us_64() - player->start_us);
+    uint64_t size = player->buffer_samples;
+    uint64_t span = size * player->buffer_count;
+    uint playing = ring_playing(player);
+    int64_t diff = (int64_t)samples - (int64_t)(size / 2u) - (int64_t)(playing * size);
+    uint64_t laps = diff > 0 ? ((uint64_t)diff + span / 2u) / span : 0;
+    return playing + laps * player->buffer_count;
+}
+
+// Refill every buffer that has finished since the last service; one IRQ can
+// stand for several if the ISR was held off. If the data channel has already
+// restarted buffers that were never refilled, those count as underruns and
+// the refill skips ahead to the buffers after the one now playing. Returns
+// true once the drain buffer has played out.
+static bool service_ring(audio_player_t *player, uint32_t *refills, uint32_t *underruns) {
+    uint64_t done = ring_buffers_done(player);
+    player->buffers_done = done;
+    if (player->drain_seq >= 0 && done > (uint64_t)player->drain_seq) {
+        return true;
+    }
+
+    uint64_t filled_end = player->refill_seq + player->buffer_count;
+    if (done >= filled_end) {
+        *underruns += (uint32_t)(done - filled_end + 1u);
+        player->refill_seq = done + 1u - player->buffer_count;
+    }
+    while (player->refill_seq < done) {
+        refill_ring_buffer(player, player->refill_seq + player->buffer_count);
+        player->refill_seq++;
+        (*refills)++;
+    }
+    return false;
+}
+
+// Mixer frame under dma_chan_a's read pointer. The ring buffers are laid
+// out in ring order, so the pointer gives the buffer and the offset in it;
+// at the very end of one it is the next one's start. Sigma-delta buffers
+// hold oversample levels per frame.
+static uint64_t ring_read_frame(const audio_player_t *player) {
+    uintptr_t read = dma_channel_hw_addr(player->dma_chan_a)->read_addr;
+    size_t level = (size_t)(read - (uintptr_t)player->buffers) / (sizeof(uint16_t) * output_channels(player));
+    uint index = (uint)(level / player->buffer_samples) & (player->buffer_count - 1u);
+    size_t offset = level % player->buffer_samples;
+    return player->ring_mix_frame[index] + (player->oversample > 1 ? offset / player->oversample : offset);
+}
+
+// Ring levels holding mixer frame, and how many frames of that buffer
+// follow; NULL if no buffer holds it.
+static uint16_t *ring_levels_at(const audio_player_t *player, uint64_t frame, size_t *frames) {
+    for (uint i = 0; i < player->buffer_count; ++i) {
+        uint64_t first = player->ring_mix_frame[i];
+        if (frame >= first && frame - first < player->buffer_samples) {
+            *frames = (size_t)(first + player->buffer_samples - frame);
+            return ring_buffer(player, i) + (size_t)(frame - first) * output_channels(player);
+        }
+    }
+    *frames = 0;
+    return NULL;
+}
+
+// Mixes a voice started back at frame into everything rendered since, in
+// play order and a block at a time, so the first levels are rewritten
+// before the DMA reaches them: queued ring levels, then the frames
+// waiting in decoded.
+static void remix_queued(audio_player_t *player, int voice, uint64_t frame) {
+    audio_mixer_t *mixer = player->mixer;
+    uint64_t used = mixer_frames_used(player);
+    int16_t mixed[AUDIO_MIXER_BLOCK_FRAMES * 2];
+    // Requantizing queued levels must not move the dither on: the next
+    // refill picks up where the frames after them left it.
+    uint32_t rng = player->dither_rng;
+    int32_t err[2][2];
+    memcpy(err, player->dither_err, sizeof(err));
+    while (frame < mixer->frames_mixed) {
+        size_t n = AUDIO_MIXER_BLOCK_FRAMES;
+        if (frame >= used) {
+            n = (size_t)(mixer->frames_mixed - frame) < n ? (size_t)(mixer->frames_mixed - frame) : n;
+            size_t at = player->decoded_pos + (size_t)(frame - used);
+            audio_mixer_remix(mixer, voice, frame, player->decoded + at * mixer->channels, n);
+        } else {
+            size_t span;
+            uint16_t *levels = ring_levels_at(player, frame, &span);
+            if (levels && span < n) {
+                n = span;
+            }
+            n = (size_t)(used - frame) < n ? (size_t)(used - frame) : n;
+            audio_mixer_remix(mixer, voice, frame, mixed, n);
+            if (levels) {
+                convert_frames(player, levels, (const uint8_t *)mixed, n);
+            }
+        }
+        frame += n;
+    }
+    player->dither_rng = rng;
+    memcpy(player->dither_err, err, sizeof(err));
+}
+
+// Core 1's step: fill the next sequence if its buffer has finished playing.
+// If the DMA has already reached it, skip to the one after the buffer
+// playing (the IRQ counts the underrun). The buffer completing the ramp is
+// the drain buffer, after which there is nothing left to do. The release
+// store of pipe_filled orders the levels and pipe_drain before it.
+static bool pipeline_produce(audio_player_t *player) {
+    if (player->drain_seq >= 0) {
+        return false;
+    }
+    uint32_t done = atomic_load_explicit(&player->pipe_done, memory_order_acquire);
+    uint32_t seq = player->pipe_next;
+    if ((int32_t)(seq - done) <= 0) {
+        seq = done + 1u;
+    }
+    if (seq - done >= player->buffer_count) {
+        player->pipe_next = seq;
+        return false;
+    }
+    fill_dma_buffer(player, ring_buffer(player, seq & (player->buffer_count - 1u)), player->buffer_samples);
+    if (player->done && player->ramp_pos == AUDIO_PWM_DMA_RAMP_SAMPLES) {
+        player->drain_seq = seq;
+        atomic_store_explicit(&player->pipe_drain, seq + 1u, memory_order_relaxed);
+    }
+    player->pipe_next = seq + 1u;
+    atomic_store_explicit(&player->pipe_filled, seq + 1u, memory_order_release);
+    return true;
+}
+
+#if AUDIO_PWM_DMA_PIPELINE
+// Core 1's loop: fill while started and there is room, then sleep until
+// the IRQ frees a buffer or core 0 starts, stops or releases it.
+static void pipeline_core1(void) {
+    audio_player_t *player = pipeline_owner;
+    while (!atomic_load(&player->pipe_quit)) {
+        atomic_store(&player->pipe_busy, true);
+        while (atomic_load(&player->pipe_run) && pipeline_produce(player)) {
+        }
+        atomic_store(&player->pipe_busy, false);
+        __wfe();
+    }
+}
+#endif
+
+// The IRQ's side of the pipeline: publish the buffers finished and wake
+// core 1. Buffers that started playing before core 1 had filled them are
+// underruns. Occupancy is only sampled until the drain buffer is known,
+// as core 1 then stops and the ring empties on purpose. Returns true once
+// the drain buffer has played out.
+static bool service_pipeline(audio_player_t *player, uint32_t *refills, uint32_t *underruns, int32_t *queued) {
+    uint64_t done = ring_buffers_done(player);
+    uint32_t filled = atomic_load_explicit(&player->pipe_filled, memory_order_acquire);
+    uint32_t drain = atomic_load_explicit(&player->pipe_drain, memory_order_relaxed);
+    uint32_t started = (uint32_t)(done - player->buffers_done);
+    player->buffers_done = done;
+    *refills = filled - player->pipe_seen;
+    player->pipe_seen = filled;
+    if (drain) {
+        if (player->state == AUDIO_PLAYER_PLAYING) {
+            player->state = AUDIO_PLAYER_DRAINING;
+        }
+        if ((int32_t)((uint32_t)done - drain) >= 0) {
+            return true;
+        }
+    }
+    int32_t ahead = (int32_t)(filled - (uint32_t)done);
+    if (ahead <= 0) {
+        *underruns += (uint32_t)(1 - ahead) < started ? (uint32_t)(1 - ahead) : started;
+    }
+    if (!drain) {
+        *queued = ahead > 0 ? ahead * (int32_t)player->buffer_samples : 0;
+    }
+    atomic_store_explicit(&player->pipe_done, (uint32_t)done, memory_order_release);
+    __sev();
+    return false;
+}
+
+// Publish one service's numbers. Writers bump stats_seq to odd, update, then
+// back to even; audio_pwm_dma_get_stats() retries until it reads a stable
+// even sequence, so neither side ever blocks.
+static void commit_stats(audio_player_t *player, uint32_t refills, uint32_t underruns, uint32_t cycles,
+                         int32_t queued) {
+    player->stats_seq++;
+    __dmb();
+    audio_pwm_dma_stats_t *stats = &player->stats;
+    stats->refills += refills;
+    stats->underruns += underruns;
+    stats->isr_count++;
+    if (cycles > stats->isr_cycles_max) {
+        stats->isr_cycles_max = cycles;
+    }
+    player->isr_cycles_total += cycles;
+    if (queued >= 0) {
+        if (player->queued_count++ == 0 || (uint32_t)queued < stats->queued_min) {
+            stats->queued_min = (uint32_t)queued;
+        }
+        player->queued_total += (uint32_t)queued;
+    }
+    if (player->zero_copy) {
+        stats->samples_played = player->stats_samples_base + (player->done ? player->wav.data_size + AUDIO_PWM_DMA_RAMP_SAMPLES : 0);
+    } else {
+        stats->samples_played =
+            player->stats_samples_base + (player->buffers_done - player->stats_buffers_base) * player->buffer_samples;
+    }
+    __dmb();
+    player->stats_seq++;
+}
+
+// Handle one channel's completion. Zero-copy players only raise an IRQ when
+// their end-of-stream ramp has played; ring players refill, or with the
+// pipeline hand the done buffers back to core 1.
+static void service_channel(audio_player_t *player, uint chan) {
+    uint32_t start = cycle_counter_read();
+    if (!dma_channel_get_irq0_status(chan)) {
+        return;
+    }
+    dma_channel_acknowledge_irq0(chan);
+    if (player->state == AUDIO_PLAYER_IDLE) {
+        return;
+    }
+
+    uint32_t refills = 0;
+    uint32_t underruns = 0;
+    int32_t queued = -1;
+    bool finished = player->zero_copy ||
+                    (player->pipeline ? service_pipeline(player, &refills, &underruns, &queued)
+                                      : service_ring(player, &refills, &underruns));
+    commit_stats(player, refills, underruns, cycle_counter_elapsed(start, cycle_counter_read()), queued);
+    if (finished) {
+        finish_playback(player, true);
+    }
+}
+
+// Shared by every player: hand each pending channel to the player that owns it.
+static void __isr dma_irq_handler(void) {
+    uint32_t pending = dma_hw->ints0;
+    while (pending) {
+        uint chan = (uint)__builtin_ctz(pending);
+        pending &= pending - 1u;
+        if (players_by_chan[chan]) {
+            service_channel(players_by_chan[chan], chan);
+        }
+    }
+}
+
+// Reset the stream cursor and pick the refill kernel for the WAV format.
+// Hardware fields (pins, channels, callback) are left untouched.
+bool audio_pwm_dma_prepare(audio_player_t *player, const wav_info_t *wav) {
+    if (!player || !wav) {
+        return false;
+    }
+
+    player->wav = *wav;
+    player->cursor = wav->data;
+    player->remaining = wav->data_size;
+    // Compressed sources reach the kernels as s16 frames.
+    // A description without data is a stream's (a mixer, ring or source
+    // player's), which keeps its source; a mixer is read as one.
+    wav_info_t pcm = *wav;
+    if (player->mixer) {
+        player->source = audio_mixer_source(player->mixer);
+    } else if (wav->data) {
+        player->source.ops = NULL;
+    }
+    if (wav->encoding == WAV_ENCODING_IMA_ADPCM) {
+        pcm.bits_per_sample = 16;
+        ima_adpcm_init(&player->adpcm, wav->data, wav->data_size, wav->channels, wav->block_align);
+        player->source = (audio_source_t){&audio_source_ima_adpcm_ops, &player->adpcm, wav->sample_rate,
+                                          wav->channels};
+    } else if (wav->encoding == WAV_ENCODING_QOA) {
+        pcm.bits_per_sample = 16;
+        qoa_init(&player->qoa, wav->data, wav->data_size, wav->channels);
+        player->source = (audio_source_t){&audio_source_qoa_ops, &player->qoa, wav->sample_rate, wav->channels};
+    } else if (wav->encoding != WAV_ENCODING_PCM && wav->encoding != WAV_ENCODING_ALAW &&
+               wav->encoding != WAV_ENCODING_MULAW) {
+        return false;
+    }
+    player->decoded_pos = player->decoded_len = 0;
+    player->frame_stride = (uint16_t)((pcm.bits_per_sample / 8) * pcm.channels);
+    player->sample_format = (uint8_t)sample_format(&pcm);
+    player->kernel = select_kernel(&pcm, player->stereo_output);
+    player->dither_kernel = select_dither_kernel(player->sample_format, player->dither);
+    player->dither_rng = DITHER_SEED;
+    memset(player->dither_err, 0, sizeof(player->dither_err));
+    memset(player->sd_prev, 0, sizeof(player->sd_prev));
+    memset(player->sd_last, 0, sizeof(player->sd_last));
+    memset(player->sd_err, 0, sizeof(player->sd_err));
+    player->zero_copy = wav->encoding == WAV_ENCODING_PCM && player->sample_format == SAMPLE_U8 &&
+                        wav->channels == 1 && !player->source.ops && !player->ring && !player->stereo_output &&
+                        player->oversample <= 1;
+    player->last_level[0] = player->last_level[1] = 128;
+    player->ramp_from[0] = player->ramp_from[1] = 128;
+    player->ramp_pos = 0;
+    player->drain_seq = -1;
+    player->done = false;
+    return player->frame_stride != 0 && player->kernel != NULL;
+}
+
+// Program pacing and the DMA chain for the prepared stream, without starting.
+static bool arm_playback(audio_player_t *player) {
+    if (player->pace_timer >= 0) {
+        dma_timer_unclaim((uint)player->pace_timer);
+        player->pace_timer = -1;
+    }
+    if (!init_pacing(player)) {
+        return false;
+    }
+
+    if (player->zero_copy) {
+        arm_zero_copy_dma(player);
+    } else if (player->buffers) {
+        arm_ring_dma(player);
+    } else {
+        return false;
+    }
+    player->halted = false;
+    return true;
+}
+
+audio_pwm_dma_config_t audio_pwm_dma_get_default_config(uint gpio) {
+    return (audio_pwm_dma_config_t){
+        .gpio = gpio,
+        .buffers = NULL,
+        .buffer_count = AUDIO_PWM_DMA_BUFFER_COUNT,
+        .buffer_samples = AUDIO_PWM_DMA_BUFFER_SAMPLES,
+        .stereo = false,
+        .differential = false,
+        .dither = AUDIO_PWM_DMA_DITHER_NONE,
+        .oversample = 1,
+        .mixer = NULL,
+        .ring = NULL,
+        .source = NULL,
+        .pipeline = false,
+    };
+}
+
+// Initialize PWM output, pacing, and chained DMA channels. Claims the output
+// slice, a pacing slice and two DMA channels; fails without side effects if
+// any of them is already taken.
+bool audio_pwm_dma_init_with_config(audio_player_t *player, const wav_info_t *wav,
+                                    const audio_pwm_dma_config_t *config) {
+    if (!player || !config) {
+        return false;
+    }
+    if ((config->mixer != NULL) + (config->ring != NULL) + (config->source != NULL) > 1 ||
+        (config->source && !config->source->ops)) {
+        return false;
+    }
+    audio_source_t source = {0};
+    if (config->mixer) {
+        source = audio_mixer_source(config->mixer);
+    } else if (config->source) {
+        source = *config->source;
+    }
+    wav_info_t streamed;
+    if (source.ops) {
+        streamed = audio_source_output(&source);
+        wav = &streamed;
+    } else if (config->ring) {
+        streamed = audio_ring_output(config->ring);
+        wav = &streamed;
+    }
+    *player = (audio_player_t){
+        .source = source,
+        .mixer = config->mixer,
+        .ring = config->ring,
+        .gpio = config->gpio,
+        .pace_timer = -1,
+        .state = AUDIO_PLAYER_IDLE,
+        .buffers = config->buffers,
+        .buffer_count = config->buffer_count,
+        .buffer_samples = config->buffer_samples,
+        .stereo_output = config->stereo,
+        .differential_output = config->differential,
+        .dither = config->dither,
+        .oversample = config->oversample > 1 ? config->oversample : 1u,
+        .level_mid = 128,
+        .pipeline = config->pipeline,
+    };
+#if !AUDIO_PWM_DMA_ZERO_COPY_ONLY
+    if (!config->buffers) {
+        player->buffers = player->buffer_storage;
+        player->buffer_count = AUDIO_PWM_DMA_BUFFER_COUNT;
+        player->buffer_samples = AUDIO_PWM_DMA_BUFFER_SAMPLES / output_channels(player);
+    }
+#endif
+    if ((config->stereo || config->differential) && pwm_gpio_to_channel(config->gpio) != PWM_CHAN_A) {
+        return false;
+    }
+    if (config->stereo && config->differential) {
+        return false;
+    }
+    if (config->pipeline && (!AUDIO_PWM_DMA_PIPELINE || pipeline_owner)) {
+        return false;
+    }
+    uint osr = player->oversample;
+    if (osr > AUDIO_PWM_DMA_MAX_OVERSAMPLE || (osr & (osr - 1u)) || player->buffer_samples % osr) {
+        return false;
+    }
+    uint count = player->buffer_count;
+    if (count < 2 || count > AUDIO_PWM_DMA_MAX_BUFFERS || (count & (count - 1u)) || player->buffer_samples == 0 ||
+        !audio_pwm_dma_prepare(player, wav)) {
+        return false;
+    }
+
+    uint slice = pwm_gpio_to_slice_num(config->gpio);
+    if (claimed_slices & (1u << slice)) {
+        return false;
+    }
+    int chan_a = dma_claim_unused_channel(false);
+    int chan_b = dma_claim_unused_channel(false);
+    if (chan_a < 0 || chan_b < 0) {
+        if (chan_a >= 0) {
+            dma_channel_unclaim((uint)chan_a);
+        }
+        if (chan_b >= 0) {
+            dma_channel_unclaim((uint)chan_b);
+        }
+        return false;
+    }
+
+    init_audio_pwm(config->gpio, config->stereo || config->differential, config->differential, &player->slice_num,
+                   &player->pwm_channel);
+    player->pace_slice = slice;
+    claimed_slices |= 1u << slice;
+    player->dma_chan_a = (uint)chan_a;
+    player->dma_chan_b = (uint)chan_b;
+    players_by_chan[chan_a] = player;
+    players_by_chan[chan_b] = player;
+
+    // Point DMA at the correct half-word (A/B) of the PWM CC register. The
+    // PWM block replicates a half-word write across the whole register, so
+    // in differential mode every level reaches A and the inverted B in the
+    // same single transfer: the DMA and CPU work are those of single-ended.
+    player->cc_half = ((volatile uint16_t *)&pwm_hw->slice[player->slice_num].cc) + player->pwm_channel;
+
+    cycle_counter_init();
+
+    // Every player installs the same dispatcher, which the SDK allows.
     irq_set_exclusive_handler(DMA_IRQ_0, dma_irq_handler);
     irq_set_priority(DMA_IRQ_0, PICO_HIGHEST_IRQ_PRIORITY);
-    irq_set_enabled(DMA_IRQ_0, true);
 
+    if (!arm_playback(player)) {
+        audio_pwm_dma_deinit(player);
+        return false;
+    }
+#if AUDIO_PWM_DMA_PIPELINE
+    if (player->pipeline) {
+        pipeline_owner = player;
+        multicore_launch_core1(pipeline_core1);
+    }
+#endif
     return true;
 }
 
-// Start the DMA chain; it will run continuously until stopped.
+bool audio_pwm_dma_init(audio_player_t *player, const wav_info_t *wav, uint gpio) {
+    audio_pwm_dma_config_t config = audio_pwm_dma_get_default_config(gpio);
+    return audio_pwm_dma_init_with_config(player, wav, &config);
+}
+
+// Stop playback and release the slices, DMA channels and pacing timer.
+void audio_pwm_dma_deinit(audio_player_t *player) {
+    if (!player || !player->cc_half) {
+        return;
+    }
+    finish_playback(player, false);
+#if AUDIO_PWM_DMA_PIPELINE
+    if (player->pipeline && pipeline_owner == player) {
+        atomic_store(&player->pipe_quit, true);
+        __sev();
+        multicore_reset_core1();
+        pipeline_owner = NULL;
+    }
+#endif
+    pwm_set_enabled(player->slice_num, false);
+    if (player->pace_timer >= 0) {
+        dma_timer_unclaim((uint)player->pace_timer);
+        player->pace_timer = -1;
+    }
+    players_by_chan[player->dma_chan_a] = NULL;
+    players_by_chan[player->dma_chan_b] = NULL;
+    dma_channel_unclaim(player->dma_chan_a);
+    dma_channel_unclaim(player->dma_chan_b);
+    release_pace_slice(player);
+    claimed_slices &= ~(1u << player->slice_num);
+    player->cc_half = NULL;
+}
+
+// Start the DMA chain; it runs until the data and the ramp have played out.
+// A ring starts from its control channel, which loads buffer 0.
 void audio_pwm_dma_start(audio_player_t *player) {
     if (!player) {
         return;
     }
-    dma_channel_start(player->dma_chan_a);
+    player->state = player->done ? AUDIO_PLAYER_DRAINING : AUDIO_PLAYER_PLAYING;
+    player->stats_samples_base = player->stats.samples_played;
+    player->stats_buffers_base = 0;
+    player->buffers_done = 0;
+    player->start_us = time_us_64();
+    irq_set_enabled(DMA_IRQ_0, true);
+    if (pipelined(player)) {
+        atomic_store(&player->pipe_run, atomic_load(&player->pipe_drain) == 0);
+        __sev();
+    }
+    if (!player->zero_copy) {
+        dma_channel_start(player->dma_chan_b);
+    } else {
+        start_zero_copy_dma(player);
+        uint64_t us = pace_samples_to_us(player, (uint64_t)player->remaining * 2u + 1u) / 2u;
+        player->zero_copy_alarm = add_alarm_in_us(us, zero_copy_alarm, player, true);
+    }
+}
+
+// Play another WAV on an initialized player, cutting off anything still playing.
+bool audio_pwm_dma_play(audio_player_t *player, const wav_info_t *wav) {
+    if (!player || is_stream(player)) {
+        return false;
+    }
+    if (player->state != AUDIO_PLAYER_IDLE) {
+        finish_playback(player, false);
+    }
+    if (!audio_pwm_dma_prepare(player, wav) || !arm_playback(player)) {
+        return false;
+    }
+    audio_pwm_dma_start(player);
+    return true;
+}
+
+// Move the source to frame, or to the last point before it the decoder can
+// restart from. Under the IRQ's feet, so interrupts are off while the cursor
+// and decoder change; before start the ring is refilled from the new point,
+// and a finished player, whose DMA and pacing are stopped, is armed again.
+bool audio_pwm_dma_seek(audio_player_t *player, size_t frame, size_t *position) {
+    if (!player || is_stream(player)) {
+        return false;
+    }
+    const wav_info_t *wav = &player->wav;
+    size_t step = 1, bytes = player->frame_stride;
+    if (is_decoded(wav)) {
+        step = wav->samples_per_block;
+        bytes = wav->block_align;
+    }
+    size_t offset = wav->data_size;
+    size_t reached = wav_frame_count(wav);
+    if (frame < reached) {
+        offset = frame / step * bytes;
+        reached = frame / step * step;
+    }
+
+    uint32_t irq_state = save_and_disable_interrupts();
+    bool idle = player->state == AUDIO_PLAYER_IDLE;
+    bool ok = idle || (!player->done && !player->zero_copy && !pipelined(player));
+    if (ok) {
+        player->cursor = wav->data + offset;
+        player->remaining = wav->data_size - offset;
+        if (wav->encoding == WAV_ENCODING_IMA_ADPCM) {
+            ima_adpcm_init(&player->adpcm, player->cursor, player->remaining, wav->channels, wav->block_align);
+        } else if (wav->encoding == WAV_ENCODING_QOA) {
+            qoa_init(&player->qoa, player->cursor, player->remaining, wav->channels);
+        }
+        player->decoded_pos = player->decoded_len = 0;
+    }
+    bool rearm = ok && idle && player->halted;
+    if (ok && idle) {
+        player->done = false;
+        player->ramp_pos = 0;
+        player->drain_seq = -1;
+        if (!rearm && !player->zero_copy && player->buffers) {
+            for (uint i = 0; i < player->buffer_count; ++i) {
+                refill_ring_buffer(player, i);
+            }
+            // A clip shorter than the ring is marked draining; it has not started.
+            player->state = AUDIO_PLAYER_IDLE;
+            pipeline_publish(player);
+        }
+    }
+    restore_interrupts(irq_state);
+    if (rearm) {
+        ok = arm_playback(player);
+        player->state = AUDIO_PLAYER_IDLE;
+    }
+    if (ok && position) {
+        *position = reached;
+    }
+    return ok;
+}
+
+int audio_pwm_dma_trigger(audio_player_t *player, const wav_info_t *wav, uint16_t volume, int16_t pan,
+                          uint32_t *delay) {
+    if (!player || !player->mixer || !player->buffers) {
+        return -1;
+    }
+    audio_mixer_t *mixer = player->mixer;
+    if (pipelined(player)) {
+        // Core 1 owns the ring and the mixer's render position.
+        if (delay) {
+            *delay = player->buffer_count * player->buffer_samples;
+        }
+        return audio_mixer_play(mixer, wav, volume, pan, false);
+    }
+    uint32_t irq = save_and_disable_interrupts();
+    uint64_t read = ring_read_frame(player);
+    uint64_t frame = read + AUDIO_PWM_DMA_TRIGGER_LEAD;
+    int voice;
+    if (player->oversample > 1) {
+        frame = mixer->frames_mixed;
+        voice = audio_mixer_play(mixer, wav, volume, pan, false);
+    } else {
+        voice = audio_mixer_play_at(mixer, wav, volume, pan, false, &frame);
+        if (voice >= 0) {
+            remix_queued(player, voice, frame);
+        }
+    }
+    restore_interrupts(irq);
+    if (delay) {
+        *delay = (uint32_t)(frame - read);
+    }
+    return voice;
+}
+
+void audio_pwm_dma_set_done_callback(audio_player_t *player, audio_done_callback_t callback, void *user_data) {
+    player->on_done = callback;
+    player->on_done_data = user_data;
+}
+
+void audio_pwm_dma_get_stats(const audio_player_t *player, audio_pwm_dma_stats_t *stats) {
+    uint32_t seq;
+    uint64_t cycles_total, queued_total;
+    uint32_t queued_count;
+    do {
+        seq = player->stats_seq;
+        __dmb();
+        *stats = player->stats;
+        cycles_total = player->isr_cycles_total;
+        queued_total = player->queued_total;
+        queued_count = player->queued_count;
+        __dmb();
+    } while ((seq & 1u) || seq != player->stats_seq);
+    stats->isr_cycles_avg = stats->isr_count ? (uint32_t)(cycles_total / stats->isr_count) : 0;
+    stats->queued_avg = queued_count ? (uint32_t)(queued_total / queued_count) : 0;
+}
+
+void audio_pwm_dma_reset_stats(audio_player_t *player) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    player->stats_seq++;
+    __dmb();
+    player->stats = (audio_pwm_dma_stats_t){0};
+    player->isr_cycles_total = 0;
+    player->queued_total = 0;
+    player->queued_count = 0;
+    player->stats_samples_base = 0;
+    player->stats_buffers_base = player->buffers_done;
+    __dmb();
+    player->stats_seq++;
+    restore_interrupts(irq_state);
+}
+
+bool audio_pwm_dma_is_idle(const audio_player_t *player) {
+    return player->state == AUDIO_PLAYER_IDLE;
+}
+
+// Sleep until playback has finished; the end-of-stream IRQ sends an event.
+void audio_pwm_dma_wait(const audio_player_t *player) {
+    while (player->state != AUDIO_PLAYER_IDLE) {
+        __wfe();
+    }
 }
@@ -1,31 +1,355 @@
 #ifndef AUDIO_PWM_DMA_H
 #define AUDIO_PWM_DMA_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#include "pico/time.h"
+#include "audio_mixer.h"
+#include "audio_ring.h"
+#include "audio_source.h"
+#include "ima_adpcm.h"
+#include "qoa.h"
 #include "pico/types.h"
 #include "wav.h"
 
+typedef struct audio_player audio_player_t;
+
+// Converts a run of whole frames from WAV bytes into PWM levels (one per
+// frame, or an A/B pair per frame in stereo output mode).
+typedef void (*audio_kernel_t)(uint16_t *dst, const uint8_t *src, size_t frames);
+
+// Same, for kernels that carry state across refills (dither RNG and error).
+typedef void (*audio_dither_kernel_t)(audio_player_t *player, uint16_t *dst, const uint8_t *src, size_t frames);
+
+// Builds that only play u8 mono (zero-copy) can drop the per-player DMA
+// buffers with AUDIO_PWM_DMA_ZERO_COPY_ONLY=1.
+#ifndef AUDIO_PWM_DMA_ZERO_COPY_ONLY
+#define AUDIO_PWM_DMA_ZERO_COPY_ONLY 0
+#endif
+
+// A player's own DMA ring: count buffers of samples levels each. Four 256
+// sample buffers use the same RAM and queue depth as a 2 x 512 ping-pong but
+// leave three buffers of slack for a late refill instead of one.
+#define AUDIO_PWM_DMA_BUFFER_COUNT 4
+#define AUDIO_PWM_DMA_BUFFER_SAMPLES 256
+
+// Deepest ring; counts must be a power of two from 2 up to this.
+#define AUDIO_PWM_DMA_MAX_BUFFERS 16
+
+// Highest sigma-delta oversampling factor (see audio_pwm_dma_config_t).
+#define AUDIO_PWM_DMA_MAX_OVERSAMPLE 32
+
+// Builds with pico_multicore can refill a player's ring on core 1
+// (audio_pwm_dma_config_t.pipeline) with AUDIO_PWM_DMA_PIPELINE=1.
+#ifndef AUDIO_PWM_DMA_PIPELINE
+#define AUDIO_PWM_DMA_PIPELINE 0
+#endif
+
+// Frames a compressed source is decoded ahead, per player.
+#define AUDIO_PWM_DMA_DECODE_FRAMES 64
+
+// Frames between the DMA read position and where audio_pwm_dma_trigger()
+// starts a voice: the time the first rewritten frames need to be ready.
+#ifndef AUDIO_PWM_DMA_TRIGGER_LEAD
+#define AUDIO_PWM_DMA_TRIGGER_LEAD 4
+#endif
+
+// Samples used to ramp the output back to midpoint after the last frame.
+#define AUDIO_PWM_DMA_RAMP_SAMPLES 64
+
+typedef enum {
+    AUDIO_PLAYER_IDLE = 0,  // DMA, pacing and DMA IRQ stopped; pin parked at midpoint
+    AUDIO_PLAYER_PLAYING,   // streaming WAV data
+    AUDIO_PLAYER_DRAINING,  // data consumed, ramp to midpoint still playing out
+} audio_player_state_t;
+
+// Requantization of 16-bit and wider sources to the 8-bit PWM level.
+// Truncation leaves distortion correlated with the signal, audible on quiet
+// passages. TPDF dither (two summed 1 LSB uniforms) turns it into a
+// constant white noise floor; error feedback shapes that floor towards
+// Nyquist, lowering it in the audible band at the cost of more total noise.
+typedef enum {
+    AUDIO_PWM_DMA_DITHER_NONE = 0,  // truncate
+    AUDIO_PWM_DMA_DITHER_TPDF,      // triangular dither, flat noise floor
+    AUDIO_PWM_DMA_DITHER_SHAPED1,   // TPDF with first-order (1 - z^-1) shaping
+    AUDIO_PWM_DMA_DITHER_SHAPED2,   // TPDF with second-order (1 - z^-1)^2 shaping
+} audio_pwm_dma_dither_t;
+
+// Playback telemetry, cumulative since init or audio_pwm_dma_reset_stats().
 typedef struct {
+    uint32_t underruns;       // ring buffers the DMA restarted before they were refilled
+    uint32_t refills;         // ring buffers refilled by the IRQ
+    uint64_t samples_played;  // levels output, end-of-stream ramp and padding included
+    uint32_t isr_count;       // DMA IRQ services for this player
+    uint32_t isr_cycles_max;  // cycle_counter cycles per service
+    uint32_t isr_cycles_avg;
+    // Pipeline players: samples core 1 had filled from the playing ring
+    // buffer on at each IRQ before the end of the stream, lowest and
+    // average. A full ring is buffer_count * buffer_samples; below
+    // buffer_samples is an underrun.
+    uint32_t queued_min;
+    uint32_t queued_avg;
+} audio_pwm_dma_stats_t;
+
+// Called from the DMA IRQ once playback has stopped and the hardware is idle.
+typedef void (*audio_done_callback_t)(audio_player_t *player, void *user_data);
+
+// Per-player setup. Each player needs its own PWM slice for output plus a
+// free slice for pacing, so an RP2040 runs up to four players at once.
+typedef struct {
+    uint gpio;
+    // Caller-owned ring of buffer_count * buffer_samples levels; NULL selects
+    // the player's own buffer_storage with the default count and size. Small
+    // buffers cut latency (queued audio is count * samples), more buffers add
+    // slack for a delayed refill.
+    uint16_t *buffers;
+    uint buffer_count;
+    uint buffer_samples;
+    // Stereo output: gpio must be a channel A pin; left plays on it and right
+    // on gpio + 1 (channel B of the same slice). Buffers then hold an A/B
+    // level pair per sample, so caller buffers need twice the levels and the
+    // player's own storage holds half as many samples per buffer. Mono
+    // output downmixes stereo sources to (L+R)/2.
+    bool stereo;
+    // Differential (bridge-tied) mono output: gpio must be a channel A pin;
+    // gpio + 1 (channel B) plays the same level with inverted polarity, so
+    // the load across the pair sees twice the swing with no DC offset and no
+    // carrier common mode. Not combinable with stereo.
+    bool differential;
+    // Requantization of 16-bit and wider sources; 8-bit sources are played
+    // as-is.
+    audio_pwm_dma_dither_t dither;
+    // Sigma-delta output when > 1 (a power of two up to
+    // AUDIO_PWM_DMA_MAX_OVERSAMPLE): the output slice runs at sample_rate *
+    // oversample with as many levels as clk_sys leaves room for, paces the
+    // DMA itself, and a second-order modulator fills the ring. Buffers then
+    // hold levels at the carrier rate, so buffer_samples must be a multiple
+    // of oversample. 0 or 1 plays 8-bit levels directly; dither is ignored.
+    uint oversample;
+    // Plays the mixer's voices (see audio_mixer.h) in place of a WAV: the
+    // wav passed to init is ignored and the player takes the mixer's rate
+    // and channels. A mixer player never runs out of data; it plays silence
+    // while no voice plays, until audio_pwm_dma_deinit().
+    audio_mixer_t *mixer;
+    // Plays s16 frames that application code writes into an audio_ring_t
+    // (see audio_ring.h), in place of a WAV: the player takes the ring's
+    // rate and channels and is its consumer. An empty ring plays silence,
+    // counted in the ring's starved frames, until the producer closes it;
+    // then the player drains and stops. Not combinable with mixer.
+    audio_ring_t *ring;
+    // Plays what a source (see audio_source.h) hands out, in place of a
+    // WAV: the player takes the source's rate and channels and reads it
+    // from the refill path (the DMA IRQ, or core 1 with pipeline) until it
+    // returns 0, then drains and stops. The source is copied; its ctx must
+    // outlive the player. Not combinable with mixer or ring.
+    const audio_source_t *source;
+    // Refills the ring on core 1 (needs AUDIO_PWM_DMA_PIPELINE): decoding,
+    // mixing, dither and sigma-delta run there, and the DMA IRQ on core 0
+    // only publishes how far the DMA has got. The ring is the queue between
+    // them: core 1 fills buffers up to buffer_count ahead of the one
+    // playing and sleeps in __wfe() until the IRQ frees one. Core 1 belongs
+    // to the player from init to deinit, so one player per chip can use it.
+    // Ignored for zero-copy streams, which have no refill work.
+    bool pipeline;
+} audio_pwm_dma_config_t;
+
+struct audio_player {
     wav_info_t wav;
+    // Where the frames in decoded come from when the WAV data is not read
+    // in place: the player's own decoder, a mixer, or config.source.
+    audio_source_t source;
+    audio_mixer_t *mixer;
+    // Or from the span of ring the kernels are reading, decoded_len frames
+    // long; a shared block of silence while the ring is empty.
+    audio_ring_t *ring;
+    const int16_t *ring_span;
     const uint8_t *cursor;
     size_t remaining;
     uint16_t frame_stride;
+    uint8_t sample_format;  // u8, s16, s24, s32 or f32; internal to the player
+    audio_kernel_t kernel;
+    // Compressed sources decode to s16 frames in decoded (u8 frames for a
+    // source with read_u8), which the kernels then read in place of the WAV
+    // data; the decoder state carries over from one refill to the next.
+    // Only the source's own decoder is live.
+    union {
+        ima_adpcm_decoder_t adpcm;
+        qoa_decoder_t qoa;
+    };
+    int16_t decoded[AUDIO_PWM_DMA_DECODE_FRAMES * 2];
+    uint16_t decoded_pos;
+    uint16_t decoded_len;
+    // Replaces kernel when dither is enabled for a 16-bit or wider source.
+    // The RNG and the last two quantization errors per output channel run on
+    // across refills, so buffer boundaries are inaudible.
+    audio_pwm_dma_dither_t dither;
+    audio_dither_kernel_t dither_kernel;
+    uint32_t dither_rng;
+    int32_t dither_err[2][2];
     uint slice_num;
+    // dma_chan_a paces levels into the PWM CC half-word. dma_chan_b is the
+    // ring's control channel, or the zero-copy staging copier.
     uint dma_chan_a;
     uint dma_chan_b;
     uint gpio;
     uint pwm_channel;
     uint pace_slice;
+    bool stereo_output;
+    bool differential_output;
+    // Sigma-delta output: levels per PWM period (wrap + 1), the modulator's
+    // last input sample and two quantization errors per output channel, and
+    // the last data sample for the end-of-stream ramp.
+    uint oversample;
+    uint16_t sd_levels;
+    int32_t sd_prev[2];
+    int32_t sd_last[2];
+    int32_t sd_err[2][2];
+    // Idle level: 128, or sd_levels / 2 in sigma-delta mode.
+    uint16_t level_mid;
+    // Sample-rate DREQ: pace_slice's wrap, or DMA timer pace_timer when >= 0.
+    // pace_slice is the output slice unless PWM pacing claimed another. In
+    // sigma-delta mode the output slice paces itself and the rate is the
+    // carrier rate.
+    uint pace_dreq;
+    int pace_timer;
+    uint32_t pace_rate_millihz;
+    int32_t pace_error_ppb;
+    // u8 mono streams straight from wav.data: dma_chan_a moves each byte into
+    // zero_copy_level and dma_chan_b copies it to the PWM CC half-word, each
+    // for a transfer count that ends with the data.
+    bool zero_copy;
+    uint16_t zero_copy_level;
+    alarm_id_t zero_copy_alarm;
+    volatile uint16_t *cc_half;
+    // End of stream: done is set once the data is consumed, then the ramp
+    // from last_level plays out and the drain buffer's completion (or, for
+    // zero-copy, the ramp transfer's) stops playback.
     bool done;
-} audio_player_t;
+    volatile audio_player_state_t state;
+    // Set once playback finishes, which stops pacing and the DMA chain;
+    // cleared when they are armed again.
+    bool halted;
+    uint16_t last_level[2];
+    uint16_t ramp_from[2];
+    uint16_t ramp_pos;
+    int64_t drain_seq;
+    uint16_t ramp[AUDIO_PWM_DMA_RAMP_SAMPLES];
+    // Refill ring. Buffers are numbered in play order (sequence s lives in
+    // buffer s % buffer_count); refill_seq is the next played sequence whose
+    // buffer still has to be refilled, buffers_done the sequences finished.
+    uint16_t *buffers;
+    uint buffer_count;
+    uint buffer_samples;
+    uint64_t refill_seq;
+    uint64_t buffers_done;
+    uint64_t start_us;
+    // Mixer players: the mixer frame each ring buffer starts with.
+    uint64_t ring_mix_frame[AUDIO_PWM_DMA_MAX_BUFFERS];
+    uint32_t ring_list[AUDIO_PWM_DMA_MAX_BUFFERS] __attribute__((aligned(AUDIO_PWM_DMA_MAX_BUFFERS * 4)));
+    // Pipeline mode. Core 1 fills sequence pipe_next next and publishes
+    // pipe_filled (sequences filled) and pipe_drain (the drain buffer's
+    // sequence + 1, 0 until known); the IRQ publishes pipe_done (sequences
+    // finished, 32 bits of buffers_done). Core 1 only touches the stream
+    // while pipe_run is set and it has raised pipe_busy.
+    bool pipeline;
+    uint32_t pipe_next;
+    _Atomic uint32_t pipe_filled;
+    _Atomic uint32_t pipe_drain;
+    _Atomic uint32_t pipe_done;
+    _Atomic bool pipe_run;
+    _Atomic bool pipe_busy;
+    _Atomic bool pipe_quit;
+    uint32_t pipe_seen;  // pipe_filled at the last IRQ
+    uint64_t queued_total;
+    uint32_t queued_count;
+#if !AUDIO_PWM_DMA_ZERO_COPY_ONLY
+    uint16_t buffer_storage[AUDIO_PWM_DMA_BUFFER_COUNT * AUDIO_PWM_DMA_BUFFER_SAMPLES];
+#endif
+    audio_done_callback_t on_done;
+    void *on_done_data;
+    // Written by the IRQ under the stats_seq sequence lock.
+    audio_pwm_dma_stats_t stats;
+    uint64_t isr_cycles_total;
+    uint64_t stats_samples_base;
+    uint64_t stats_buffers_base;
+    volatile uint32_t stats_seq;
+};
+
+// Resets stream state for a WAV and selects its refill kernel (no hardware access).
+bool audio_pwm_dma_prepare(audio_player_t *player, const wav_info_t *wav);
 
-// Initializes the PWM, pacing PWM, and DMA chains for playback.
+// Default config for an output pin, using the player's own buffers.
+audio_pwm_dma_config_t audio_pwm_dma_get_default_config(uint gpio);
+
+// Initializes the PWM, pacing PWM, and DMA chains for playback. Any number of
+// players can be initialized as long as slices and DMA channels remain.
+bool audio_pwm_dma_init_with_config(audio_player_t *player, const wav_info_t *wav,
+                                    const audio_pwm_dma_config_t *config);
+
+// Same as audio_pwm_dma_init_with_config() with the default config for gpio.
 bool audio_pwm_dma_init(audio_player_t *player, const wav_info_t *wav, uint gpio);
 
-// Starts DMA playback after initialization.
+// Stops playback and releases the player's slices, DMA channels and timer.
+void audio_pwm_dma_deinit(audio_player_t *player);
+
+// Starts DMA playback after initialization. Playback stops by itself at the
+// end of the data and the player returns to AUDIO_PLAYER_IDLE.
 void audio_pwm_dma_start(audio_player_t *player);
 
+// Re-arms an initialized player with another WAV and starts it, cutting off
+// anything still playing. Mixer players start voices with
+// audio_mixer_play() instead, ring players play what is written and source
+// players what their source hands out.
+bool audio_pwm_dma_play(audio_player_t *player, const wav_info_t *wav);
+
+// Moves playback to frame, or to the nearest point before it the encoding
+// can restart from: any frame for PCM, the start of the IMA ADPCM block or
+// the QOA frame (QOA_FRAME_LEN samples) holding it. A frame past the end
+// seeks to the end. On a running player the audio already queued in the
+// ring plays first. Zero-copy players, and players whose data has run out,
+// can only seek before audio_pwm_dma_start() or once playback has finished,
+// and then play from there on the next start; mixer, ring and source
+// players cannot seek. position, if not NULL, gets the frame playback continues
+// from.
+bool audio_pwm_dma_seek(audio_player_t *player, size_t frame, size_t *position);
+
+// Starts wav on a mixer player's voice (see audio_mixer_play()) so that it
+// sounds AUDIO_PWM_DMA_TRIGGER_LEAD frames after the DMA read position,
+// rather than after the audio already queued in the ring: the voice is
+// mixed into the queued levels ahead of the read pointer. Returns the
+// voice's id, or -1 as audio_mixer_play() does or for a plain player.
+// delay, if not NULL, gets the frames from the read position to the
+// voice's first frame.
+//
+// The rewrite runs with interrupts off, for roughly the queued frames'
+// worth of one voice's mixing; call it from the core that takes the
+// player's DMA IRQ. Sigma-delta players cannot rewrite their levels and
+// start the voice after the queued audio, as do pipeline players, whose
+// ring core 1 is writing; delay then gets the queued frames at most.
+int audio_pwm_dma_trigger(audio_player_t *player, const wav_info_t *wav, uint16_t volume, int16_t pan,
+                          uint32_t *delay);
+
+// Registers a callback run from the DMA IRQ when playback finishes.
+void audio_pwm_dma_set_done_callback(audio_player_t *player, audio_done_callback_t callback, void *user_data);
+
+// True once playback has finished and the hardware is stopped.
+bool audio_pwm_dma_is_idle(const audio_player_t *player);
+
+// Copies a consistent snapshot of the player's telemetry without blocking
+// the IRQ; safe from either core and from the done callback.
+void audio_pwm_dma_get_stats(const audio_player_t *player, audio_pwm_dma_stats_t *stats);
+
+// Zeroes the telemetry counters.
+void audio_pwm_dma_reset_stats(audio_player_t *player);
+
+// Sleeps in __wfe() until playback has finished.
+void audio_pwm_dma_wait(const audio_player_t *player);
+
+// Converts the next count frames into buffer, padding with silence after EOF.
+// This is the DMA refill path; it is exposed for benchmarks and offline rendering.
+void audio_pwm_dma_fill(audio_player_t *player, uint16_t *buffer, size_t count);
+
 #endif
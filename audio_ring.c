@@ -0,0 +1,119 @@
+#include "audio_ring.h"
+
+#include <string.h>
+
+bool audio_ring_init(audio_ring_t *ring, int16_t *storage, uint32_t frames, uint32_t sample_rate, bool stereo) {
+    if (!ring || !storage || ((uintptr_t)storage & 3u) || frames < 2 || frames > (1u << 30) ||
+        (frames & (frames - 1u)) || sample_rate == 0) {
+        return false;
+    }
+    ring->samples = storage;
+    ring->mask = frames - 1u;
+    ring->channels = stereo ? 2u : 1u;
+    ring->sample_rate = sample_rate;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->closed, false);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->starved, 0);
+    return true;
+}
+
+wav_info_t audio_ring_output(const audio_ring_t *ring) {
+    return (wav_info_t){
+        .sample_rate = ring->sample_rate,
+        .bits_per_sample = 16,
+        .channels = ring->channels,
+        .encoding = WAV_ENCODING_PCM,
+    };
+}
+
+// Each side reads its own index relaxed (no one else writes it) and the
+// other's with acquire, which orders the frames or space behind it.
+size_t audio_ring_free(const audio_ring_t *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return (size_t)(ring->mask + 1u - (head - tail));
+}
+
+int16_t *audio_ring_write_span(audio_ring_t *ring, size_t *frames) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t at = head & ring->mask;
+    uint32_t space = ring->mask + 1u - (head - tail);
+    uint32_t to_wrap = ring->mask + 1u - at;
+    *frames = space < to_wrap ? space : to_wrap;
+    return ring->samples + (size_t)at * ring->channels;
+}
+
+void audio_ring_commit(audio_ring_t *ring, size_t frames) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + (uint32_t)frames, memory_order_release);
+}
+
+size_t audio_ring_write(audio_ring_t *ring, const int16_t *src, size_t frames) {
+    size_t done = 0;
+    // Two spans at most: up to the wrap, then from the start.
+    for (int part = 0; part < 2 && done < frames; ++part) {
+        size_t n;
+        int16_t *dst = audio_ring_write_span(ring, &n);
+        n = n < frames - done ? n : frames - done;
+        if (n == 0) {
+            break;
+        }
+        memcpy(dst, src + done * ring->channels, n * ring->channels * sizeof(int16_t));
+        audio_ring_commit(ring, n);
+        done += n;
+    }
+    return done;
+}
+
+// Release, so a consumer that sees closed also sees the last head.
+void audio_ring_close(audio_ring_t *ring) {
+    atomic_store_explicit(&ring->closed, true, memory_order_release);
+}
+
+size_t audio_ring_available(const audio_ring_t *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return (size_t)(head - tail);
+}
+
+const int16_t *audio_ring_read_span(audio_ring_t *ring, size_t *frames) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t at = tail & ring->mask;
+    uint32_t used = head - tail;
+    uint32_t to_wrap = ring->mask + 1u - at;
+    *frames = used < to_wrap ? used : to_wrap;
+    return ring->samples + (size_t)at * ring->channels;
+}
+
+void audio_ring_consume(audio_ring_t *ring, size_t frames) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + (uint32_t)frames, memory_order_release);
+}
+
+size_t audio_ring_read(audio_ring_t *ring, int16_t *dst, size_t frames) {
+    size_t done = 0;
+    for (int part = 0; part < 2 && done < frames; ++part) {
+        size_t n;
+        const int16_t *src = audio_ring_read_span(ring, &n);
+        n = n < frames - done ? n : frames - done;
+        if (n == 0) {
+            break;
+        }
+        memcpy(dst + done * ring->channels, src, n * ring->channels * sizeof(int16_t));
+        audio_ring_consume(ring, n);
+        done += n;
+    }
+    return done;
+}
+
+// closed is loaded first: once it reads true, the head loaded after it is
+// the final one.
+bool audio_ring_ended(const audio_ring_t *ring) {
+    if (!atomic_load_explicit(&ring->closed, memory_order_acquire)) {
+        return false;
+    }
+    return audio_ring_available(ring) == 0;
+}
@@ -0,0 +1,99 @@
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wav.h"
+
+// Single-producer single-consumer ring of s16 frames, for feeding a player
+// (audio_pwm_dma_config_t.ring) from application code: a synthesizer, a
+// decoder running in the main loop, audio arriving over USB or UART. One
+// context writes and one reads, on the same core or on different ones,
+// without locks or disabled interrupts.
+//
+// The ring counts frames written (head) and read (tail) in free-running 32
+// bit indices; each side stores only its own index and loads the other's.
+// A release store publishes the frames (or the free space) before the
+// index, and an acquire load orders them after it. Those are all the
+// atomics used: plain loads and stores with a barrier, which Cortex-M0+
+// has, and no read-modify-write, which it would need a lock for.
+//
+// Both sides move whole contiguous spans: audio_ring_write_span() and
+// audio_ring_read_span() hand out the storage itself, up to the wrap, and
+// audio_ring_write()/audio_ring_read() copy through them with at most two
+// memcpy calls. refill_bench prints the cost per block.
+
+// Alignment of the two indices, each on its own line so that the producer's
+// stores do not invalidate the consumer's cached copy of its own index.
+// RP2040 and RP2350 have no data cache, so words do; hosts want 64.
+#ifndef AUDIO_RING_ALIGN
+#define AUDIO_RING_ALIGN 4
+#endif
+
+typedef struct {
+    int16_t *samples;
+    uint32_t mask;  // frames - 1
+    uint16_t channels;
+    uint32_t sample_rate;
+    // Written by the producer: frames written, and set once no more follow.
+    _Alignas(AUDIO_RING_ALIGN) _Atomic uint32_t head;
+    _Atomic bool closed;
+    // Written by the consumer: frames read, and frames a player played as
+    // silence because the ring was empty.
+    _Alignas(AUDIO_RING_ALIGN) _Atomic uint32_t tail;
+    _Atomic uint32_t starved;
+} audio_ring_t;
+
+// Sets up an empty ring over storage, frames frames (a power of two from 2
+// to 2^30) of sample_rate s16 audio, interleaved if stereo. storage holds
+// frames * 2 samples in stereo, is 4-byte aligned, and stays owned by the
+// ring until no side uses it.
+bool audio_ring_init(audio_ring_t *ring, int16_t *storage, uint32_t frames, uint32_t sample_rate, bool stereo);
+
+// The ring's contents as a source description: s16 at its rate and channel
+// count, with no data. audio_pwm_dma_init_with_config() uses it.
+wav_info_t audio_ring_output(const audio_ring_t *ring);
+
+// Producer: frames that can be written now, in total.
+size_t audio_ring_free(const audio_ring_t *ring);
+
+// Producer: the storage for the next frames to write and, in *frames, how
+// many of them are contiguous (0 when the ring is full). Fill them, then
+// publish what was filled with audio_ring_commit().
+int16_t *audio_ring_write_span(audio_ring_t *ring, size_t *frames);
+
+// Producer: hands frames written through audio_ring_write_span() to the
+// consumer.
+void audio_ring_commit(audio_ring_t *ring, size_t frames);
+
+// Producer: copies up to frames frames from src and commits them. Returns
+// the frames copied, less than asked when the ring fills up.
+size_t audio_ring_write(audio_ring_t *ring, const int16_t *src, size_t frames);
+
+// Producer: marks the end of the stream once the frames written so far are
+// read. A player fed by the ring then drains and stops.
+void audio_ring_close(audio_ring_t *ring);
+
+// Consumer: frames that can be read now, in total.
+size_t audio_ring_available(const audio_ring_t *ring);
+
+// Consumer: the next frames to read and, in *frames, how many of them are
+// contiguous (0 when the ring is empty). They stay valid until released
+// with audio_ring_consume().
+const int16_t *audio_ring_read_span(audio_ring_t *ring, size_t *frames);
+
+// Consumer: hands frames read through audio_ring_read_span() back to the
+// producer.
+void audio_ring_consume(audio_ring_t *ring, size_t frames);
+
+// Consumer: copies up to frames frames to dst and consumes them. Returns
+// the frames copied, less than asked when the ring runs empty.
+size_t audio_ring_read(audio_ring_t *ring, int16_t *dst, size_t frames);
+
+// Consumer: true once the ring is closed and every frame has been read.
+bool audio_ring_ended(const audio_ring_t *ring);
+
+#endif
@@ -0,0 +1,169 @@
+#include "audio_source.h"
+
+#include <string.h>
+
+#include "g711.h"
+
+wav_info_t audio_source_output(const audio_source_t *source) {
+    return (wav_info_t){
+        .sample_rate = source->sample_rate,
+        .bits_per_sample = source->ops->read_u8 ? 8 : 16,
+        .channels = source->channels,
+        .encoding = WAV_ENCODING_PCM,
+    };
+}
+
+static size_t adpcm_read_frames(void *ctx, int16_t *dst, size_t frames) {
+    return ima_adpcm_decode(ctx, dst, frames);
+}
+
+static size_t qoa_read_frames(void *ctx, int16_t *dst, size_t frames) {
+    return qoa_decode(ctx, dst, frames);
+}
+
+const audio_source_ops_t audio_source_ima_adpcm_ops = {adpcm_read_frames, NULL};
+const audio_source_ops_t audio_source_qoa_ops = {qoa_read_frames, NULL};
+
+// Takes up to frames whole frames of an uncompressed clip; returns how many
+// and where they start.
+static const uint8_t *wav_take(audio_wav_reader_t *reader, size_t frames, size_t *got) {
+    size_t stride = (size_t)(reader->wav.bits_per_sample / 8u) * reader->wav.channels;
+    size_t n = reader->remaining / stride;
+    n = n < frames ? n : frames;
+    const uint8_t *p = reader->cursor;
+    reader->cursor += n * stride;
+    reader->remaining -= n * stride;
+    *got = n;
+    return p;
+}
+
+static size_t wav_read_frames(void *ctx, int16_t *dst, size_t frames) {
+    audio_wav_reader_t *reader = ctx;
+    const wav_info_t *wav = &reader->wav;
+    if (wav->encoding == WAV_ENCODING_IMA_ADPCM) {
+        return ima_adpcm_decode(&reader->adpcm, dst, frames);
+    }
+    if (wav->encoding == WAV_ENCODING_QOA) {
+        return qoa_decode(&reader->qoa, dst, frames);
+    }
+    size_t n;
+    const uint8_t *p = wav_take(reader, frames, &n);
+    size_t samples = n * wav->channels;
+    if (wav->encoding == WAV_ENCODING_ALAW || wav->encoding == WAV_ENCODING_MULAW) {
+        const int16_t *table = wav->encoding == WAV_ENCODING_ALAW ? g711_alaw_to_s16 : g711_ulaw_to_s16;
+        for (size_t i = 0; i < samples; ++i) {
+            dst[i] = table[p[i]];
+        }
+    } else if (wav->bits_per_sample == 8) {
+        for (size_t i = 0; i < samples; ++i) {
+            dst[i] = (int16_t)(((int32_t)p[i] - 128) * 256);
+        }
+    } else {
+        memcpy(dst, p, samples * sizeof(int16_t));
+    }
+    return n;
+}
+
+// u8 and G.711 clips: G.711 through the table of truncated levels, which
+// are u8 samples.
+static size_t wav_read_u8(void *ctx, uint8_t *dst, size_t frames) {
+    audio_wav_reader_t *reader = ctx;
+    size_t n;
+    const uint8_t *p = wav_take(reader, frames, &n);
+    size_t samples = n * reader->wav.channels;
+    if (reader->wav.encoding == WAV_ENCODING_PCM) {
+        memcpy(dst, p, samples);
+    } else {
+        const uint8_t *table =
+            reader->wav.encoding == WAV_ENCODING_ALAW ? g711_alaw_to_level : g711_ulaw_to_level;
+        for (size_t i = 0; i < samples; ++i) {
+            dst[i] = table[p[i]];
+        }
+    }
+    return n;
+}
+
+static const audio_source_ops_t wav_ops = {wav_read_frames, NULL};
+static const audio_source_ops_t wav_u8_ops = {wav_read_frames, wav_read_u8};
+
+bool audio_source_wav(audio_source_t *source, audio_wav_reader_t *reader, const wav_info_t *wav) {
+    if (!source || !reader || !wav || wav->channels < 1 || wav->channels > 2) {
+        return false;
+    }
+    bool narrow = wav->encoding == WAV_ENCODING_ALAW || wav->encoding == WAV_ENCODING_MULAW ||
+                  (wav->encoding == WAV_ENCODING_PCM && wav->bits_per_sample == 8);
+    if (wav->encoding == WAV_ENCODING_PCM && wav->bits_per_sample != 8 && wav->bits_per_sample != 16) {
+        return false;
+    }
+    reader->wav = *wav;
+    reader->cursor = wav->data;
+    reader->remaining = wav->data_size;
+    if (wav->encoding == WAV_ENCODING_IMA_ADPCM) {
+        ima_adpcm_init(&reader->adpcm, wav->data, wav->data_size, wav->channels, wav->block_align);
+    } else if (wav->encoding == WAV_ENCODING_QOA) {
+        qoa_init(&reader->qoa, wav->data, wav->data_size, wav->channels);
+    }
+    *source = (audio_source_t){
+        .ops = narrow ? &wav_u8_ops : &wav_ops,
+        .ctx = reader,
+        .sample_rate = wav->sample_rate,
+        .channels = wav->channels,
+    };
+    return true;
+}
+
+// sin and cos of t in [0, pi/2] from their Taylor series, which keeps libm
+// out of the build; only a tone's setup calls this.
+static void sin_cos(double t, double *s, double *c) {
+    double term_s = t, term_c = 1.0;
+    *s = *c = 0.0;
+    for (int n = 1; n <= 17; n += 2) {
+        *s += term_s;
+        *c += term_c;
+        term_s *= -t * t / ((n + 1) * (n + 2));
+        term_c *= -t * t / (n * (n + 1));
+    }
+}
+
+static size_t tone_read_frames(void *ctx, int16_t *dst, size_t frames) {
+    audio_tone_t *tone = ctx;
+    frames = frames < tone->remaining ? frames : tone->remaining;
+    int32_t x = tone->x, y = tone->y, k = tone->k;
+    for (size_t i = 0; i < frames; ++i) {
+        x -= (int32_t)(((int64_t)k * y) >> 29);
+        y += (int32_t)(((int64_t)k * x) >> 29);
+        int32_t s = y >> 14;
+        dst[i] = (int16_t)(s > 32767 ? 32767 : s < -32768 ? -32768 : s);
+    }
+    tone->x = x;
+    tone->y = y;
+    if (tone->remaining != SIZE_MAX) {
+        tone->remaining -= frames;
+    }
+    return frames;
+}
+
+static const audio_source_ops_t tone_ops = {tone_read_frames, NULL};
+
+bool audio_source_tone(audio_source_t *source, audio_tone_t *tone, uint32_t sample_rate, uint32_t freq_hz,
+                       int16_t amplitude, size_t frames) {
+    if (!source || !tone || freq_hz == 0 || freq_hz >= sample_rate / 2u) {
+        return false;
+    }
+    // y peaks at amplitude << 14 when the rotation starts from x = that
+    // times cos(w / 2), y = 0: the orbit is an ellipse stretched by
+    // 1 / cos(w / 2).
+    double s, c;
+    sin_cos(3.14159265358979323846 * freq_hz / sample_rate, &s, &c);
+    tone->k = (int32_t)(2.0 * s * (1 << 29) + 0.5);
+    tone->x = (int32_t)(amplitude * c * (1 << 14));
+    tone->y = 0;
+    tone->remaining = frames;
+    *source = (audio_source_t){
+        .ops = &tone_ops,
+        .ctx = tone,
+        .sample_rate = sample_rate,
+        .channels = 1,
+    };
+    return true;
+}
@@ -0,0 +1,85 @@
+#ifndef AUDIO_SOURCE_H
+#define AUDIO_SOURCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ima_adpcm.h"
+#include "qoa.h"
+#include "wav.h"
+
+// Pull-model source for a player (audio_pwm_dma_config_t.source): the
+// refill path asks it for the next frames as it needs them, so generated,
+// decoded or streamed audio plays without being stored as a WAV first. The
+// player reaches its own IMA ADPCM and QOA decoders and a mixer the same
+// way; only clips it can read in place (PCM and G.711 in memory) skip it.
+//
+// A source writes interleaved s16 frames. One whose samples are 8 bits to
+// begin with can also give u8 frames (128 is silence), which the player
+// then asks for instead: they take the u8 kernels, as u8 WAV data does,
+// without widening to s16 and back.
+
+// Frames a read is asked for at least. The player asks for
+// AUDIO_PWM_DMA_DECODE_FRAMES at a time.
+#define AUDIO_SOURCE_MIN_FRAMES 32
+
+typedef struct {
+    // Writes up to frames frames to dst; returns how many, 0 at the end of
+    // the stream. Fewer than asked is fine, and is not the end.
+    size_t (*read_frames)(void *ctx, int16_t *dst, size_t frames);
+    // The same as u8 frames, or NULL.
+    size_t (*read_u8)(void *ctx, uint8_t *dst, size_t frames);
+} audio_source_ops_t;
+
+typedef struct {
+    const audio_source_ops_t *ops;
+    void *ctx;
+    uint32_t sample_rate;
+    uint16_t channels;
+} audio_source_t;
+
+// The source as a description: 8-bit PCM if it has read_u8, else 16-bit,
+// at its rate and channel count, with no data.
+// audio_pwm_dma_init_with_config() uses it.
+wav_info_t audio_source_output(const audio_source_t *source);
+
+// Decoders as sources; ctx is an initialized ima_adpcm_decoder_t or
+// qoa_decoder_t.
+extern const audio_source_ops_t audio_source_ima_adpcm_ops;
+extern const audio_source_ops_t audio_source_qoa_ops;
+
+// A clip in memory read front to back.
+typedef struct {
+    wav_info_t wav;
+    const uint8_t *cursor;
+    size_t remaining;
+    union {
+        ima_adpcm_decoder_t adpcm;
+        qoa_decoder_t qoa;
+    };
+} audio_wav_reader_t;
+
+// Points source at reader, set up to play wav from its start: u8 or s16
+// PCM, A-law, mu-law, IMA ADPCM or QOA, mono or stereo. u8 and G.711 clips
+// also read as u8 (G.711 through its level table). Returns false for
+// other formats.
+bool audio_source_wav(audio_source_t *source, audio_wav_reader_t *reader, const wav_info_t *wav);
+
+// Sine tone generator: a fixed-point rotation (x -= k * y; y += k * x)
+// that costs two multiplies per sample and keeps its amplitude over any
+// length, since each step is an exact shear of the integer state.
+typedef struct {
+    int32_t x;
+    int32_t y;
+    int32_t k;  // 2 sin(pi * freq / rate), Q29
+    size_t remaining;
+} audio_tone_t;
+
+// Points source at tone, a mono sine of freq_hz (below half of
+// sample_rate) peaking at amplitude, for frames frames or without end if
+// frames is SIZE_MAX. Returns false for a frequency it cannot play.
+bool audio_source_tone(audio_source_t *source, audio_tone_t *tone, uint32_t sample_rate, uint32_t freq_hz,
+                       int16_t amplitude, size_t frames);
+
+#endif
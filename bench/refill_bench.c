@@ -0,0 +1,716 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_mixer.h"
+#include "audio_pwm_dma.h"
+#include "audio_ring.h"
+#include "audio_source.h"
+#include "cycle_counter.h"
+#include "pace_solver.h"
+#include "sound_bank.h"
+#include "wav.h"
+
+#if defined(__arm__)
+#include "hardware/clocks.h"
+#include "pico/stdlib.h"
+#endif
+
+// Measures the cost of one DMA refill (512 samples, the ISR's unit of work)
+// for the format-specialised kernels against the original per-sample loop,
+// and the per-sample cost of each dither mode on top of plain truncation and
+// of the sigma-delta modulator (per output level). The wide formats (24-bit
+// packed, 32-bit int and float) give the conversion throughput per format,
+// the G.711 cases the table expansion, and the IMA ADPCM (4 bits) and QOA
+// (3.2 bits) cases the decode cost per sample, with QOA's share of a core at
+// 44.1 kHz on target. Last, the pacing search audio_pwm_dma_init() runs,
+// which sits between reset and the first sample, and the start of a clip:
+// a sound bank lookup against parsing the clip's RIFF file, each followed by
+// prepare and the first refill. The mixer section gives the cost per output
+// sample of 1 to 8 looping voices of each format, checked on target against
+// the budget in audio_mixer.h. The feed ring section gives the cost of
+// passing a block through an audio_ring_t, and a refill from one against
+// the same s16 frames read from memory. The source section gives a refill
+// pulled through an audio_source_t against the clip read in place, and one
+// from the tone generator.
+// Builds for the Pico (SysTick cycles) and for the host (TSC cycles).
+
+#define BENCH_SAMPLES 512
+#define BENCH_RUNS 64
+
+static uint16_t buffer_ref[BENCH_SAMPLES];
+static uint16_t buffer_new[BENCH_SAMPLES];
+static int16_t source[BENCH_SAMPLES * 2];
+// Wide stereo frames are up to 8 bytes; floats need values in range.
+static uint8_t source_wide[BENCH_SAMPLES * 8];
+static float source_f32[BENCH_SAMPLES * 2];
+// IMA ADPCM: 256 bytes per channel per block (505 frames), so a refill
+// crosses a block header.
+#define BENCH_ADPCM_BLOCK 256u
+static uint8_t source_adpcm[BENCH_ADPCM_BLOCK * 2 * 2];
+// QOA: one frame long enough for a refill, of random slices with small
+// scale factors so the predictor stays in range as it would on real audio.
+#define BENCH_QOA_SLICES ((BENCH_SAMPLES + QOA_SLICE_LEN - 1) / QOA_SLICE_LEN + 1)
+static uint8_t source_qoa[8 + 16 * 2 + BENCH_QOA_SLICES * 8 * 2];
+#define BENCH_QOA_RATE 44100u
+
+// A bank of clips that all share one s16 mono payload, and the same clip as
+// a RIFF file with a LIST chunk ahead of its data, as most editors write.
+#define BENCH_BANK_CLIPS 256u
+#define BENCH_BANK_PAYLOAD (SOUND_BANK_HEADER_SIZE + BENCH_BANK_CLIPS * SOUND_BANK_ENTRY_SIZE)
+static uint8_t bench_bank[BENCH_BANK_PAYLOAD + BENCH_SAMPLES * 2] __attribute__((aligned(4)));
+static uint8_t bench_riff[12 + 8 + 16 + 8 + 64 + 8 + BENCH_SAMPLES * 2] __attribute__((aligned(4)));
+
+typedef struct {
+    const char *name;
+    uint16_t bits_per_sample;
+    uint16_t channels;
+    bool is_float;
+    bool at_eof;
+    audio_pwm_dma_dither_t dither;
+    uint oversample;
+    wav_encoding_t encoding;
+} bench_case_t;
+
+typedef struct {
+    uint32_t min;
+    uint32_t total;
+} bench_result_t;
+
+static const bench_case_t cases[] = {
+    {"u8 mono", 8, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"u8 stereo", 8, 2, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"s16 mono", 16, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"s16 stereo", 16, 2, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"s24 mono", 24, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"s24 stereo", 24, 2, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"s32 mono", 32, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"s32 stereo", 32, 2, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"f32 mono", 32, 1, true, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"f32 stereo", 32, 2, true, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"alaw mono", 8, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_ALAW},
+    {"mulaw mono", 8, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_MULAW},
+    {"mulaw stereo", 8, 2, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_MULAW},
+    {"mulaw shaped2", 8, 1, false, false, AUDIO_PWM_DMA_DITHER_SHAPED2, 1, WAV_ENCODING_MULAW},
+    {"adpcm mono", 4, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_IMA_ADPCM},
+    {"adpcm stereo", 4, 2, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_IMA_ADPCM},
+    {"qoa mono", 16, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_QOA},
+    {"qoa stereo", 16, 2, false, false, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_QOA},
+    {"silence", 8, 1, false, true, AUDIO_PWM_DMA_DITHER_NONE, 1, WAV_ENCODING_PCM},
+    {"s16 tpdf", 16, 1, false, false, AUDIO_PWM_DMA_DITHER_TPDF, 1, WAV_ENCODING_PCM},
+    {"s16 shaped1", 16, 1, false, false, AUDIO_PWM_DMA_DITHER_SHAPED1, 1, WAV_ENCODING_PCM},
+    {"s16 shaped2", 16, 1, false, false, AUDIO_PWM_DMA_DITHER_SHAPED2, 1, WAV_ENCODING_PCM},
+    {"s24 shaped2", 24, 1, false, false, AUDIO_PWM_DMA_DITHER_SHAPED2, 1, WAV_ENCODING_PCM},
+    {"f32 shaped2", 32, 1, true, false, AUDIO_PWM_DMA_DITHER_SHAPED2, 1, WAV_ENCODING_PCM},
+    {"s16 st shaped2", 16, 2, false, false, AUDIO_PWM_DMA_DITHER_SHAPED2, 1, WAV_ENCODING_PCM},
+    {"s16 sd x8", 16, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 8, WAV_ENCODING_PCM},
+    {"s16 sd x16", 16, 1, false, false, AUDIO_PWM_DMA_DITHER_NONE, 16, WAV_ENCODING_PCM},
+    {"s16 st sd x16", 16, 2, false, false, AUDIO_PWM_DMA_DITHER_NONE, 16, WAV_ENCODING_PCM},
+};
+
+// A straightforward per-sample decode of the wide formats to s24 scale, with
+// float converted by the (software) FPU.
+static int32_t reference_s24(const uint8_t *p, const wav_info_t *wav) {
+    if (wav->is_float) {
+        float x;
+        memcpy(&x, p, sizeof(x));
+        float y = x * 8388608.0f;
+        return y >= 8388607.0f ? 0x7fffff : y <= -8388607.0f ? -0x7fffff : (int32_t)y;
+    }
+    int32_t v = 0;
+    for (uint b = 0; b < 3; ++b) {
+        v |= (int32_t)p[wav->bits_per_sample / 8 - 3 + b] << (8 * b);
+    }
+    return v >= 0x800000 ? v - 0x1000000 : v;
+}
+
+// G.711 expanded with shifts from the code's segment and step, as s16.
+static int32_t reference_g711(uint8_t code, bool alaw) {
+    if (alaw) {
+        uint32_t a = code ^ 0x55u, seg = (a >> 4) & 7u;
+        int32_t m = (int32_t)(2u * (a & 15u) + (seg ? 33u : 1u)) << (seg ? seg + 2u : 3u);
+        return (a & 0x80u) ? m : -m;
+    }
+    uint32_t u = (uint8_t)~code;
+    int32_t m = (int32_t)(((8u * (u & 15u) + 132u) << ((u >> 4) & 7u)) - 132u);
+    return (u & 0x80u) ? -m : m;
+}
+
+// IMA ADPCM decoded one sample at a time: locate the sample's nibble from
+// its frame number, then step the channel's predictor.
+static int32_t reference_adpcm(const wav_info_t *wav, size_t frame, uint c, int32_t *pred, int32_t *index) {
+    static const int16_t steps[89] = {
+        7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+        31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+        130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+        544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+        2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+        9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+    };
+    static const int8_t adjust[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+    const uint8_t *block = wav->data + (frame / wav->samples_per_block) * wav->block_align;
+    size_t k = frame % wav->samples_per_block;
+    if (k == 0) {
+        *pred = (int16_t)(block[4 * c] | (block[4 * c + 1] << 8));
+        *index = block[4 * c + 2] > 88 ? 88 : block[4 * c + 2];
+        return *pred;
+    }
+    uint8_t byte = block[4u * wav->channels * (1u + (k - 1) / 8) + 4u * c + ((k - 1) % 8) / 2];
+    uint32_t nibble = ((k - 1) & 1u) ? byte >> 4 : byte & 0xfu;
+    int32_t step = steps[*index];
+    int32_t diff = (step >> 3) + ((nibble & 1u) ? step >> 2 : 0) + ((nibble & 2u) ? step >> 1 : 0) +
+                   ((nibble & 4u) ? step : 0);
+    *pred += (nibble & 8u) ? -diff : diff;
+    *pred = *pred > 32767 ? 32767 : *pred < -32768 ? -32768 : *pred;
+    *index += adjust[nibble & 7u];
+    *index = *index < 0 ? 0 : *index > 88 ? 88 : *index;
+    return *pred;
+}
+
+// QOA decoded one sample at a time from the frame header's LMS state, with
+// the dequantized residual worked out from the scale factor.
+static int32_t reference_qoa(const wav_info_t *wav, size_t frame, uint c, int32_t *history, int32_t *weights) {
+    static const int32_t scale[16] = {1, 7, 21, 45, 84, 138, 211, 304, 421, 562, 731, 928, 1157, 1419, 1715, 2048};
+    static const int32_t quarters[4] = {3, 10, 18, 28};
+    const uint8_t *p = wav->data;
+    if (frame == 0) {
+        for (uint i = 0; i < 4; ++i) {
+            history[i] = (int16_t)((p[8 + 16 * c + 2 * i] << 8) | p[9 + 16 * c + 2 * i]);
+            weights[i] = (int16_t)((p[16 + 16 * c + 2 * i] << 8) | p[17 + 16 * c + 2 * i]);
+        }
+    }
+    const uint8_t *word = p + 8 + 16 * wav->channels + 8 * ((frame / QOA_SLICE_LEN) * wav->channels + c);
+    uint64_t slice = 0;
+    for (uint b = 0; b < 8; ++b) {
+        slice = (slice << 8) | word[b];
+    }
+    uint32_t q = (uint32_t)(slice >> (57 - 3 * (frame % QOA_SLICE_LEN))) & 7u;
+    int32_t residual = (scale[slice >> 60] * quarters[q >> 1] + 2) / 4;
+    residual = (q & 1u) ? -residual : residual;
+    int32_t sum = 0;
+    for (uint i = 0; i < 4; ++i) {
+        sum += history[i] * weights[i];
+    }
+    int32_t sample = (sum >> 13) + residual;
+    sample = sample > 32767 ? 32767 : sample < -32768 ? -32768 : sample;
+    for (uint i = 0; i < 4; ++i) {
+        weights[i] += history[i] < 0 ? -(residual >> 4) : residual >> 4;
+    }
+    for (uint i = 0; i < 3; ++i) {
+        history[i] = history[i + 1];
+    }
+    history[3] = sample;
+    return sample;
+}
+
+// The refill loop as it was before kernels were selected at init time, with
+// the (L+R)/2 downmix the stereo kernels now apply.
+static void fill_reference(audio_player_t *player, uint16_t *buffer, size_t count) {
+    if (player->wav.encoding == WAV_ENCODING_IMA_ADPCM) {
+        int32_t pred[2] = {0, 0}, index[2] = {0, 0};
+        size_t frames = wav_frame_count(&player->wav);
+        for (size_t i = 0; i < count; ++i) {
+            if (i >= frames) {
+                buffer[i] = 128;
+                continue;
+            }
+            int32_t l = reference_adpcm(&player->wav, i, 0, &pred[0], &index[0]);
+            int32_t r = player->wav.channels == 2 ? reference_adpcm(&player->wav, i, 1, &pred[1], &index[1]) : l;
+            buffer[i] = (uint16_t)((l + r + 65536) >> 9);
+        }
+        return;
+    }
+    if (player->wav.encoding == WAV_ENCODING_QOA) {
+        int32_t history[2][4], weights[2][4];
+        size_t frames = wav_frame_count(&player->wav);
+        for (size_t i = 0; i < count; ++i) {
+            if (i >= frames) {
+                buffer[i] = 128;
+                continue;
+            }
+            int32_t l = reference_qoa(&player->wav, i, 0, history[0], weights[0]);
+            int32_t r = player->wav.channels == 2 ? reference_qoa(&player->wav, i, 1, history[1], weights[1]) : l;
+            buffer[i] = (uint16_t)((l + r + 65536) >> 9);
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (player->remaining < player->frame_stride) {
+            player->done = true;
+            buffer[i] = 128;
+            continue;
+        }
+
+        uint16_t level = 128;
+        bool stereo = player->wav.channels == 2;
+        if (player->wav.encoding == WAV_ENCODING_ALAW || player->wav.encoding == WAV_ENCODING_MULAW) {
+            bool alaw = player->wav.encoding == WAV_ENCODING_ALAW;
+            int32_t l = reference_g711(player->cursor[0], alaw);
+            int32_t r = stereo ? reference_g711(player->cursor[1], alaw) : l;
+            level = (uint16_t)((l + r + 65536) >> 9);
+        } else if (player->wav.bits_per_sample == 8) {
+            level = stereo ? (uint16_t)((player->cursor[0] + player->cursor[1]) >> 1) : player->cursor[0];
+        } else if (player->wav.bits_per_sample > 16) {
+            int32_t l = reference_s24(player->cursor, &player->wav);
+            int32_t r = stereo ? reference_s24(player->cursor + player->wav.bits_per_sample / 8, &player->wav) : l;
+            level = (uint16_t)((l + r + 0x1000000) >> 17);
+        } else {
+            const int16_t *s = (const int16_t *)player->cursor;
+            int32_t sum = stereo ? (int32_t)s[0] + s[1] : 2 * (int32_t)s[0];
+            level = (uint16_t)((sum + 65536) >> 9);
+        }
+
+        buffer[i] = level;
+        player->cursor += player->frame_stride;
+        player->remaining -= player->frame_stride;
+    }
+}
+
+static bench_result_t run_case(const wav_info_t *wav, const bench_case_t *bc, bool reference, uint16_t *buffer) {
+    bench_result_t result = {.min = UINT32_MAX};
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        // 128 levels is what sigma-delta gets at 44.1 kHz x16 on a 125 MHz clock.
+        audio_player_t player = {.dither = bc->dither, .oversample = bc->oversample, .sd_levels = 128};
+        audio_pwm_dma_prepare(&player, wav);
+        if (bc->at_eof) {
+            // Past the end-of-stream ramp: steady-state silence.
+            player.remaining = 0;
+            player.done = true;
+            player.ramp_pos = AUDIO_PWM_DMA_RAMP_SAMPLES;
+        }
+
+        uint32_t start = cycle_counter_read();
+        if (reference) {
+            fill_reference(&player, buffer, BENCH_SAMPLES);
+        } else {
+            audio_pwm_dma_fill(&player, buffer, BENCH_SAMPLES);
+        }
+        uint32_t cycles = cycle_counter_elapsed(start, cycle_counter_read());
+
+        if (cycles < result.min) {
+            result.min = cycles;
+        }
+        result.total += cycles;
+    }
+    return result;
+}
+
+static void put_le(uint8_t *p, uint32_t value, uint bytes) {
+    for (uint i = 0; i < bytes; ++i) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void build_bench_clips(void) {
+    uint8_t *b = bench_bank;
+    memcpy(b, "PWSB", 4);
+    put_le(b + 4, SOUND_BANK_VERSION, 2);
+    put_le(b + 6, SOUND_BANK_ENTRY_SIZE, 2);
+    put_le(b + 8, BENCH_BANK_CLIPS, 4);
+    put_le(b + 12, SOUND_BANK_HEADER_SIZE, 4);
+    for (uint32_t id = 0; id < BENCH_BANK_CLIPS; ++id) {
+        uint8_t *e = b + SOUND_BANK_HEADER_SIZE + id * SOUND_BANK_ENTRY_SIZE;
+        put_le(e, BENCH_BANK_PAYLOAD, 4);
+        put_le(e + 4, BENCH_SAMPLES * 2, 4);
+        put_le(e + 8, 16000, 4);
+        put_le(e + 12, 2, 2);
+        put_le(e + 14, 0, 2);
+        e[16] = WAV_ENCODING_PCM;
+        e[17] = 1;
+        e[18] = 16;
+        e[19] = 0;
+    }
+    memcpy(b + BENCH_BANK_PAYLOAD, source, BENCH_SAMPLES * 2);
+
+    uint8_t *r = bench_riff;
+    memcpy(r, "RIFF", 4);
+    put_le(r + 4, sizeof(bench_riff) - 8, 4);
+    memcpy(r + 8, "WAVEfmt ", 8);
+    put_le(r + 16, 16, 4);
+    put_le(r + 20, 1, 2);
+    put_le(r + 22, 1, 2);
+    put_le(r + 24, 16000, 4);
+    put_le(r + 28, 32000, 4);
+    put_le(r + 32, 2, 2);
+    put_le(r + 34, 16, 2);
+    memcpy(r + 36, "LIST", 4);
+    put_le(r + 40, 64, 4);
+    memcpy(r + 44, "INFOISFT", 8);
+    memcpy(r + 108, "data", 4);
+    put_le(r + 112, BENCH_SAMPLES * 2, 4);
+    memcpy(r + 116, source, BENCH_SAMPLES * 2);
+}
+
+// Cycles from a clip id (or file) to its first refilled buffer, min of
+// BENCH_RUNS; with lookup_only, to its wav_info_t.
+static uint32_t time_clip_start(bool from_bank, bool lookup_only) {
+    sound_bank_t bank;
+    sound_bank_open(&bank, bench_bank, sizeof(bench_bank));
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        audio_player_t player = {0};
+        wav_info_t wav;
+        uint32_t start = cycle_counter_read();
+        bool ok = from_bank ? sound_bank_get(&bank, BENCH_BANK_CLIPS - 1 - (uint32_t)run, &wav)
+                            : parse_wav(bench_riff, sizeof(bench_riff), &wav);
+        if (ok && !lookup_only && audio_pwm_dma_prepare(&player, &wav)) {
+            audio_pwm_dma_fill(&player, buffer_new, BENCH_SAMPLES);
+        }
+        uint32_t cycles = cycle_counter_elapsed(start, cycle_counter_read());
+        best = ok && cycles < best ? cycles : best;
+    }
+    return best;
+}
+
+// Feed ring: cycles to write a block of frames into a ring and read it back,
+// by copy or through the spans with no copy (the index traffic alone), min
+// of BENCH_RUNS; or a plain memcpy of the block.
+enum { RING_MEMCPY, RING_COPY, RING_SPAN };
+
+static int16_t bench_ring[BENCH_SAMPLES * 2] __attribute__((aligned(4)));
+
+static uint32_t time_ring_block(size_t frames, int mode) {
+    audio_ring_t ring;
+    audio_ring_init(&ring, bench_ring, BENCH_SAMPLES * 2, 16000, false);
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        size_t n;
+        uint32_t start = cycle_counter_read();
+        if (mode == RING_MEMCPY) {
+            memcpy(buffer_new, source, frames * sizeof(int16_t));
+            memcpy(buffer_ref, buffer_new, frames * sizeof(int16_t));
+        } else if (mode == RING_COPY) {
+            audio_ring_write(&ring, source, frames);
+            audio_ring_read(&ring, (int16_t *)buffer_new, frames);
+        } else {
+            audio_ring_write_span(&ring, &n);
+            audio_ring_commit(&ring, frames);
+            audio_ring_read_span(&ring, &n);
+            audio_ring_consume(&ring, frames);
+        }
+        uint32_t cycles = cycle_counter_elapsed(start, cycle_counter_read());
+        best = cycles < best ? cycles : best;
+    }
+    return best;
+}
+
+// Cycles for one BENCH_SAMPLES refill of a mono player from a ring holding
+// the frames, or from the same s16 frames in memory; min of BENCH_RUNS.
+static uint32_t time_ring_refill(bool fed) {
+    static audio_player_t player;
+    static audio_ring_t ring;
+    wav_info_t wav = {(const uint8_t *)source, BENCH_SAMPLES * 2, 16000, 16, 1, false, WAV_ENCODING_PCM, 2, 0};
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        player = (audio_player_t){.ring = fed ? &ring : NULL};
+        if (fed) {
+            audio_ring_init(&ring, bench_ring, BENCH_SAMPLES * 2, 16000, false);
+            audio_ring_write(&ring, source, BENCH_SAMPLES);
+            wav = audio_ring_output(&ring);
+        }
+        audio_pwm_dma_prepare(&player, &wav);
+        uint32_t start = cycle_counter_read();
+        audio_pwm_dma_fill(&player, buffer_new, BENCH_SAMPLES);
+        uint32_t cycles = cycle_counter_elapsed(start, cycle_counter_read());
+        best = cycles < best ? cycles : best;
+    }
+    return best;
+}
+
+static void run_ring_benchmarks(void) {
+    static const size_t blocks[] = {16, 64, 256};
+    printf("\nfeed ring, mono s16 block written and read back (cycles, min of %d runs)\n", BENCH_RUNS);
+    printf("  %-6s %9s %9s %9s\n", "frames", "memcpy", "copy", "span");
+    for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); ++b) {
+        printf("  %-6u %9lu %9lu %9lu\n", (unsigned)blocks[b],
+               (unsigned long)time_ring_block(blocks[b], RING_MEMCPY),
+               (unsigned long)time_ring_block(blocks[b], RING_COPY),
+               (unsigned long)time_ring_block(blocks[b], RING_SPAN));
+    }
+    uint32_t fed = time_ring_refill(true), direct = time_ring_refill(false);
+    printf("  %d-sample refill: %lu cycles from the ring, %lu from memory (%.2f / %.2f per sample)\n", BENCH_SAMPLES,
+           (unsigned long)fed, (unsigned long)direct, (double)fed / BENCH_SAMPLES, (double)direct / BENCH_SAMPLES);
+}
+
+// Source: cycles for one BENCH_SAMPLES refill of a mono player reading the
+// clip in place, or pulling it through audio_source_wav(), as u8 frames if
+// the source has them unless narrow is false; min of BENCH_RUNS.
+static uint32_t time_source_refill(const wav_info_t *wav, bool pulled, bool narrow) {
+    static audio_player_t player;
+    static audio_wav_reader_t reader;
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        audio_source_t src = {0};
+        wav_info_t out = *wav;
+        if (pulled) {
+            audio_source_wav(&src, &reader, wav);
+            if (!narrow) {
+                static audio_source_ops_t s16_ops;
+                s16_ops = (audio_source_ops_t){src.ops->read_frames, NULL};
+                src.ops = &s16_ops;
+            }
+            out = audio_source_output(&src);
+        }
+        player = (audio_player_t){.source = src};
+        audio_pwm_dma_prepare(&player, &out);
+        uint32_t start = cycle_counter_read();
+        audio_pwm_dma_fill(&player, buffer_new, BENCH_SAMPLES);
+        uint32_t cycles = cycle_counter_elapsed(start, cycle_counter_read());
+        best = cycles < best ? cycles : best;
+    }
+    return best;
+}
+
+static uint32_t time_tone_refill(void) {
+    static audio_player_t player;
+    static audio_tone_t tone;
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        audio_source_t src;
+        audio_source_tone(&src, &tone, 16000, 1000, 20000, SIZE_MAX);
+        wav_info_t out = audio_source_output(&src);
+        player = (audio_player_t){.source = src};
+        audio_pwm_dma_prepare(&player, &out);
+        uint32_t start = cycle_counter_read();
+        audio_pwm_dma_fill(&player, buffer_new, BENCH_SAMPLES);
+        uint32_t cycles = cycle_counter_elapsed(start, cycle_counter_read());
+        best = cycles < best ? cycles : best;
+    }
+    return best;
+}
+
+static void run_source_benchmarks(void) {
+    static const struct {
+        const char *name;
+        uint16_t bits;
+        wav_encoding_t encoding;
+    } formats[] = {
+        {"u8", 8, WAV_ENCODING_PCM},
+        {"s16", 16, WAV_ENCODING_PCM},
+        {"mu-law", 8, WAV_ENCODING_MULAW},
+    };
+    printf("\nsource, %d-sample mono refill (cycles per sample, min of %d runs)\n", BENCH_SAMPLES, BENCH_RUNS);
+    printf("  %-8s %9s %9s %9s\n", "", "in place", "pulled", "as s16");
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+        const uint8_t *data = formats[f].bits == 16 ? (const uint8_t *)source : source_wide;
+        uint16_t bytes = formats[f].bits / 8u;
+        wav_info_t wav = {data, BENCH_SAMPLES * bytes, 16000, formats[f].bits, 1, false, formats[f].encoding, bytes, 0};
+        printf("  %-8s %9.2f %9.2f %9.2f\n", formats[f].name,
+               (double)time_source_refill(&wav, false, true) / BENCH_SAMPLES,
+               (double)time_source_refill(&wav, true, true) / BENCH_SAMPLES,
+               (double)time_source_refill(&wav, true, false) / BENCH_SAMPLES);
+    }
+    printf("  %-8s %9.2f\n", "tone", (double)time_tone_refill() / BENCH_SAMPLES);
+}
+
+// Mixer: cycles to mix BENCH_SAMPLES mono frames from voices voices of
+// one clip, min of BENCH_RUNS.
+static uint32_t time_mix(const wav_info_t *wav, int voices) {
+    static audio_mixer_t mixer;
+    audio_mixer_init(&mixer, wav->sample_rate, false);
+    for (int v = 0; v < voices; ++v) {
+        audio_mixer_play(&mixer, wav, AUDIO_MIXER_UNITY / 8, 0, true);
+    }
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        uint32_t start = cycle_counter_read();
+        audio_mixer_render(&mixer, (int16_t *)buffer_new, BENCH_SAMPLES);
+        uint32_t cycles = cycle_counter_elapsed(start, cycle_counter_read());
+        best = cycles < best ? cycles : best;
+    }
+    return best;
+}
+
+static void run_mixer_benchmarks(void) {
+    // Voice clips over the same random data; ADPCM as one-channel blocks.
+    for (size_t b = 0; b < 2; ++b) {
+        source_adpcm[b * BENCH_ADPCM_BLOCK + 2] = (uint8_t)(20 + b);
+    }
+    const struct {
+        const char *name;
+        wav_info_t wav;
+    } clips[] = {
+        {"u8", {source_wide, BENCH_SAMPLES, 16000, 8, 1, false, WAV_ENCODING_PCM, 1, 0}},
+        {"s16", {(const uint8_t *)source, BENCH_SAMPLES * 2, 16000, 16, 1, false, WAV_ENCODING_PCM, 2, 0}},
+        {"mulaw", {source_wide, BENCH_SAMPLES, 16000, 8, 1, false, WAV_ENCODING_MULAW, 1, 0}},
+        {"adpcm", {source_adpcm, 2 * BENCH_ADPCM_BLOCK, 16000, 4, 1, false, WAV_ENCODING_IMA_ADPCM, BENCH_ADPCM_BLOCK,
+                   (BENCH_ADPCM_BLOCK - 4u) * 2u + 1u}},
+    };
+    static const int counts[] = {1, 2, 4, 8};
+    uint32_t worst8 = 0;
+    printf("\nmixer, mono mix of looping voices (cycles per output sample, min of %d runs)\n", BENCH_RUNS);
+    printf("  %-6s %8s %8s %8s %8s\n", "voice", "1", "2", "4", "8");
+    for (size_t c = 0; c < sizeof(clips) / sizeof(clips[0]); ++c) {
+        printf("  %-6s", clips[c].name);
+        for (size_t k = 0; k < sizeof(counts) / sizeof(counts[0]); ++k) {
+            uint32_t cycles = time_mix(&clips[c].wav, counts[k]);
+            printf(" %8.2f", (double)cycles / BENCH_SAMPLES);
+            if (counts[k] == 8 && clips[c].wav.encoding != WAV_ENCODING_IMA_ADPCM && cycles > worst8) {
+                worst8 = cycles;
+            }
+        }
+        printf("\n");
+    }
+#if defined(__arm__)
+    // The budget covers PCM and G.711 voices: 8 at 44.1 kHz in 10% of a core.
+    uint32_t clk = clock_get_hz(clk_sys);
+    double share = 100.0 * (double)worst8 * 44100.0 / BENCH_SAMPLES / clk;
+    printf("  8 PCM/G.711 voices at 44.1 kHz: %.1f%% of one core at %lu MHz, %s the 10%% budget\n", share,
+           (unsigned long)(clk / 1000000u), share <= 10.0 ? "within" : "OVER");
+#endif
+}
+
+static void run_benchmarks(void) {
+    uint32_t seed = 0x12345678u;
+    for (size_t i = 0; i < BENCH_SAMPLES * 2; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        source[i] = (int16_t)(seed >> 16);
+        source_f32[i] = (float)source[i] / 32768.0f;
+    }
+    for (size_t i = 0; i < sizeof(source_wide); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        source_wide[i] = (uint8_t)(seed >> 24);
+    }
+    for (size_t i = 0; i < sizeof(source_adpcm); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        source_adpcm[i] = (uint8_t)(seed >> 24);
+    }
+
+    uint32_t qoa_cycles[2] = {0, 0};
+    printf("refill cost per %d-sample buffer (cycles, min / avg of %d runs)\n", BENCH_SAMPLES, BENCH_RUNS);
+    printf("%-14s %17s %17s %8s %10s\n", "format", "per-sample loop", "kernel", "speedup", "cyc/sample");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        const bench_case_t *bc = &cases[c];
+        wav_info_t wav = {
+            .data = bc->is_float ? (const uint8_t *)source_f32
+                    : bc->bits_per_sample > 16 ? source_wide
+                                                : (const uint8_t *)source,
+            .data_size = (size_t)BENCH_SAMPLES * (bc->bits_per_sample / 8) * bc->channels,
+            .sample_rate = 16000,
+            .bits_per_sample = bc->bits_per_sample,
+            .channels = bc->channels,
+            .is_float = bc->is_float,
+            .encoding = bc->encoding,
+        };
+        if (bc->encoding == WAV_ENCODING_IMA_ADPCM) {
+            // Two random blocks with valid step indices in their headers.
+            wav.encoding = WAV_ENCODING_IMA_ADPCM;
+            wav.data = source_adpcm;
+            wav.block_align = (uint16_t)(BENCH_ADPCM_BLOCK * bc->channels);
+            wav.samples_per_block = (uint16_t)((BENCH_ADPCM_BLOCK - 4u) * 2u + 1u);
+            wav.data_size = 2u * wav.block_align;
+            for (size_t b = 0; b < 2; ++b) {
+                for (uint16_t ch = 0; ch < bc->channels; ++ch) {
+                    source_adpcm[b * wav.block_align + 4u * ch + 2] = (uint8_t)(20 + 30 * ch + b);
+                }
+            }
+        }
+
+        if (bc->encoding == WAV_ENCODING_QOA) {
+            // Frame header, then the encoder's starting LMS state per channel.
+            uint8_t *q = source_qoa;
+            uint32_t size = 8u + 16u * bc->channels + BENCH_QOA_SLICES * 8u * bc->channels;
+            uint32_t samples = BENCH_QOA_SLICES * QOA_SLICE_LEN;
+            uint8_t header[8] = {(uint8_t)bc->channels, (uint8_t)(BENCH_QOA_RATE >> 16), (uint8_t)(BENCH_QOA_RATE >> 8),
+                                 (uint8_t)BENCH_QOA_RATE, (uint8_t)(samples >> 8), (uint8_t)samples,
+                                 (uint8_t)(size >> 8), (uint8_t)size};
+            memcpy(q, header, sizeof(header));
+            for (uint16_t ch = 0; ch < bc->channels; ++ch) {
+                static const uint8_t lms[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xe0, 0x00, 0x40, 0x00};
+                memcpy(q + 8 + 16 * ch, lms, sizeof(lms));
+            }
+            for (uint32_t i = 8u + 16u * bc->channels; i < size; ++i) {
+                seed = seed * 1664525u + 1013904223u;
+                q[i] = (uint8_t)(seed >> 24);
+                if ((i - 8u - 16u * bc->channels) % 8u == 0) {
+                    q[i] &= 0x3fu;  // scale factor 0-3
+                }
+            }
+            wav.encoding = WAV_ENCODING_QOA;
+            wav.data = source_qoa;
+            wav.data_size = size;
+            wav.sample_rate = BENCH_QOA_RATE;
+            wav.block_align = (uint16_t)(8u + 16u * bc->channels + 256u * 8u * bc->channels);
+            wav.samples_per_block = QOA_FRAME_LEN;
+        }
+
+        bench_result_t ref = run_case(&wav, bc, true, buffer_ref);
+        bench_result_t opt = run_case(&wav, bc, false, buffer_new);
+        // Dithered output differs from truncation by design.
+        bool match = bc->dither != AUDIO_PWM_DMA_DITHER_NONE || bc->oversample > 1 ||
+                     !memcmp(buffer_ref, buffer_new, sizeof(buffer_ref));
+        printf("%-14s %8lu / %6lu %8lu / %6lu %7.2fx %10.2f%s\n", bc->name, (unsigned long)ref.min,
+               (unsigned long)(ref.total / BENCH_RUNS), (unsigned long)opt.min,
+               (unsigned long)(opt.total / BENCH_RUNS), (double)ref.min / (double)(opt.min ? opt.min : 1),
+               (double)opt.min / BENCH_SAMPLES, match ? "" : "  OUTPUT MISMATCH");
+        if (bc->encoding == WAV_ENCODING_QOA) {
+            qoa_cycles[bc->channels - 1] = opt.min;
+        }
+    }
+
+    // Decode plus conversion for a second of 44.1 kHz audio, from the best
+    // refill time.
+    printf("\nQOA at %u Hz, refill path only:\n", BENCH_QOA_RATE);
+    for (uint ch = 1; ch <= 2; ++ch) {
+        uint64_t per_second = (uint64_t)qoa_cycles[ch - 1] * BENCH_QOA_RATE / BENCH_SAMPLES;
+#if defined(__arm__)
+        uint32_t clk = clock_get_hz(clk_sys);
+        printf("  %-6s %10llu cycles/s, %5.1f%% of one core at %lu MHz\n", ch == 1 ? "mono" : "stereo",
+               (unsigned long long)per_second, 100.0 * (double)per_second / clk, (unsigned long)(clk / 1000000u));
+#else
+        printf("  %-6s %10llu TSC cycles/s\n", ch == 1 ? "mono" : "stereo", (unsigned long long)per_second);
+#endif
+    }
+
+    // Startup: the divider search behind every init and play.
+#if defined(__arm__)
+    uint32_t clk_hz = clock_get_hz(clk_sys);
+#else
+    uint32_t clk_hz = 125000000u;
+#endif
+    static const uint32_t rates[] = {16000, 22050, 44100, 48000};
+    printf("\npace_solve at %lu MHz (cycles, min of 8 runs)\n", (unsigned long)(clk_hz / 1000000u));
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r) {
+        uint32_t best = UINT32_MAX;
+        for (int run = 0; run < 8; ++run) {
+            pace_solution_t pace;
+            uint32_t start = cycle_counter_read();
+            pace_solve(clk_hz, rates[r], true, &pace);
+            uint32_t cycles = cycle_counter_elapsed(start, cycle_counter_read());
+            best = cycles < best ? cycles : best;
+        }
+#if defined(__arm__)
+        printf("  %5lu Hz %9lu cycles, %5lu us\n", (unsigned long)rates[r], (unsigned long)best,
+               (unsigned long)((uint64_t)best * 1000000u / clk_hz));
+#else
+        printf("  %5lu Hz %9lu TSC cycles\n", (unsigned long)rates[r], (unsigned long)best);
+#endif
+    }
+
+    // Clip start: where a bank lookup replaces scanning a RIFF file's chunks.
+    build_bench_clips();
+    printf("\nclip start, %u-clip bank vs RIFF file (cycles, min of %d runs)\n", BENCH_BANK_CLIPS, BENCH_RUNS);
+    printf("  %-26s %9s %9s\n", "", "bank", "RIFF");
+    printf("  %-26s %9lu %9lu\n", "lookup to wav_info_t", (unsigned long)time_clip_start(true, true),
+           (unsigned long)time_clip_start(false, true));
+    printf("  %-26s %9lu %9lu\n", "+ prepare and first refill", (unsigned long)time_clip_start(true, false),
+           (unsigned long)time_clip_start(false, false));
+
+    run_mixer_benchmarks();
+    run_ring_benchmarks();
+    run_source_benchmarks();
+}
+
+int main(void) {
+#if defined(__arm__)
+    stdio_init_all();
+    sleep_ms(2000);
+#endif
+    cycle_counter_init();
+    run_benchmarks();
+#if defined(__arm__)
+    while (true) {
+        tight_loop_contents();
+    }
+#endif
+    return 0;
+}
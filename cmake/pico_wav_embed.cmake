@@ -0,0 +1,119 @@
+# Build-time clip embedding:
+#
+#   pico_wav_embed(<target> NAME <name> FILE <file.wav|file.qoa>
+#                  FORMAT <u8|s16|alaw|mulaw|adpcm|qoa> [RATE <hz>] [MONO])
+#
+# Converts FILE with the host tool wav_embed (host/wav_embed.c) when it
+# changes, and adds to <target> a const wav_info_t <name>, declared in
+# "<name>.h", whose data is the converted samples pulled in with .incbin.
+# Call it once per clip.
+#
+#   pico_sound_bank(<target> NAME <name> MANIFEST <clips.txt>)
+#
+# Packs every clip the manifest lists (one "name file format [RATE hz]
+# [MONO]" per line) into one sound bank with the host tool sound_bank
+# (host/sound_bank_tool.c), and adds to <target> the opened
+# const sound_bank_t <name> and an enum of clip ids, <NAME>_<CLIP>, both
+# declared in "<name>.h". See sound_bank.h.
+#
+# The tools are built from host/tools with the host compiler, which needs
+# only a C compiler (no simulator), or taken from this project when it has
+# targets of the same names.
+
+include_guard(GLOBAL)
+
+set(PICO_WAV_DIR ${CMAKE_CURRENT_LIST_DIR}/..)
+
+# Sets <out_var> to the host tool <tool> (wav_embed or sound_bank) and
+# <dep_var> to what a custom command using it must depend on.
+function(pico_wav_host_tool tool out_var dep_var)
+    if (TARGET ${tool})
+        set(${out_var} $<TARGET_FILE:${tool}> PARENT_SCOPE)
+        set(${dep_var} ${tool} PARENT_SCOPE)
+        return()
+    endif()
+    set(binary_dir ${CMAKE_BINARY_DIR}/pico_wav_embed_host)
+    set(suffix "")
+    if (CMAKE_HOST_WIN32)
+        set(suffix .exe)
+    endif()
+    if (NOT TARGET pico_wav_embed_host)
+        include(ExternalProject)
+        # A separate configure, so the cross toolchain does not apply.
+        ExternalProject_Add(pico_wav_embed_host
+                SOURCE_DIR ${PICO_WAV_DIR}/host/tools
+                BINARY_DIR ${binary_dir}
+                CMAKE_ARGS -DCMAKE_BUILD_TYPE=Release "-DCMAKE_MAKE_PROGRAM:FILEPATH=${CMAKE_MAKE_PROGRAM}"
+                BUILD_COMMAND ${CMAKE_COMMAND} --build <BINARY_DIR> --target wav_embed
+                COMMAND ${CMAKE_COMMAND} --build <BINARY_DIR> --target sound_bank
+                BUILD_BYPRODUCTS ${binary_dir}/wav_embed${suffix} ${binary_dir}/sound_bank${suffix}
+                BUILD_ALWAYS 1
+                INSTALL_COMMAND "")
+    endif()
+    set(${out_var} ${binary_dir}/${tool}${suffix} PARENT_SCOPE)
+    set(${dep_var} pico_wav_embed_host ${binary_dir}/${tool}${suffix} PARENT_SCOPE)
+endfunction()
+
+function(pico_wav_embed target)
+    cmake_parse_arguments(PARSE_ARGV 1 EMBED "MONO" "NAME;FILE;FORMAT;RATE" "")
+    if (NOT EMBED_NAME OR NOT EMBED_FILE OR NOT EMBED_FORMAT)
+        message(FATAL_ERROR "pico_wav_embed: NAME, FILE and FORMAT are required")
+    endif()
+    get_filename_component(file ${EMBED_FILE} ABSOLUTE BASE_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+    set(out_dir ${CMAKE_CURRENT_BINARY_DIR}/embedded_clips)
+    set(args --name ${EMBED_NAME} --format ${EMBED_FORMAT})
+    if (EMBED_RATE)
+        list(APPEND args --rate ${EMBED_RATE})
+    endif()
+    if (EMBED_MONO)
+        list(APPEND args --mono)
+    endif()
+
+    pico_wav_host_tool(wav_embed tool tool_deps)
+    file(MAKE_DIRECTORY ${out_dir})
+    add_custom_command(
+            OUTPUT ${out_dir}/${EMBED_NAME}.c ${out_dir}/${EMBED_NAME}.h ${out_dir}/${EMBED_NAME}.bin
+            COMMAND ${tool} ${args} ${file} ${out_dir}
+            DEPENDS ${file} ${tool_deps}
+            COMMENT "Embedding ${EMBED_FILE} as ${EMBED_NAME} (${EMBED_FORMAT})"
+            VERBATIM)
+    target_sources(${target} PRIVATE ${out_dir}/${EMBED_NAME}.c)
+    target_include_directories(${target} PRIVATE ${out_dir} ${PICO_WAV_DIR})
+endfunction()
+
+function(pico_sound_bank target)
+    cmake_parse_arguments(PARSE_ARGV 1 BANK "" "NAME;MANIFEST" "")
+    if (NOT BANK_NAME OR NOT BANK_MANIFEST)
+        message(FATAL_ERROR "pico_sound_bank: NAME and MANIFEST are required")
+    endif()
+    get_filename_component(manifest ${BANK_MANIFEST} ABSOLUTE BASE_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+    get_filename_component(manifest_dir ${manifest} DIRECTORY)
+    set(out_dir ${CMAKE_CURRENT_BINARY_DIR}/embedded_clips)
+
+    # The bank depends on every clip's file, so read them from the manifest
+    # now, and again whenever it changes.
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${manifest})
+    file(STRINGS ${manifest} lines)
+    set(clip_files "")
+    foreach (line IN LISTS lines)
+        string(REGEX REPLACE "#.*" "" line "${line}")
+        separate_arguments(fields UNIX_COMMAND "${line}")
+        list(LENGTH fields count)
+        if (count GREATER 1)
+            list(GET fields 1 clip_file)
+            get_filename_component(clip_file ${clip_file} ABSOLUTE BASE_DIR ${manifest_dir})
+            list(APPEND clip_files ${clip_file})
+        endif()
+    endforeach()
+
+    pico_wav_host_tool(sound_bank tool tool_deps)
+    file(MAKE_DIRECTORY ${out_dir})
+    add_custom_command(
+            OUTPUT ${out_dir}/${BANK_NAME}.c ${out_dir}/${BANK_NAME}.h ${out_dir}/${BANK_NAME}.bin
+            COMMAND ${tool} build --name ${BANK_NAME} ${manifest} ${out_dir}
+            DEPENDS ${manifest} ${clip_files} ${tool_deps}
+            COMMENT "Building sound bank ${BANK_NAME} from ${BANK_MANIFEST}"
+            VERBATIM)
+    target_sources(${target} PRIVATE ${out_dir}/${BANK_NAME}.c)
+    target_include_directories(${target} PRIVATE ${out_dir} ${PICO_WAV_DIR})
+endfunction()
@@ -0,0 +1,61 @@
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <stdint.h>
+
+// Free-running cycle counter for benchmarks and ISR timing. On target this is
+// SysTick counting clk_sys (present on both RP2040 and RP2350); on an x86
+// host it is the CPU timestamp counter, elsewhere the monotonic clock in ns.
+#if defined(__arm__)
+#include "hardware/structs/systick.h"
+
+// Starts SysTick as a free-running 24-bit counter unless it is already
+// running, in which case its owner's reload and clock are left alone.
+static inline void cycle_counter_init(void) {
+    if (systick_hw->csr & 0x1u) {
+        return;
+    }
+    systick_hw->rvr = 0x00ffffffu;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5u; // enable, clocked from the processor clock
+}
+
+static inline uint32_t cycle_counter_read(void) {
+    return systick_hw->cvr;
+}
+
+// SysTick counts down and wraps from its reload value to zero.
+static inline uint32_t cycle_counter_elapsed(uint32_t start, uint32_t end) {
+    return end <= start ? start - end : start + (systick_hw->rvr & 0x00ffffffu) + 1u - end;
+}
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+
+static inline void cycle_counter_init(void) {
+}
+
+static inline uint32_t cycle_counter_read(void) {
+    return (uint32_t)__rdtsc();
+}
+
+static inline uint32_t cycle_counter_elapsed(uint32_t start, uint32_t end) {
+    return end - start;
+}
+#else
+#include <time.h>
+
+static inline void cycle_counter_init(void) {
+}
+
+static inline uint32_t cycle_counter_read(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+static inline uint32_t cycle_counter_elapsed(uint32_t start, uint32_t end) {
+    return end - start;
+}
+#endif
+
+#endif
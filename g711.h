@@ -0,0 +1,14 @@
+#ifndef G711_H
+#define G711_H
+
+#include <stdint.h>
+
+// G.711 mu-law (WAV format 7) and A-law (format 6) expansion, one table
+// lookup per sample: to s16 for dither, sigma-delta and mixing, or straight
+// to the truncated 8-bit PWM level.
+extern const int16_t g711_ulaw_to_s16[256];
+extern const int16_t g711_alaw_to_s16[256];
+extern const uint8_t g711_ulaw_to_level[256];
+extern const uint8_t g711_alaw_to_level[256];
+
+#endif
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ima_adpcm_ref.h"
+#include "sim_hw.h"
+#include "wav.h"
+#include "wav_io.h"
+
+// Converts an 8/16-bit PCM WAV to IMA ADPCM (format 0x11), a quarter of the
+// 16-bit size, for the player to decode on the fly.
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: adpcm_encode [--block BYTES] in.wav out.wav\n"
+            "  --block BYTES  block size per channel, a multiple of 4 (default 512)\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    uint32_t block = 512;
+    const char *paths[2] = {0};
+    int npaths = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--block") && i + 1 < argc) {
+            block = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (argv[i][0] != '-' && npaths < 2) {
+            paths[npaths++] = argv[i];
+        } else {
+            usage();
+        }
+    }
+    if (npaths != 2 || block < 8 || block % 4 || block > 8192) {
+        usage();
+    }
+
+    sim_hw_reset(125000000u);
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(paths[0], &length);
+    wav_info_t wav = {0};
+    if (!file || !parse_wav(file, length, &wav) || wav.encoding != WAV_ENCODING_PCM || wav.is_float ||
+        wav.bits_per_sample > 16) {
+        fprintf(stderr, "%s: not an 8/16-bit PCM WAV\n", paths[0]);
+        return 1;
+    }
+
+    size_t frames = wav_frame_count(&wav);
+    size_t samples = frames * wav.channels;
+    int16_t *pcm = malloc(samples * sizeof(*pcm));
+    if (!pcm) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < samples; ++i) {
+        pcm[i] = wav.bits_per_sample == 8 ? (int16_t)((wav.data[i] - 128) * 256)
+                                           : (int16_t)(wav.data[2 * i] | (wav.data[2 * i + 1] << 8));
+    }
+
+    uint16_t block_align = (uint16_t)(block * wav.channels);
+    size_t size = 0;
+    uint8_t *blocks = ima_ref_encode(pcm, frames, wav.channels, block_align, &size);
+    wav_info_t check = {.data = blocks, .data_size = size, .channels = wav.channels, .block_align = block_align,
+                        .encoding = WAV_ENCODING_IMA_ADPCM};
+    check.samples_per_block = (uint16_t)((block_align - 4u * wav.channels) * 2u / wav.channels + 1u);
+    size_t kept = wav_frame_count(&check);
+    if (!blocks ||
+        !wav_io_write_ima_adpcm(paths[1], blocks, size, kept, wav.sample_rate, wav.channels, block_align)) {
+        fprintf(stderr, "%s: write failed\n", paths[1]);
+        return 1;
+    }
+    printf("%zu frames -> %zu (%u-byte blocks), %zu -> %zu data bytes\n", frames, kept, block_align,
+           wav.data_size, size);
+    free(blocks);
+    free(pcm);
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_pwm_dma.h"
+#include "capture.h"
+#include "sim_hw.h"
+#include "sound_bank.h"
+#include "sound_bank_writer.h"
+#include "test_bank.h"
+#include "wav.h"
+#include "wav_convert.h"
+#include "wav_io.h"
+
+// Checks sound banks: the bank host/CMakeLists.txt builds from
+// bank_check.txt must describe and hold the same clips as the same
+// conversions done here, and play exactly like them; a bank of many clips
+// written here must give each back unchanged and word-aligned; and damaged
+// banks or entries must be refused. Exits non-zero on any failure.
+
+#define CHUNK 256u
+#define MANY_CLIPS 500u
+
+typedef struct {
+    const char *name;
+    uint32_t id;
+    wav_convert_options_t options;
+} bank_case_t;
+
+// Mirrors bank_check.txt.
+static const bank_case_t cases[] = {
+    {"u8", TEST_BANK_PROMPT_U8, {WAV_CONVERT_U8, 0, false}},
+    {"s16", TEST_BANK_PROMPT_S16, {WAV_CONVERT_S16, 0, false}},
+    {"mulaw 16k", TEST_BANK_PROMPT_MULAW, {WAV_CONVERT_MULAW, 16000, false}},
+    {"alaw 8k", TEST_BANK_PROMPT_ALAW, {WAV_CONVERT_ALAW, 8000, false}},
+    {"adpcm", TEST_BANK_PROMPT_ADPCM, {WAV_CONVERT_IMA_ADPCM, 0, false}},
+    {"qoa 44.1k", TEST_BANK_PROMPT_QOA, {WAV_CONVERT_QOA, 44100, false}},
+    {"mono 22k", TEST_BANK_PROMPT_MONO, {WAV_CONVERT_S16, 22050, true}},
+};
+
+static bool same_clip(const wav_info_t *a, const wav_info_t *b) {
+    return same_description(a, b) && !memcmp(a->data, b->data, a->data_size);
+}
+
+// Plays a clip through the refill path, frames plus a buffer past the end.
+static uint16_t *render(const wav_info_t *wav, size_t *count) {
+    static audio_player_t player;
+    memset(&player, 0, sizeof(player));
+    if (!audio_pwm_dma_prepare(&player, wav)) {
+        return NULL;
+    }
+    size_t n = (wav_frame_count(wav) / CHUNK + 2) * CHUNK;
+    uint16_t *out = malloc(n * sizeof(*out));
+    for (size_t i = 0; out && i < n; i += CHUNK) {
+        audio_pwm_dma_fill(&player, out + i, CHUNK);
+    }
+    *count = n;
+    return out;
+}
+
+// The bank built at build time against the same conversions of sample.wav.
+static bool check_embedded(const wav_info_t *source) {
+    bool ok = test_bank.count == TEST_BANK_COUNT && TEST_BANK_COUNT == sizeof(cases) / sizeof(cases[0]);
+    printf("%-10s %4s %8s %6s %8s %7s %9s  %s\n", "clip", "id", "frames", "rate", "bytes", "aligned", "same data",
+           "plays");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        const bank_case_t *c = &cases[i];
+        wav_info_t got = {0}, expect = {0};
+        uint8_t *converted = wav_convert(source, &c->options, &expect);
+        if (!converted || !sound_bank_get(&test_bank, c->id, &got)) {
+            printf("%-10s %4u lookup or conversion FAILED\n", c->name, (unsigned)c->id);
+            free(converted);
+            ok = false;
+            continue;
+        }
+        bool aligned = ((uintptr_t)got.data & 3u) == 0;
+        bool same = same_clip(&got, &expect);
+
+        // The run-time copy must live in bus-addressable memory to play.
+        uint8_t *copy = sim_hw_alloc(expect.data_size);
+        memcpy(copy, expect.data, expect.data_size);
+        expect.data = copy;
+        size_t n = 0, m = 0;
+        uint16_t *played = render(&got, &n);
+        uint16_t *want = render(&expect, &m);
+        bool plays = played && want && n == m && !memcmp(played, want, n * sizeof(*played));
+
+        printf("%-10s %4u %8zu %6u %8zu %7s %9s  %s\n", c->name, (unsigned)c->id, wav_frame_count(&got),
+               (unsigned)got.sample_rate, got.data_size, aligned ? "yes" : "NO", same ? "yes" : "NO",
+               plays ? "ok" : "FAILED");
+        ok = ok && aligned && same && plays;
+        free(played);
+        free(want);
+        free(converted);
+    }
+    return ok;
+}
+
+// Many clips of every format, cut from the source at varying lengths, so
+// payloads start at every alignment before padding.
+static bool check_many(const wav_info_t *source) {
+    static const wav_convert_format_t formats[] = {
+        WAV_CONVERT_U8, WAV_CONVERT_S16, WAV_CONVERT_ALAW, WAV_CONVERT_MULAW, WAV_CONVERT_IMA_ADPCM, WAV_CONVERT_QOA,
+    };
+    static wav_info_t clips[MANY_CLIPS];
+    static uint8_t *buffers[MANY_CLIPS];
+    for (size_t i = 0; i < MANY_CLIPS; ++i) {
+        wav_info_t cut = *source;
+        size_t frames = 64u + (i * 37u) % 1500u;
+        size_t frame_bytes = (size_t)source->channels * source->bits_per_sample / 8u;
+        cut.data_size = frames * frame_bytes < source->data_size ? frames * frame_bytes : source->data_size;
+        wav_convert_options_t options = {formats[i % 6u], i % 5u == 0 ? 16000u : 0u, i % 3u == 0};
+        if (!(buffers[i] = wav_convert(&cut, &options, &clips[i]))) {
+            printf("clip %zu: conversion FAILED\n", i);
+            return false;
+        }
+    }
+    size_t size = 0;
+    uint8_t *bank_data = sound_bank_write(clips, MANY_CLIPS, &size);
+    sound_bank_t bank;
+    if (!bank_data || !sound_bank_open(&bank, bank_data, size) || bank.count != MANY_CLIPS) {
+        printf("%u-clip bank: open FAILED\n", MANY_CLIPS);
+        return false;
+    }
+    size_t bad = 0;
+    for (uint32_t id = 0; id < MANY_CLIPS; ++id) {
+        wav_info_t got;
+        if (!sound_bank_get(&bank, id, &got) || !same_clip(&got, &clips[id]) ||
+            ((uintptr_t)(got.data - bank_data) & 3u) != 0) {
+            ++bad;
+        }
+    }
+    wav_info_t past;
+    bool refuses_past = !sound_bank_get(&bank, MANY_CLIPS, &past);
+    printf("%u-clip bank, %zu bytes: %zu bad lookups, id %u %s\n", MANY_CLIPS, size, bad, MANY_CLIPS,
+           refuses_past ? "refused" : "NOT REFUSED");
+    free(bank_data);
+    for (size_t i = 0; i < MANY_CLIPS; ++i) {
+        free(buffers[i]);
+    }
+    return bad == 0 && refuses_past;
+}
+
+static void put_u32_le(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+typedef enum { DAMAGE_OPEN, DAMAGE_ENTRY } damage_kind_t;
+
+// Damaged copies of a bank of the s16 mono source, an ADPCM, a QOA and a
+// mu-law clip, then the source again; each must fail to open, or fail to
+// look up the damaged entry while the first still works.
+static bool check_damaged(const wav_info_t *source) {
+    wav_info_t clips[5] = {*source, [4] = *source};
+    wav_convert_options_t adpcm = {WAV_CONVERT_IMA_ADPCM, 0, false}, qoa = {WAV_CONVERT_QOA, 0, false};
+    wav_convert_options_t mulaw = {WAV_CONVERT_MULAW, 0, false};
+    uint8_t *adpcm_data = wav_convert(source, &adpcm, &clips[1]);
+    uint8_t *qoa_data = wav_convert(source, &qoa, &clips[2]);
+    uint8_t *mulaw_data = wav_convert(source, &mulaw, &clips[3]);
+    size_t size = 0;
+    uint8_t *good = adpcm_data && qoa_data && mulaw_data ? sound_bank_write(clips, 5, &size) : NULL;
+    uint8_t *bad = malloc(size);
+    free(adpcm_data);
+    free(qoa_data);
+    free(mulaw_data);
+    if (!good || !bad) {
+        return false;
+    }
+    const uint8_t *entry1 = good + SOUND_BANK_HEADER_SIZE + SOUND_BANK_ENTRY_SIZE;
+    uint32_t offset1 = entry1[0] | entry1[1] << 8 | entry1[2] << 16 | (uint32_t)entry1[3] << 24;
+    static const struct {
+        const char *name;
+        damage_kind_t kind;
+        uint32_t id;
+        size_t at;
+        int width;
+        uint32_t value;
+    } damage[] = {
+        {"bad magic", DAMAGE_OPEN, 0, 0, 1, 'R'},
+        {"newer version", DAMAGE_OPEN, 0, 4, 1, SOUND_BANK_VERSION + 1u},
+        {"other entry size", DAMAGE_OPEN, 0, 6, 1, SOUND_BANK_ENTRY_SIZE + 4u},
+        {"count past end", DAMAGE_OPEN, 0, 8, 4, 0x10000000u},
+        {"index in header", DAMAGE_OPEN, 0, 12, 4, 8},
+        {"data past end", DAMAGE_ENTRY, 1, 36, 4, 0xfffffff0u},
+        {"size past end", DAMAGE_ENTRY, 1, 40, 4, 0xfffffff0u},
+        {"3 channels", DAMAGE_ENTRY, 1, 53, 1, 3},
+        {"unknown encoding", DAMAGE_ENTRY, 1, 52, 1, 9},
+        {"adpcm no block", DAMAGE_ENTRY, 1, 48, 2, 0},
+        {"adpcm no frames", DAMAGE_ENTRY, 1, 50, 2, 0},
+        {"qoa no frame", DAMAGE_ENTRY, 2, 68, 2, 0},
+        {"qoa no samples", DAMAGE_ENTRY, 2, 70, 2, 0},
+        {"mulaw 16 bits", DAMAGE_ENTRY, 3, 94, 1, 16},
+        {"pcm 0 bits", DAMAGE_ENTRY, 4, 114, 1, 0},
+        {"pcm 12 bits", DAMAGE_ENTRY, 4, 114, 1, 12},
+        {"float 16 bits", DAMAGE_ENTRY, 4, 115, 1, 1},
+        {"zero rate", DAMAGE_ENTRY, 4, 104, 4, 0},
+        {"part frame", DAMAGE_ENTRY, 4, 100, 4, 3},
+    };
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(damage) / sizeof(damage[0]); ++i) {
+        memcpy(bad, good, size);
+        if (damage[i].width == 4) {
+            put_u32_le(bad + damage[i].at, damage[i].value);
+        } else if (damage[i].width == 2) {
+            bad[damage[i].at] = (uint8_t)damage[i].value;
+            bad[damage[i].at + 1] = (uint8_t)(damage[i].value >> 8);
+        } else {
+            bad[damage[i].at] = (uint8_t)damage[i].value;
+        }
+        sound_bank_t bank;
+        wav_info_t info;
+        bool opened = sound_bank_open(&bank, bad, size);
+        bool refused = damage[i].kind == DAMAGE_OPEN
+                           ? !opened
+                           : opened && !sound_bank_get(&bank, damage[i].id, &info) && sound_bank_get(&bank, 0, &info);
+        printf("%-17s %s\n", damage[i].name, refused ? "refused" : "NOT REFUSED");
+        ok = ok && refused;
+    }
+
+    // Cut off inside the index, then inside the last clip's data.
+    sound_bank_t bank;
+    wav_info_t info;
+    bool short_index = !sound_bank_open(&bank, good, SOUND_BANK_HEADER_SIZE + SOUND_BANK_ENTRY_SIZE + 4u);
+    bool short_data = sound_bank_open(&bank, good, offset1 + 4u) && !sound_bank_get(&bank, 1, &info);
+    printf("%-17s %s\n%-17s %s\n", "short index", short_index ? "refused" : "NOT REFUSED", "short data",
+           short_data ? "refused" : "NOT REFUSED");
+    free(good);
+    free(bad);
+    return ok && short_index && short_data;
+}
+
+int main(void) {
+    sim_hw_reset(125000000u);
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(EMBED_SOURCE, &length);
+    wav_info_t source = {0};
+    if (!file || !parse_wav(file, length, &source)) {
+        fprintf(stderr, "%s: cannot load\n", EMBED_SOURCE);
+        return 1;
+    }
+
+    bool ok = check_embedded(&source);
+    ok = check_many(&source) && ok;
+    ok = check_damaged(&source) && ok;
+    printf("%s\n", ok ? "bank checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
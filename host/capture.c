@@ -0,0 +1,70 @@
+#include "capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_hw.h"
+
+void capture_cc(void *ctx, uint slice, uint32_t cc, uint64_t cycle) {
+    capture_t *cap = ctx;
+    if (!cap->armed || slice != cap->slice) {
+        return;
+    }
+    if (cap->count == cap->capacity) {
+        cap->capacity = cap->capacity ? cap->capacity * 2 : 65536;
+        cap->levels = realloc(cap->levels, cap->capacity * sizeof(*cap->levels));
+        cap->cycles = realloc(cap->cycles, cap->capacity * sizeof(*cap->cycles));
+        if (!cap->levels || !cap->cycles) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    cap->cycles[cap->count] = cycle;
+    cap->levels[cap->count++] = cap->whole ? cc : (uint16_t)(cc >> (16u * cap->channel));
+}
+
+void capture_free(capture_t *cap) {
+    free(cap->levels);
+    free(cap->cycles);
+    cap->levels = NULL;
+    cap->cycles = NULL;
+    cap->count = 0;
+    cap->capacity = 0;
+}
+
+size_t capture_audible_length(const capture_t *cap, uint32_t rest) {
+    size_t n = cap->count;
+    while (n && cap->levels[n - 1] == rest) {
+        --n;
+    }
+    return n;
+}
+
+bool same_description(const wav_info_t *a, const wav_info_t *b) {
+    return a->data_size == b->data_size && a->sample_rate == b->sample_rate &&
+           a->bits_per_sample == b->bits_per_sample && a->channels == b->channels && a->is_float == b->is_float &&
+           a->encoding == b->encoding && a->block_align == b->block_align &&
+           a->samples_per_block == b->samples_per_block;
+}
+
+wav_info_t make_pcm_clip(const int16_t *pcm, size_t frames, uint32_t rate, uint16_t bits, uint16_t channels) {
+    size_t samples = frames * channels;
+    size_t bytes = bits / 8u;
+    uint8_t *data = sim_hw_alloc(samples * bytes);
+    for (size_t i = 0; i < samples; ++i) {
+        if (bytes == 1) {
+            data[i] = (uint8_t)((pcm[i] >> 8) + 128);
+        } else {
+            memcpy(data + 2 * i, &pcm[i], 2);
+        }
+    }
+    return (wav_info_t){
+        .data = data,
+        .data_size = samples * bytes,
+        .sample_rate = rate,
+        .bits_per_sample = bits,
+        .channels = channels,
+        .block_align = (uint16_t)(bytes * channels),
+    };
+}
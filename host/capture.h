@@ -0,0 +1,40 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pico/types.h"
+#include "wav.h"
+
+// The CC writes to one PWM slice, recorded by passing capture_cc() and the
+// capture to sim_hw_set_cc_hook().
+typedef struct {
+    uint slice;        // writes to other slices are ignored
+    uint channel;      // the half of CC kept as the level: 0 for A, 1 for B
+    bool whole;        // keep the whole CC value instead, both halves
+    bool armed;        // nothing is recorded until set
+    uint32_t *levels;  // one per write
+    uint64_t *cycles;  // the cycle of each write
+    size_t count;
+    size_t capacity;
+} capture_t;
+
+void capture_cc(void *ctx, uint slice, uint32_t cc, uint64_t cycle);
+
+// Frees the recorded writes and empties the capture, keeping its settings.
+void capture_free(capture_t *cap);
+
+// The count without the trailing run of rest, the level the output holds
+// once playback has ended.
+size_t capture_audible_length(const capture_t *cap, uint32_t rest);
+
+// Whether two clips carry the same format and data size.
+bool same_description(const wav_info_t *a, const wav_info_t *b);
+
+// A PCM clip in simulator memory holding frames of interleaved pcm, as
+// 16-bit signed or, with bits 8, its top bytes as 8-bit unsigned.
+wav_info_t make_pcm_clip(const int16_t *pcm, size_t frames, uint32_t rate, uint16_t bits, uint16_t channels);
+
+#endif
@@ -0,0 +1,184 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_pwm_dma.h"
+
+// Requantizes a sine sweep at several levels through the refill path with
+// each dither mode and measures the 8-bit output with an FFT: SNR, THD+N
+// over the whole band and below fs/8 (where the RC filter passes and noise
+// shaping moves the noise out of), and the worst harmonic. Exits non-zero if
+// dither fails to decorrelate quiet signals or shaping fails to lower the
+// in-band floor.
+
+#define RATE 44100u
+#define N 16384u
+#define CHUNK 256u
+#define HARMONICS 9u
+
+static const double freqs_hz[] = {100.0, 500.0, 1000.0, 2500.0, 5000.0};
+static const double levels_dbfs[] = {-6.0, -40.0, -60.0};
+static const char *const mode_names[] = {"trunc", "tpdf", "shaped1", "shaped2"};
+
+#define MODES (sizeof(mode_names) / sizeof(mode_names[0]))
+
+typedef struct {
+    double snr_db;
+    double thdn_db;
+    double thdn_band_db;
+    double worst_harmonic_db;  // above fs/8, shaped noise dominates these bins
+    double fundamental_db;
+} metrics_t;
+
+static double re[N], im[N];
+
+// In-place iterative radix-2 FFT.
+static void fft(double *xr, double *xi, size_t n) {
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            double t = xr[i];
+            xr[i] = xr[j];
+            xr[j] = t;
+            t = xi[i];
+            xi[i] = xi[j];
+            xi[j] = t;
+        }
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        double ang = -2.0 * M_PI / (double)len;
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t k = 0; k < len / 2; ++k) {
+                double wr = cos(ang * (double)k), wi = sin(ang * (double)k);
+                size_t a = i + k, b = i + k + len / 2;
+                double br = xr[b] * wr - xi[b] * wi;
+                double bi = xr[b] * wi + xi[b] * wr;
+                xr[b] = xr[a] - br;
+                xi[b] = xi[a] - bi;
+                xr[a] += br;
+                xi[a] += bi;
+            }
+        }
+    }
+}
+
+static double db(double ratio) {
+    return 10.0 * log10(ratio > 1e-30 ? ratio : 1e-30);
+}
+
+// Harmonic h of bin k, folded back into 0..N/2 as the sampled signal aliases.
+static size_t harmonic_bin(size_t k, size_t h) {
+    size_t b = (k * h) % N;
+    return b > N / 2 ? N - b : b;
+}
+
+static metrics_t analyse(const uint16_t *levels, size_t bin) {
+    for (size_t i = 0; i < N; ++i) {
+        re[i] = (double)levels[i] - 128.0;
+        im[i] = 0.0;
+    }
+    fft(re, im, N);
+
+    size_t band = N / 8u;
+    double sig = 0, harm = 0, worst = 0, total = 0, total_band = 0;
+    for (size_t b = 1; b <= N / 2; ++b) {
+        double p = re[b] * re[b] + im[b] * im[b];
+        total += p;
+        if (b <= band) {
+            total_band += p;
+        }
+    }
+    sig = re[bin] * re[bin] + im[bin] * im[bin];
+    for (size_t h = 2; h <= HARMONICS; ++h) {
+        size_t b = harmonic_bin(bin, h);
+        if (b == 0 || b == bin) {
+            continue;
+        }
+        double p = re[b] * re[b] + im[b] * im[b];
+        harm += p;
+        if (p > worst) {
+            worst = p;
+        }
+    }
+    double noise = total - sig - harm;
+    return (metrics_t){
+        .snr_db = db(sig / noise),
+        .thdn_db = db((total - sig) / sig),
+        .thdn_band_db = db((total_band - sig) / sig),
+        .worst_harmonic_db = db(worst / sig),
+        // Full scale is a 128-level amplitude: N/2 * 128 in the FFT bin.
+        .fundamental_db = db(sig / ((double)N * N / 4.0 * 128.0 * 128.0)),
+    };
+}
+
+// Plays the sine through a player's refill path, one DMA-buffer-sized chunk
+// at a time so dither state carries across refills as it does on target.
+static void render(const int16_t *pcm, audio_pwm_dma_dither_t dither, uint16_t *out) {
+    static audio_player_t player;
+    wav_info_t wav = {.data = (const uint8_t *)pcm, .data_size = N * sizeof(int16_t), .sample_rate = RATE,
+                      .bits_per_sample = 16, .channels = 1};
+    memset(&player, 0, sizeof(player));
+    player.dither = dither;
+    if (!audio_pwm_dma_prepare(&player, &wav)) {
+        fprintf(stderr, "prepare failed\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < N; i += CHUNK) {
+        audio_pwm_dma_fill(&player, out + i, CHUNK);
+    }
+}
+
+int main(void) {
+    static int16_t pcm[N];
+    static uint16_t out[N];
+    bool ok = true;
+
+    printf("fs %u Hz, %u-point FFT, in-band is below fs/8 (%.0f Hz); dB relative to the fundamental\n", RATE, N,
+           RATE / 8.0);
+    printf("%8s %7s %-8s %8s %9s %11s %10s %9s\n", "freq Hz", "dBFS", "mode", "SNR", "THD+N", "THD+N band",
+           "worst harm", "out dBFS");
+    for (size_t l = 0; l < sizeof(levels_dbfs) / sizeof(levels_dbfs[0]); ++l) {
+        for (size_t f = 0; f < sizeof(freqs_hz) / sizeof(freqs_hz[0]); ++f) {
+            // Coherent odd bin, so the tone is periodic in the window.
+            size_t bin = (size_t)(freqs_hz[f] * N / RATE) | 1u;
+            double amplitude = 32767.0 * pow(10.0, levels_dbfs[l] / 20.0);
+            for (size_t i = 0; i < N; ++i) {
+                pcm[i] = (int16_t)lrint(amplitude * sin(2.0 * M_PI * (double)bin * (double)i / N));
+            }
+
+            metrics_t m[MODES];
+            for (size_t mode = 0; mode < MODES; ++mode) {
+                render(pcm, (audio_pwm_dma_dither_t)mode, out);
+                m[mode] = analyse(out, bin);
+                printf("%8.0f %7.0f %-8s %8.1f %9.1f %11.1f %10.1f %9.1f\n", (double)bin * RATE / N,
+                       levels_dbfs[l], mode_names[mode], m[mode].snr_db, m[mode].thdn_db, m[mode].thdn_band_db,
+                       m[mode].worst_harmonic_db, m[mode].fundamental_db);
+            }
+
+            // Quiet tones: dither must bury the truncation harmonics and keep
+            // the fundamental; shaping must lower the in-band floor further.
+            if (levels_dbfs[l] <= -40.0) {
+                bool decorrelated = m[AUDIO_PWM_DMA_DITHER_TPDF].worst_harmonic_db + 6.0 <
+                                    m[AUDIO_PWM_DMA_DITHER_NONE].worst_harmonic_db;
+                bool kept = fabs(m[AUDIO_PWM_DMA_DITHER_TPDF].fundamental_db - levels_dbfs[l]) < 1.5;
+                bool shaped = m[AUDIO_PWM_DMA_DITHER_SHAPED2].thdn_band_db <
+                              m[AUDIO_PWM_DMA_DITHER_SHAPED1].thdn_band_db &&
+                              m[AUDIO_PWM_DMA_DITHER_SHAPED1].thdn_band_db < m[AUDIO_PWM_DMA_DITHER_TPDF].thdn_band_db;
+                if (!decorrelated || !kept || !shaped) {
+                    printf("  CHECK FAILED:%s%s%s\n", decorrelated ? "" : " harmonics", kept ? "" : " level",
+                           shaped ? "" : " shaping");
+                    ok = false;
+                }
+            }
+        }
+        printf("\n");
+    }
+
+    printf("%s\n", ok ? "dither and noise shaping checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
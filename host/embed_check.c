@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_pwm_dma.h"
+#include "capture.h"
+#include "clip_adpcm.h"
+#include "clip_alaw.h"
+#include "clip_mulaw.h"
+#include "clip_qoa.h"
+#include "clip_s16.h"
+#include "clip_u8.h"
+#include "sim_hw.h"
+#include "wav.h"
+#include "wav_convert.h"
+#include "wav_io.h"
+
+// Checks pico_wav_embed(): the clips host/CMakeLists.txt embeds from
+// sample.wav at build time must carry the same description and bytes as
+// the same conversion of the file done here, be word-aligned, and play
+// exactly like it. Exits non-zero on any failure.
+
+#define CHUNK 256u
+
+typedef struct {
+    const char *name;
+    const wav_info_t *clip;
+    wav_convert_options_t options;
+} embed_case_t;
+
+static const embed_case_t cases[] = {
+    {"u8", &clip_u8, {WAV_CONVERT_U8, 0, false}},
+    {"s16", &clip_s16, {WAV_CONVERT_S16, 0, false}},
+    {"mulaw 16k", &clip_mulaw, {WAV_CONVERT_MULAW, 16000, false}},
+    {"alaw 8k", &clip_alaw, {WAV_CONVERT_ALAW, 8000, false}},
+    {"adpcm", &clip_adpcm, {WAV_CONVERT_IMA_ADPCM, 0, false}},
+    {"qoa 44.1k", &clip_qoa, {WAV_CONVERT_QOA, 44100, false}},
+};
+
+// Plays a clip through the refill path, frames plus a buffer past the end.
+static uint16_t *render(const wav_info_t *wav, size_t *count) {
+    static audio_player_t player;
+    memset(&player, 0, sizeof(player));
+    if (!audio_pwm_dma_prepare(&player, wav)) {
+        return NULL;
+    }
+    size_t n = (wav_frame_count(wav) / CHUNK + 2) * CHUNK;
+    uint16_t *out = malloc(n * sizeof(*out));
+    for (size_t i = 0; out && i < n; i += CHUNK) {
+        audio_pwm_dma_fill(&player, out + i, CHUNK);
+    }
+    *count = n;
+    return out;
+}
+
+int main(void) {
+    sim_hw_reset(125000000u);
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(EMBED_SOURCE, &length);
+    wav_info_t source = {0};
+    if (!file || !parse_wav(file, length, &source)) {
+        fprintf(stderr, "%s: cannot load\n", EMBED_SOURCE);
+        return 1;
+    }
+
+    bool ok = true;
+    printf("%-10s %8s %6s %8s %7s %9s  %s\n", "clip", "frames", "rate", "bytes", "aligned", "same data", "plays");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        const embed_case_t *c = &cases[i];
+        wav_info_t expect = {0};
+        uint8_t *converted = wav_convert(&source, &c->options, &expect);
+        if (!converted) {
+            fprintf(stderr, "%s: conversion failed\n", c->name);
+            return 1;
+        }
+        bool aligned = ((uintptr_t)c->clip->data & 3u) == 0;
+        bool same = same_description(c->clip, &expect) && !memcmp(c->clip->data, expect.data, expect.data_size);
+
+        // The run-time copy must live in bus-addressable memory to play.
+        uint8_t *copy = sim_hw_alloc(expect.data_size);
+        memcpy(copy, expect.data, expect.data_size);
+        expect.data = copy;
+        size_t n = 0, m = 0;
+        uint16_t *got = render(c->clip, &n);
+        uint16_t *want = render(&expect, &m);
+        bool plays = got && want && n == m && !memcmp(got, want, n * sizeof(*got));
+
+        printf("%-10s %8zu %6u %8zu %7s %9s  %s\n", c->name, wav_frame_count(c->clip),
+               (unsigned)c->clip->sample_rate, c->clip->data_size, aligned ? "yes" : "NO", same ? "yes" : "NO",
+               plays ? "ok" : "FAILED");
+        ok = ok && aligned && same && plays;
+        free(got);
+        free(want);
+        free(converted);
+    }
+
+    printf("%s\n", ok ? "embed checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
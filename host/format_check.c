@@ -0,0 +1,332 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_pwm_dma.h"
+#include "g711_ref.h"
+#include "wav.h"
+
+// Checks the wide sample formats. Parsing: plain and WAVE_FORMAT_EXTENSIBLE
+// headers for each supported format are accepted and the rest rejected.
+// Conversion: s24, s32 and f32 sources must truncate and downmix to the
+// levels computed here from the decoded values, play identically to an s24
+// source holding those values in every mode (dither, noise shaping, sigma-
+// delta, stereo output), and an s24 copy of an s16 clip must play exactly
+// like the s16 clip. Floats include +-1.0, out-of-range values, denormals,
+// infinities and NaN. G.711 clips cover every code and must play exactly
+// like an s16 clip of the values g711_ref gives. Exits non-zero on any
+// failure.
+
+#define FRAMES 4096u
+#define CHUNK 256u
+#define SD_OVERSAMPLE 8u
+#define S24_MAX 0x7fffff
+
+typedef struct {
+    const char *name;
+    uint16_t tag;
+    uint16_t subformat;  // for WAVE_FORMAT_EXTENSIBLE
+    uint16_t bits;
+    bool bad_guid;
+    bool accept;
+} header_case_t;
+
+static const header_case_t headers[] = {
+    {"pcm 8", 1, 0, 8, false, true},
+    {"pcm 16", 1, 0, 16, false, true},
+    {"pcm 24", 1, 0, 24, false, true},
+    {"pcm 32", 1, 0, 32, false, true},
+    {"float 32", 3, 0, 32, false, true},
+    {"float 64", 3, 0, 64, false, false},
+    {"float 16", 3, 0, 16, false, false},
+    {"pcm 20", 1, 0, 20, false, false},
+    {"ext pcm 16", 0xfffe, 1, 16, false, true},
+    {"ext pcm 24", 0xfffe, 1, 24, false, true},
+    {"ext pcm 32", 0xfffe, 1, 32, false, true},
+    {"ext float 32", 0xfffe, 3, 32, false, true},
+    {"ext bad guid", 0xfffe, 1, 16, true, false},
+    {"alaw 8", 6, 0, 8, false, true},
+    {"mulaw 8", 7, 0, 8, false, true},
+    {"mulaw 16", 7, 0, 16, false, false},
+    {"ext alaw", 0xfffe, 6, 8, false, true},
+    {"ext mulaw", 0xfffe, 7, 8, false, true},
+};
+
+typedef struct {
+    const char *name;
+    bool stereo_in;
+    bool stereo_out;
+    audio_pwm_dma_dither_t dither;
+    uint oversample;
+} play_mode_t;
+
+static const play_mode_t modes[] = {
+    {"mono", false, false, AUDIO_PWM_DMA_DITHER_NONE, 1},
+    {"downmix", true, false, AUDIO_PWM_DMA_DITHER_NONE, 1},
+    {"mono dual", false, true, AUDIO_PWM_DMA_DITHER_NONE, 1},
+    {"stereo", true, true, AUDIO_PWM_DMA_DITHER_NONE, 1},
+    {"mono tpdf", false, false, AUDIO_PWM_DMA_DITHER_TPDF, 1},
+    {"downmix shaped2", true, false, AUDIO_PWM_DMA_DITHER_SHAPED2, 1},
+    {"stereo shaped1", true, true, AUDIO_PWM_DMA_DITHER_SHAPED1, 1},
+    {"mono sd x8", false, false, AUDIO_PWM_DMA_DITHER_NONE, SD_OVERSAMPLE},
+    {"stereo sd x8", true, true, AUDIO_PWM_DMA_DITHER_NONE, SD_OVERSAMPLE},
+};
+
+#define MODES (sizeof(modes) / sizeof(modes[0]))
+#define MAX_LEVELS (FRAMES * SD_OVERSAMPLE * 2u)
+
+static uint32_t rng = 0x9e3779b9u;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static bool check_header(const header_case_t *h) {
+    static const uint8_t guid_tail[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80,
+                                          0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71};
+    uint8_t file[128] = {0};
+    uint32_t fmt_size = h->tag == 0xfffe ? 40u : 16u;
+    uint32_t block = 2u * h->bits / 8u;
+    memcpy(file, "RIFF", 4);
+    memcpy(file + 8, "WAVEfmt ", 8);
+    put_u32(file + 16, fmt_size);
+    uint8_t *fmt = file + 20;
+    put_u16(fmt + 0, h->tag);
+    put_u16(fmt + 2, 2);
+    put_u32(fmt + 4, 48000);
+    put_u32(fmt + 8, 48000u * block);
+    put_u16(fmt + 12, (uint16_t)block);
+    put_u16(fmt + 14, h->bits);
+    if (h->tag == 0xfffe) {
+        put_u16(fmt + 16, 22);
+        put_u16(fmt + 18, h->bits);
+        put_u32(fmt + 20, 3);
+        put_u16(fmt + 24, h->subformat);
+        memcpy(fmt + 26, guid_tail, sizeof(guid_tail));
+        if (h->bad_guid) {
+            fmt[39] ^= 1u;
+        }
+    }
+    uint8_t *data = fmt + fmt_size;
+    memcpy(data, "data", 4);
+    put_u32(data + 4, 4u * block);
+    size_t length = (size_t)(data + 8 + 4u * block - file);
+    put_u32(file + 4, (uint32_t)(length - 8));
+
+    wav_info_t info;
+    bool ok = parse_wav(file, length, &info);
+    bool pass = ok == h->accept;
+    if (ok && pass) {
+        uint16_t format = h->tag == 0xfffe ? h->subformat : h->tag;
+        wav_encoding_t encoding = format == 6 ? WAV_ENCODING_ALAW : format == 7 ? WAV_ENCODING_MULAW : WAV_ENCODING_PCM;
+        pass = info.bits_per_sample == h->bits && info.channels == 2 && info.is_float == (format == 3) &&
+               info.encoding == encoding && info.data_size == 4u * block;
+    }
+    printf("  %-14s %-7s %s\n", h->name, ok ? "accept" : "reject", pass ? "ok" : "FAILED");
+    return pass;
+}
+
+// What the player must decode a float to: x * 2^23 truncated towards zero,
+// saturated at +-(2^23 - 1), NaN as silence.
+static int32_t float_reference(float x) {
+    if (isnan(x)) {
+        return 0;
+    }
+    double y = trunc((double)x * 8388608.0);
+    return y >= S24_MAX ? S24_MAX : y <= -S24_MAX ? -S24_MAX : (int32_t)y;
+}
+
+static void put_s24(uint8_t *p, int32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+}
+
+static wav_info_t make_wav(const uint8_t *data, uint16_t bits, bool is_float, bool stereo) {
+    uint16_t channels = stereo ? 2 : 1;
+    return (wav_info_t){.data = data, .data_size = (size_t)FRAMES * channels * bits / 8u, .sample_rate = 44100,
+                        .bits_per_sample = bits, .channels = channels, .is_float = is_float};
+}
+
+static wav_info_t make_g711(const uint8_t *data, wav_encoding_t encoding, bool stereo) {
+    wav_info_t wav = make_wav(data, 8, false, stereo);
+    wav.encoding = encoding;
+    return wav;
+}
+
+// Plays a clip through the refill path a DMA buffer at a time; returns the
+// number of levels written.
+static size_t render(const wav_info_t *wav, const play_mode_t *mode, uint16_t *out) {
+    static audio_player_t player;
+    memset(&player, 0, sizeof(player));
+    player.stereo_output = mode->stereo_out;
+    player.dither = mode->dither;
+    player.oversample = mode->oversample;
+    player.sd_levels = 128;
+    if (!audio_pwm_dma_prepare(&player, wav)) {
+        fprintf(stderr, "prepare failed for %u-bit %s\n", wav->bits_per_sample, mode->name);
+        exit(1);
+    }
+    uint osr = mode->oversample > 1 ? mode->oversample : 1u;
+    uint channels = mode->stereo_out ? 2u : 1u;
+    for (size_t i = 0; i < FRAMES * osr; i += CHUNK) {
+        audio_pwm_dma_fill(&player, out + i * channels, CHUNK);
+    }
+    return (size_t)FRAMES * osr * channels;
+}
+
+// Truncated levels computed straight from the decoded s24 values.
+static void reference_levels(const int32_t *v, const play_mode_t *mode, uint16_t *out) {
+    for (size_t i = 0; i < FRAMES; ++i) {
+        int32_t l = mode->stereo_in ? v[2 * i] : v[i];
+        int32_t r = mode->stereo_in ? v[2 * i + 1] : l;
+        if (mode->stereo_out) {
+            out[2 * i] = (uint16_t)((l + 0x800000) >> 16);
+            out[2 * i + 1] = (uint16_t)((r + 0x800000) >> 16);
+        } else if (mode->stereo_in) {
+            out[i] = (uint16_t)((l + r + 0x1000000) >> 17);
+        } else {
+            out[i] = (uint16_t)((l + 0x800000) >> 16);
+        }
+    }
+}
+
+static bool same(const uint16_t *a, const uint16_t *b, size_t n) {
+    return !memcmp(a, b, n * sizeof(*a));
+}
+
+int main(void) {
+    static int32_t decoded[FRAMES * 2];
+    static uint8_t s24[FRAMES * 2 * 3], s32[FRAMES * 2 * 4], f32[FRAMES * 2 * 4], s16_as_s24[FRAMES * 2 * 3];
+    static int16_t s16[FRAMES * 2];
+    static uint8_t alaw[FRAMES * 2], ulaw[FRAMES * 2];
+    static int16_t alaw_s16[FRAMES * 2], ulaw_s16[FRAMES * 2];
+    static int32_t alaw_s24[FRAMES * 2], ulaw_s24[FRAMES * 2];
+    static uint16_t expect[MAX_LEVELS], got[MAX_LEVELS];
+    static const float specials[] = {0.0f, -0.0f, 1.0f, -1.0f, 0.99999994f, -0.99999994f, 1.5f, -2.0f, 1e-10f,
+                                     -1e-38f, 1e-45f, 0.5f, -0.5f, 0x1p-23f, -0x1p-24f, INFINITY, -INFINITY, NAN};
+    bool ok = true;
+
+    printf("headers\n");
+    for (size_t i = 0; i < sizeof(headers) / sizeof(headers[0]); ++i) {
+        ok = check_header(&headers[i]) && ok;
+    }
+
+    // A sine with noise on top, plus the special floats and the integer
+    // extremes at the start.
+    for (size_t i = 0; i < FRAMES * 2; ++i) {
+        float x = (float)(0.9 * sin(2.0 * M_PI * 440.0 * (double)(i / 2) / 44100.0)) +
+                  (float)((int32_t)next_random()) / 2147483648.0f * 0.3f;
+        if (i < sizeof(specials) / sizeof(specials[0])) {
+            x = specials[i];
+        }
+        memcpy(f32 + 4 * i, &x, sizeof(x));
+        int32_t v = float_reference(x);
+        decoded[i] = v;
+        put_s24(s24 + 3 * i, v);
+        // s32 carries a random low byte the conversion must not depend on.
+        uint32_t w = ((uint32_t)v << 8) | (next_random() & 0xffu);
+        if (i == 0) {
+            w = 0x80000000u;
+        } else if (i == 1) {
+            w = 0x7fffffffu;
+        }
+        put_u32(s32 + 4 * i, w);
+        if (i < 2) {
+            put_s24(s24 + 3 * i, (int32_t)w >> 8);
+            decoded[i] = (int32_t)w >> 8;
+        }
+        s16[i] = (int16_t)next_random();
+        put_s24(s16_as_s24 + 3 * i, s16[i] * 256);
+        // Every code in turn, then random ones.
+        alaw[i] = (uint8_t)(i < 256 ? i : next_random());
+        ulaw[i] = (uint8_t)(i < 256 ? i : next_random());
+        alaw_s16[i] = g711_ref_alaw(alaw[i]);
+        ulaw_s16[i] = g711_ref_ulaw(ulaw[i]);
+        alaw_s24[i] = alaw_s16[i] * 256;
+        ulaw_s24[i] = ulaw_s16[i] * 256;
+    }
+    // The float source differs from the others in its first two samples.
+    static int32_t decoded_f32[FRAMES * 2];
+    static uint8_t s24_f32[FRAMES * 2 * 3];
+    memcpy(decoded_f32, decoded, sizeof(decoded));
+    memcpy(s24_f32, s24, sizeof(s24));
+    for (size_t i = 0; i < 2; ++i) {
+        float x;
+        memcpy(&x, f32 + 4 * i, sizeof(x));
+        decoded_f32[i] = float_reference(x);
+        put_s24(s24_f32 + 3 * i, decoded_f32[i]);
+    }
+
+    printf("\n%-16s %6s %6s %6s %6s %6s %6s\n", "mode", "s24", "s32", "f32", "s16", "alaw", "mulaw");
+    for (size_t m = 0; m < MODES; ++m) {
+        const play_mode_t *mode = &modes[m];
+        bool st = mode->stereo_in;
+        wav_info_t w24 = make_wav(s24, 24, false, st);
+        wav_info_t w32 = make_wav(s32, 32, false, st);
+        wav_info_t wf = make_wav(f32, 32, true, st);
+        wav_info_t w24f = make_wav(s24_f32, 24, false, st);
+        wav_info_t w16 = make_wav((const uint8_t *)s16, 16, false, st);
+        wav_info_t w16x = make_wav(s16_as_s24, 24, false, st);
+        bool exact = mode->dither == AUDIO_PWM_DMA_DITHER_NONE && mode->oversample == 1;
+
+        // s24 against the reference levels where there is one; the other
+        // formats against s24 holding the same values.
+        size_t n = render(&w24, mode, got);
+        bool pass24 = true;
+        if (exact) {
+            reference_levels(decoded, mode, expect);
+            pass24 = same(expect, got, n);
+        }
+        memcpy(expect, got, n * sizeof(*got));
+        render(&w32, mode, got);
+        bool pass32 = same(expect, got, n);
+        render(&w24f, mode, expect);
+        render(&wf, mode, got);
+        bool passf = same(expect, got, n);
+        if (exact) {
+            reference_levels(decoded_f32, mode, expect);
+            passf = passf && same(expect, got, n);
+        }
+        render(&w16, mode, expect);
+        render(&w16x, mode, got);
+        bool pass16 = same(expect, got, n);
+
+        // G.711 against s16 holding the reference expansion, and against
+        // the reference levels where there are some.
+        bool pass_law[2];
+        for (uint k = 0; k < 2; ++k) {
+            wav_info_t wl = make_g711(k ? ulaw : alaw, k ? WAV_ENCODING_MULAW : WAV_ENCODING_ALAW, st);
+            wav_info_t wls = make_wav((const uint8_t *)(k ? ulaw_s16 : alaw_s16), 16, false, st);
+            render(&wls, mode, expect);
+            render(&wl, mode, got);
+            pass_law[k] = same(expect, got, n);
+            if (exact) {
+                reference_levels(k ? ulaw_s24 : alaw_s24, mode, expect);
+                pass_law[k] = pass_law[k] && same(expect, got, n);
+            }
+        }
+
+        printf("%-16s %6s %6s %6s %6s %6s %6s\n", mode->name, pass24 ? "ok" : "FAIL", pass32 ? "ok" : "FAIL",
+               passf ? "ok" : "FAIL", pass16 ? "ok" : "FAIL", pass_law[0] ? "ok" : "FAIL",
+               pass_law[1] ? "ok" : "FAIL");
+        ok = ok && pass24 && pass32 && passf && pass16 && pass_law[0] && pass_law[1];
+    }
+
+    printf("%s\n", ok ? "format checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#include "g711_ref.h"
+
+#include <stdlib.h>
+
+// mu-law codes are stored inverted. Segment e spans (33 << e) - 33 to
+// (33 << (e + 1)) - 33 in 14-bit units in 16 steps of 2 << e; a code sits
+// in the middle of its step. 14-bit values are scaled by 4.
+int16_t g711_ref_ulaw(uint8_t code) {
+    uint8_t u = (uint8_t)~code;
+    int32_t e = (u >> 4) & 7;
+    int32_t m = u & 15;
+    int32_t magnitude = (((2 * m + 33) << e) - 33) * 4;
+    return (int16_t)(u & 0x80 ? -magnitude : magnitude);
+}
+
+// A-law codes have their even bits toggled and the sign bit set for
+// positive values. Segment 0 is linear in steps of 2; segment s above it
+// starts at 32 << (s - 1) in 13-bit units with steps of 1 << s. Codes sit
+// mid-step; 13-bit values are scaled by 8.
+int16_t g711_ref_alaw(uint8_t code) {
+    uint8_t a = code ^ 0x55u;
+    int32_t s = (a >> 4) & 7;
+    int32_t m = a & 15;
+    int32_t magnitude = s == 0 ? 2 * m + 1 : (2 * m + 33) << (s - 1);
+    magnitude *= 8;
+    return (int16_t)(a & 0x80 ? magnitude : -magnitude);
+}
+
+// Searches all 256 codes; clips are short and the search keeps the encoder
+// trivially consistent with the expansion above.
+static uint8_t nearest(int16_t (*expand)(uint8_t), int16_t sample) {
+    uint8_t best = 0;
+    int32_t best_error = INT32_MAX;
+    for (uint32_t code = 0; code < 256; ++code) {
+        int32_t error = abs(expand((uint8_t)code) - sample);
+        if (error < best_error) {
+            best = (uint8_t)code;
+            best_error = error;
+        }
+    }
+    return best;
+}
+
+uint8_t g711_ref_encode_ulaw(int16_t sample) {
+    return nearest(g711_ref_ulaw, sample);
+}
+
+uint8_t g711_ref_encode_alaw(int16_t sample) {
+    return nearest(g711_ref_alaw, sample);
+}
+
+int16_t *g711_ref_decode(const wav_info_t *wav) {
+    size_t samples = wav_frame_count(wav) * wav->channels;
+    int16_t *out = malloc((samples ? samples : 1) * sizeof(*out));
+    if (!out) {
+        return NULL;
+    }
+    bool alaw = wav->encoding == WAV_ENCODING_ALAW;
+    for (size_t i = 0; i < samples; ++i) {
+        out[i] = alaw ? g711_ref_alaw(wav->data[i]) : g711_ref_ulaw(wav->data[i]);
+    }
+    return out;
+}
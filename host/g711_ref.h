@@ -0,0 +1,22 @@
+#ifndef G711_REF_H
+#define G711_REF_H
+
+#include <stdint.h>
+
+#include "wav.h"
+
+// Host-side G.711 expansion, computed per code from the segment and step
+// as the ITU-T recommendation describes them rather than looked up, to
+// check the player's tables against. Results are in s16 scale.
+int16_t g711_ref_ulaw(uint8_t code);
+int16_t g711_ref_alaw(uint8_t code);
+
+// The code whose expansion is nearest to an s16 sample, to make clips.
+uint8_t g711_ref_encode_ulaw(int16_t sample);
+uint8_t g711_ref_encode_alaw(int16_t sample);
+
+// Expands a parsed A-law or mu-law WAV to interleaved s16; returns a
+// malloc'd buffer of wav_frame_count() frames, or NULL.
+int16_t *g711_ref_decode(const wav_info_t *wav);
+
+#endif
@@ -0,0 +1,125 @@
+#include "ima_adpcm_ref.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const int ref_steps[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+typedef struct {
+    int predictor;
+    int index;
+} ref_state_t;
+
+// One nibble, as the DVI description has it: the difference is step/8 plus
+// step/4, step/2 and step for each magnitude bit set, each term truncated.
+static int ref_expand(ref_state_t *st, unsigned nibble) {
+    int step = ref_steps[st->index];
+    int diff = step >> 3;
+    for (int bit = 2; bit >= 0; --bit) {
+        if (nibble & (1u << bit)) {
+            diff += step >> (2 - bit);
+        }
+    }
+    st->predictor += (nibble & 8u) ? -diff : diff;
+    st->predictor = st->predictor > 32767 ? 32767 : st->predictor < -32768 ? -32768 : st->predictor;
+    static const int adjust[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+    st->index += adjust[nibble & 7u];
+    st->index = st->index < 0 ? 0 : st->index > 88 ? 88 : st->index;
+    return st->predictor;
+}
+
+int16_t *ima_ref_decode(const wav_info_t *wav) {
+    size_t frames = wav_frame_count(wav);
+    uint16_t ch = wav->channels;
+    int16_t *out = malloc((frames ? frames : 1) * ch * sizeof(*out));
+    if (!out) {
+        return NULL;
+    }
+    // Frame f of a block: 0 is the header, then frame 1 + 8 * word + k is
+    // nibble k of that channel's word.
+    ref_state_t st[2] = {{0, 0}, {0, 0}};
+    for (size_t f = 0; f < frames; ++f) {
+        size_t block = f / wav->samples_per_block;
+        size_t k = f % wav->samples_per_block;
+        const uint8_t *base = wav->data + block * wav->block_align;
+        for (uint16_t c = 0; c < ch; ++c) {
+            if (k == 0) {
+                st[c].predictor = (int16_t)(base[4 * c] | (base[4 * c + 1] << 8));
+                st[c].index = base[4 * c + 2] > 88 ? 88 : base[4 * c + 2];
+                out[f * ch + c] = (int16_t)st[c].predictor;
+                continue;
+            }
+            size_t word = (k - 1) / 8, nib = (k - 1) % 8;
+            uint8_t byte = base[4u * ch + word * 4u * ch + 4u * c + nib / 2];
+            out[f * ch + c] = (int16_t)ref_expand(&st[c], nib & 1 ? byte >> 4 : byte & 0xfu);
+        }
+    }
+    return out;
+}
+
+// The nibble that best moves st towards sample, applied to st.
+static unsigned ref_quantize(ref_state_t *st, int sample) {
+    int step = ref_steps[st->index];
+    int diff = sample - st->predictor;
+    unsigned nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+    for (int bit = 2; bit >= 0; --bit) {
+        if (diff >= step) {
+            nibble |= 1u << bit;
+            diff -= step;
+        }
+        step >>= 1;
+    }
+    ref_expand(st, nibble);
+    return nibble;
+}
+
+uint8_t *ima_ref_encode(const int16_t *pcm, size_t frames, uint16_t channels, uint16_t block_align,
+                        size_t *size_out) {
+    uint32_t header = 4u * channels;
+    size_t per_block = (size_t)(block_align - header) * 2u / channels + 1u;
+    size_t blocks = (frames + per_block - 1) / per_block;
+    uint8_t *out = calloc(blocks ? blocks : 1, block_align);
+    if (!out) {
+        return NULL;
+    }
+    ref_state_t st[2] = {{0, 0}, {0, 0}};
+    size_t size = 0;
+    for (size_t b = 0; b < blocks; ++b) {
+        uint8_t *base = out + b * block_align;
+        size_t first = b * per_block;
+        size_t n = frames - first < per_block ? frames - first : per_block;
+        for (uint16_t c = 0; c < channels; ++c) {
+            int16_t s = pcm[first * channels + c];
+            st[c].predictor = s;
+            base[4 * c] = (uint8_t)s;
+            base[4 * c + 1] = (uint8_t)((uint16_t)s >> 8);
+            base[4 * c + 2] = (uint8_t)st[c].index;
+        }
+        // Whole words only: a short last block drops its trailing frames.
+        size_t words = (n - 1) / 8;
+        for (size_t w = 0; w < words; ++w) {
+            for (uint16_t c = 0; c < channels; ++c) {
+                uint8_t *word = base + header + w * header + 4u * c;
+                for (unsigned k = 0; k < 8; ++k) {
+                    int sample = pcm[(first + 1 + w * 8 + k) * channels + c];
+                    unsigned nibble = ref_quantize(&st[c], sample);
+                    word[k / 2] |= (uint8_t)(k & 1 ? nibble << 4 : nibble);
+                }
+            }
+        }
+        size = b * block_align + header + words * header;
+    }
+    *size_out = size;
+    return out;
+}
@@ -0,0 +1,23 @@
+#ifndef IMA_ADPCM_REF_H
+#define IMA_ADPCM_REF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wav.h"
+
+// Host-side IMA ADPCM reference, written from the Microsoft/DVI description
+// independently of the player's decoder: a per-sample decoder to check it
+// against, and an encoder to make test clips.
+
+// Decodes a parsed IMA ADPCM WAV to interleaved s16; returns a malloc'd
+// buffer of wav_frame_count() frames, or NULL.
+int16_t *ima_ref_decode(const wav_info_t *wav);
+
+// Encodes interleaved s16 frames into blocks of block_align bytes (the last
+// one cut short after the last whole group). Returns a malloc'd buffer and
+// its size, or NULL.
+uint8_t *ima_ref_encode(const int16_t *pcm, size_t frames, uint16_t channels, uint16_t block_align,
+                        size_t *size_out);
+
+#endif
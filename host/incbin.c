@@ -0,0 +1,44 @@
+#include "incbin.h"
+
+// A path inside an assembler string inside a C string: quotes and
+// backslashes are escaped once for each.
+static void put_escaped(FILE *f, const char *s) {
+    for (; *s; ++s) {
+        if (*s == '"') {
+            fputs("\\\\\\\"", f);
+        } else if (*s == '\\') {
+            fputs("\\\\\\\\", f);
+        } else {
+            fputc(*s, f);
+        }
+    }
+}
+
+void incbin_write(FILE *f, const char *symbol, const char *bin_path) {
+    fprintf(f,
+            "__asm__(\".section .rodata.%s, \\\"a\\\"\\n\"\n"
+            "        \".balign 4\\n\"\n"
+            "        \".global %s\\n\"\n"
+            "        \".type %s, %%object\\n\"\n"
+            "        \"%s:\\n\"\n"
+            "        \".incbin \\\"",
+            symbol, symbol, symbol, symbol);
+    put_escaped(f, bin_path);
+    fprintf(f,
+            "\\\"\\n\"\n"
+            "        \".size %s, . - %s\\n\"\n"
+            "        \".previous\\n\");\n"
+            "\n"
+            "extern const uint8_t %s[];\n",
+            symbol, symbol, symbol);
+}
+
+bool incbin_write_file(const char *path, const void *data, size_t size) {
+    FILE *f = fopen(path, "wb");
+    bool ok = f && fwrite(data, 1, size, f) == size;
+    if (!f || fclose(f) != 0 || !ok) {
+        fprintf(stderr, "%s: write failed\n", path);
+        return false;
+    }
+    return true;
+}
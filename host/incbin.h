@@ -0,0 +1,16 @@
+#ifndef INCBIN_H
+#define INCBIN_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Writes C source defining the global const uint8_t symbol[] as the
+// contents of bin_path, pulled in with .incbin in its own word-aligned
+// .rodata section, so the build never compiles a byte array. For the
+// generated sources of wav_embed and sound_bank.
+void incbin_write(FILE *f, const char *symbol, const char *bin_path);
+
+// Writes size bytes to path; false (with a message) on failure.
+bool incbin_write_file(const char *path, const void *data, size_t size);
+
+#endif
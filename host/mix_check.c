@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_mixer.h"
+#include "audio_pwm_dma.h"
+#include "sim_hw.h"
+#include "wav.h"
+#include "wav_convert.h"
+#include "wav_io.h"
+
+// Checks the mixer against a reference mix of the same clips decoded up
+// front with the reference decoders: every format, mono and stereo voices,
+// stereo and mono mixes, with voices starting, looping, ending, being
+// stopped and changing volume and pan between renders of odd sizes. The
+// output must match sample for sample, saturate rather than wrap, and play
+// through a player exactly as the same s16 stream would. Also checks the
+// voice pool limits, that renders of any size keep the mix history intact,
+// and that a mixer player streams without underruns.
+// Exits non-zero on any failure.
+
+#define RATE 22050u
+#define SCRIPT_FRAMES 30000u
+#define MAX_REF_VOICES 32
+
+typedef struct {
+    const char *name;
+    wav_info_t wav;
+    int16_t *pcm;  // reference decode
+    size_t frames;
+} clip_t;
+
+typedef enum { EV_PLAY, EV_STOP, EV_VOLUME, EV_PAN } event_kind_t;
+
+typedef struct {
+    size_t frame;
+    event_kind_t kind;
+    int clip;       // EV_PLAY
+    int target;     // earlier EV_PLAY event, for the others
+    int value;      // volume or pan
+    int16_t pan;    // EV_PLAY
+    bool loop;      // EV_PLAY
+} event_t;
+
+typedef struct {
+    const clip_t *clip;
+    bool active;
+    bool loop;
+    size_t pos;
+    int32_t volume;
+    int32_t pan;
+} ref_voice_t;
+
+static clip_t clips[12];
+static size_t clip_count;
+
+static const char *const format_names[] = {"u8", "s16", "alaw", "mulaw", "adpcm", "qoa"};
+
+static bool add_clip(const wav_info_t *source, wav_convert_format_t format, size_t frames, const char *layout) {
+    wav_info_t cut = *source;
+    size_t frame_bytes = (size_t)source->channels * source->bits_per_sample / 8u;
+    if (frames * frame_bytes < cut.data_size) {
+        cut.data_size = frames * frame_bytes;
+    }
+    wav_convert_options_t options = {format, 0, false};
+    clip_t *c = &clips[clip_count];
+    if (!wav_convert(&cut, &options, &c->wav) || !(c->pcm = wav_convert_decode(&c->wav))) {
+        fprintf(stderr, "%s %s: conversion failed\n", format_names[format], layout);
+        return false;
+    }
+    c->frames = wav_frame_count(&c->wav);
+    static char names[12][24];
+    snprintf(names[clip_count], sizeof(names[0]), "%s %s", format_names[format], layout);
+    c->name = names[clip_count++];
+    return true;
+}
+
+// The reference mix of one frame: every voice's samples times its gains,
+// summed in 1/256 steps and saturated.
+static void ref_frame(ref_voice_t *voices, size_t count, uint channels, int16_t *out) {
+    int32_t acc[2] = {0, 0};
+    for (size_t v = 0; v < count; ++v) {
+        ref_voice_t *r = &voices[v];
+        if (r->active && r->pos == r->clip->frames) {
+            r->pos = 0;
+            r->active = r->loop && r->clip->frames > 0;
+        }
+        if (!r->active) {
+            continue;
+        }
+        uint in = r->clip->wav.channels;
+        const int16_t *s = r->clip->pcm + r->pos * in;
+        r->pos++;
+        if (channels == 1) {
+            acc[0] += in == 2 ? ((s[0] + s[1]) * r->volume) >> 1 : s[0] * r->volume;
+            continue;
+        }
+        int32_t left = r->volume * (127 - (r->pan > 0 ? r->pan : 0)) / 127;
+        int32_t right = r->volume * (127 + (r->pan < 0 ? r->pan : 0)) / 127;
+        acc[0] += s[0] * left;
+        acc[1] += s[in == 2 ? 1 : 0] * right;
+    }
+    for (uint c = 0; c < channels; ++c) {
+        int32_t v = acc[c] >> 8;
+        out[c] = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+    }
+}
+
+// Runs the script on the mixer and the reference, rendering the stretch
+// between events in pieces of pseudo-random size. Returns the first
+// differing frame, or SCRIPT_FRAMES if none.
+static size_t run_script(const event_t *events, size_t event_count, bool stereo, int16_t *got, int16_t *want) {
+    static audio_mixer_t mixer;
+    audio_mixer_init(&mixer, RATE, stereo);
+    uint channels = stereo ? 2u : 1u;
+    ref_voice_t ref[MAX_REF_VOICES] = {0};
+    int ids[MAX_REF_VOICES];
+    uint32_t seed = 0x9e3779b9u;
+    size_t pos = 0, e = 0;
+    while (pos < SCRIPT_FRAMES) {
+        for (; e < event_count && events[e].frame == pos; ++e) {
+            const event_t *ev = &events[e];
+            ref_voice_t *r = &ref[ev->kind == EV_PLAY ? e : (size_t)ev->target];
+            switch (ev->kind) {
+            case EV_PLAY:
+                ids[e] = audio_mixer_play(&mixer, &clips[ev->clip].wav, (uint16_t)ev->value, ev->pan, ev->loop);
+                *r = (ref_voice_t){&clips[ev->clip], ids[e] >= 0, ev->loop, 0, ev->value, ev->pan};
+                break;
+            case EV_STOP:
+                audio_mixer_stop(&mixer, ids[ev->target]);
+                r->active = false;
+                break;
+            case EV_VOLUME:
+                audio_mixer_set_volume(&mixer, ids[ev->target], (uint16_t)ev->value);
+                r->volume = ev->value;
+                break;
+            case EV_PAN:
+                audio_mixer_set_pan(&mixer, ids[ev->target], (int16_t)ev->value);
+                r->pan = ev->value;
+                break;
+            }
+        }
+        size_t until = e < event_count ? events[e].frame : SCRIPT_FRAMES;
+        while (pos < until) {
+            seed = seed * 1664525u + 1013904223u;
+            size_t n = 1 + (seed >> 16) % 200u;
+            n = n < until - pos ? n : until - pos;
+            audio_mixer_render(&mixer, got + pos * channels, n);
+            for (size_t i = 0; i < n; ++i, ++pos) {
+                ref_frame(ref, e, channels, want + pos * channels);
+            }
+        }
+    }
+    for (size_t i = 0; i < SCRIPT_FRAMES; ++i) {
+        if (memcmp(got + i * channels, want + i * channels, channels * sizeof(*got))) {
+            return i;
+        }
+    }
+    return SCRIPT_FRAMES;
+}
+
+// The mix through the player's refill path must give the levels of the
+// same s16 stream: truncated, or a pair per frame in stereo output. The
+// player mixes ahead of its refills, so only events at frame 0 apply.
+static bool check_player(bool stereo_mix, bool stereo_output, const event_t *events, size_t event_count,
+                         const int16_t *want) {
+    static audio_mixer_t mixer;
+    static audio_player_t player;
+    audio_mixer_init(&mixer, RATE, stereo_mix);
+    memset(&player, 0, sizeof(player));
+    player.mixer = &mixer;
+    player.stereo_output = stereo_output;
+    wav_info_t out = audio_mixer_output(&mixer);
+    if (!audio_pwm_dma_prepare(&player, &out)) {
+        return false;
+    }
+    for (size_t e = 0; e < event_count; ++e) {
+        if (events[e].frame == 0 && events[e].kind == EV_PLAY) {
+            audio_mixer_play(&mixer, &clips[events[e].clip].wav, (uint16_t)events[e].value, events[e].pan,
+                             events[e].loop);
+        }
+    }
+    uint in = stereo_mix ? 2u : 1u, outc = stereo_output ? 2u : 1u;
+    static uint16_t levels[2048 * 2];
+    size_t frames = sizeof(levels) / sizeof(levels[0]) / 2u;
+    audio_pwm_dma_fill(&player, levels, frames);
+    for (size_t i = 0; i < frames; ++i) {
+        const int16_t *s = want + i * in;
+        for (uint c = 0; c < outc; ++c) {
+            int32_t v = stereo_output ? s[in == 2 ? c : 0] : in == 2 ? (s[0] + s[1]) >> 1 : s[0];
+            if (levels[i * outc + c] != (uint16_t)((v + 32768) >> 8)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Eight full-scale square waves in phase: the sum is eight times full scale
+// and must clip to the rails, never wrap.
+static bool check_saturation(void) {
+    static uint8_t square[64];
+    for (size_t i = 0; i < sizeof(square); ++i) {
+        square[i] = i & 8u ? 0 : 255;
+    }
+    wav_info_t wav = {square, sizeof(square), RATE, 8, 1, false, WAV_ENCODING_PCM, 1, 0};
+    static audio_mixer_t mixer;
+    audio_mixer_init(&mixer, RATE, false);
+    for (int v = 0; v < AUDIO_MIXER_VOICES; ++v) {
+        audio_mixer_play(&mixer, &wav, AUDIO_MIXER_VOLUME_MAX, 0, false);
+    }
+    int16_t out[64];
+    audio_mixer_render(&mixer, out, 64);
+    for (size_t i = 0; i < 64; ++i) {
+        if (out[i] != (i & 8u ? -32768 : 32767)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Renders of 100 frames, which do not divide the history, must keep every
+// sum within it: the kept frames mixed again with no voice must give the
+// output back, and nothing past the mixer may be written.
+static bool check_history(bool stereo) {
+    static struct {
+        audio_mixer_t mixer;
+        uint32_t guard[64];
+    } guarded;
+    audio_mixer_t *mixer = &guarded.mixer;
+    memset(guarded.guard, 0xa5, sizeof(guarded.guard));
+    audio_mixer_init(mixer, RATE, stereo);
+    audio_mixer_play(mixer, &clips[stereo ? 3 : 1].wav, AUDIO_MIXER_UNITY, 0, true);
+    uint channels = stereo ? 2u : 1u;
+    static int16_t out[5000 * 2], again[AUDIO_MIXER_HISTORY_FRAMES * 2];
+    for (size_t pos = 0; pos < 5000; pos += 100) {
+        audio_mixer_render(mixer, out + pos * channels, 100);
+    }
+    // Voice 1 is idle, so the remix adds nothing.
+    audio_mixer_remix(mixer, 1, mixer->frames_mixed - AUDIO_MIXER_HISTORY_FRAMES, again,
+                      AUDIO_MIXER_HISTORY_FRAMES);
+    bool kept = !memcmp(again, out + (5000 - AUDIO_MIXER_HISTORY_FRAMES) * channels,
+                        AUDIO_MIXER_HISTORY_FRAMES * channels * sizeof(*out));
+    for (size_t i = 0; i < sizeof(guarded.guard) / sizeof(guarded.guard[0]); ++i) {
+        kept = kept && guarded.guard[i] == 0xa5a5a5a5u;
+    }
+    return kept;
+}
+
+// A full pool refuses another voice, as do clips the mixer cannot play;
+// a finished voice's slot is handed out again.
+static bool check_pool(void) {
+    static audio_mixer_t mixer;
+    audio_mixer_init(&mixer, RATE, true);
+    const wav_info_t *clip = &clips[0].wav;
+    bool ok = true;
+    for (int v = 0; v < AUDIO_MIXER_VOICES; ++v) {
+        ok = ok && audio_mixer_play(&mixer, clip, AUDIO_MIXER_UNITY, 0, true) == v;
+    }
+    ok = ok && audio_mixer_play(&mixer, clip, AUDIO_MIXER_UNITY, 0, false) < 0;
+    audio_mixer_stop(&mixer, 3);
+    ok = ok && !audio_mixer_is_playing(&mixer, 3) && audio_mixer_play(&mixer, clip, AUDIO_MIXER_UNITY, 0, false) == 3;
+    audio_mixer_stop_all(&mixer);
+
+    wav_info_t other_rate = *clip, s24 = *clip;
+    other_rate.sample_rate = RATE / 2;
+    s24.bits_per_sample = 24;
+    ok = ok && audio_mixer_play(&mixer, &other_rate, AUDIO_MIXER_UNITY, 0, false) < 0 &&
+         audio_mixer_play(&mixer, &s24, AUDIO_MIXER_UNITY, 0, false) < 0;
+
+    int id = audio_mixer_play(&mixer, clip, AUDIO_MIXER_UNITY, 0, false);
+    static int16_t scratch[4096 * 2];
+    for (size_t done = 0; done <= clips[0].frames; done += 4096) {
+        audio_mixer_render(&mixer, scratch, 4096);
+    }
+    return ok && id == 0 && !audio_mixer_is_playing(&mixer, id);
+}
+
+// A mixer player on the simulated hardware: voices started while it plays,
+// no underruns, and plain WAV calls refused.
+static bool check_streaming(void) {
+    static audio_mixer_t mixer;
+    static audio_player_t player;
+    audio_mixer_init(&mixer, RATE, false);
+    audio_pwm_dma_config_t config = audio_pwm_dma_get_default_config(0);
+    config.mixer = &mixer;
+    if (!audio_pwm_dma_init_with_config(&player, NULL, &config)) {
+        return false;
+    }
+    audio_pwm_dma_start(&player);
+    for (size_t c = 0; c < clip_count; ++c) {
+        audio_mixer_play(&mixer, &clips[c].wav, AUDIO_MIXER_UNITY / 4, 0, c == 0);
+        sim_hw_run(125000000u / 50u);
+    }
+    audio_pwm_dma_stats_t stats;
+    audio_pwm_dma_get_stats(&player, &stats);
+    bool refused = !audio_pwm_dma_play(&player, &clips[0].wav) && !audio_pwm_dma_seek(&player, 0, NULL);
+    bool playing = !audio_pwm_dma_is_idle(&player);
+    audio_pwm_dma_deinit(&player);
+    printf("mixer player: %u refills, %u underruns, %s, wav calls %s\n", (unsigned)stats.refills,
+           (unsigned)stats.underruns, playing ? "still playing" : "STOPPED", refused ? "refused" : "NOT REFUSED");
+    return stats.refills > 0 && stats.underruns == 0 && playing && refused;
+}
+
+int main(void) {
+    sim_hw_reset(125000000u);
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(EMBED_SOURCE, &length);
+    wav_info_t mono = {0};
+    if (!file || !parse_wav(file, length, &mono) || mono.channels != 1 || mono.bits_per_sample != 16 ||
+        mono.sample_rate != RATE) {
+        fprintf(stderr, "%s: cannot load a 16-bit mono %u Hz clip\n", EMBED_SOURCE, RATE);
+        return 1;
+    }
+    // Stereo voices: the clip on the left, a slower sweep of it reversed on the right.
+    size_t frames = wav_frame_count(&mono);
+    int16_t *pair = malloc(frames * 2 * sizeof(*pair));
+    const int16_t *m = (const int16_t *)mono.data;
+    for (size_t i = 0; i < frames; ++i) {
+        pair[2 * i] = m[i];
+        pair[2 * i + 1] = m[frames - 1 - i / 2];
+    }
+    wav_info_t stereo = mono;
+    stereo.data = (const uint8_t *)pair;
+    stereo.data_size = frames * 4;
+    stereo.channels = 2;
+    stereo.block_align = 4;
+
+    // Clip lengths vary so voices end mid-render; the QOA ones loop.
+    for (int f = WAV_CONVERT_U8; f <= WAV_CONVERT_QOA; ++f) {
+        if (!add_clip(&mono, (wav_convert_format_t)f, 3000u + 1711u * (size_t)f, "mono") ||
+            !add_clip(&stereo, (wav_convert_format_t)f, 2500u + 1291u * (size_t)f, "stereo")) {
+            return 1;
+        }
+    }
+
+    // Clips 2f and 2f + 1 are format f (u8, s16, alaw, mulaw, adpcm, qoa),
+    // mono then stereo.
+    static const event_t script[] = {
+        {0, EV_PLAY, 11, 0, 96, 0, true},         // background loop
+        {0, EV_PLAY, 0, 0, 256, -100, false},
+        {333, EV_PLAY, 3, 0, 256, 60, false},
+        {500, EV_PLAY, 4, 0, 512, 0, false},
+        {777, EV_PLAY, 7, 0, 200, -30, false},
+        {1000, EV_PLAY, 8, 0, 300, -127, true},
+        {1500, EV_VOLUME, 0, 0, 300, 0, false},
+        {1500, EV_PAN, 0, 1, 90, 0, false},
+        {2048, EV_PLAY, 2, 0, 1024, 127, false},
+        {2049, EV_PLAY, 5, 0, 180, 10, false},
+        {4000, EV_STOP, 0, 5, 0, 0, false},
+        {4000, EV_PLAY, 9, 0, 256, -64, false},
+        {6001, EV_PLAY, 1, 0, 128, 0, true},
+        {6001, EV_PLAY, 10, 0, 64, 127, true},
+        {9000, EV_PLAY, 6, 0, 256, 0, false},
+        {12345, EV_PAN, 0, 0, -127, 0, false},
+        {15000, EV_STOP, 0, 12, 0, 0, false},
+        {20000, EV_STOP, 0, 0, 0, 0, false},
+        {21000, EV_PLAY, 11, 0, 256, 0, false},
+    };
+    size_t script_len = sizeof(script) / sizeof(script[0]);
+
+    static int16_t got[SCRIPT_FRAMES * 2], want[SCRIPT_FRAMES * 2];
+    bool ok = true;
+    size_t start_len = 0;
+    while (start_len < script_len && script[start_len].frame == 0) {
+        ++start_len;
+    }
+    for (int s = 0; s < 2; ++s) {
+        bool stereo_mix = s == 0;
+        bool player_ok = run_script(script, start_len, stereo_mix, got, want) == SCRIPT_FRAMES &&
+                         check_player(stereo_mix, false, script, start_len, want) &&
+                         check_player(stereo_mix, true, script, start_len, want);
+        size_t bad = run_script(script, script_len, stereo_mix, got, want);
+        printf("%-6s mix, %zu voices over %u frames: %s, player output %s\n", stereo_mix ? "stereo" : "mono",
+               clip_count, SCRIPT_FRAMES, bad == SCRIPT_FRAMES ? "exact" : "MISMATCH",
+               player_ok ? "exact" : "MISMATCH");
+        if (bad != SCRIPT_FRAMES) {
+            printf("  first difference at frame %zu\n", bad);
+        }
+        ok = ok && bad == SCRIPT_FRAMES && player_ok;
+    }
+
+    bool saturates = check_saturation();
+    bool pool = check_pool();
+    bool history = check_history(false) && check_history(true);
+    printf("8 voices at 4x full scale: %s\n", saturates ? "saturated" : "WRAPPED");
+    printf("history over 100-frame renders: %s\n", history ? "kept" : "CORRUPTED");
+    printf("voice pool limits: %s\n", pool ? "ok" : "FAILED");
+    bool streams = check_streaming();
+    ok = ok && saturates && pool && history && streams;
+    printf("%s\n", ok ? "mix checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
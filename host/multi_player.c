@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_pwm_dma.h"
+#include "capture.h"
+#include "hardware/dma.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "sim_hw.h"
+#include "wav.h"
+
+// Plays several clips on independent players at once and checks that each
+// output is identical, sample for sample and cycle for cycle, to the same
+// clip played alone. Players start staggered, so one initialises while the
+// others stream. Exits non-zero on any difference or leaked claim.
+
+#define MAX_INSTANCES 4
+
+typedef struct {
+    uint64_t cycle;
+    uint16_t level;
+} event_t;
+
+typedef struct {
+    uint slice;
+    uint channel;
+    uint64_t origin;
+    bool timer_paced;
+    event_t *events;
+    size_t count;
+    size_t capacity;
+} trace_t;
+
+typedef struct {
+    const char *name;
+    uint32_t rate;
+    uint16_t bits;
+    uint16_t channels;
+    uint32_t frames;
+} clip_spec_t;
+
+// Mixed formats and rates: zero-copy u8 mono next to buffered players.
+static const clip_spec_t specs[MAX_INSTANCES] = {
+    {"u8 mono 8000", 8000, 8, 1, 1500},
+    {"s16 mono 22050", 22050, 16, 1, 4000},
+    {"u8 stereo 11025", 11025, 8, 2, 2500},
+    {"s16 stereo 44100", 44100, 16, 2, 7000},
+};
+
+static audio_player_t players[MAX_INSTANCES];
+static trace_t traces[MAX_INSTANCES];
+static size_t trace_count;
+
+static void record_cc(void *ctx, uint slice, uint32_t cc, uint64_t cycle) {
+    (void)ctx;
+    for (size_t i = 0; i < trace_count; ++i) {
+        trace_t *t = &traces[i];
+        if (t->slice != slice) {
+            continue;
+        }
+        if (t->count == t->capacity) {
+            t->capacity = t->capacity ? t->capacity * 2 : 4096;
+            t->events = realloc(t->events, t->capacity * sizeof(*t->events));
+            if (!t->events) {
+                fprintf(stderr, "out of memory\n");
+                exit(1);
+            }
+        }
+        t->events[t->count++] = (event_t){cycle - t->origin, (uint16_t)(cc >> (16u * t->channel))};
+    }
+}
+
+// Deterministic per-instance content, so a crossed wire shows up as a mismatch.
+static wav_info_t make_clip(const clip_spec_t *spec, uint seed) {
+    size_t samples = (size_t)spec->frames * spec->channels;
+    int16_t *pcm = malloc(samples * sizeof(*pcm));
+    if (!pcm) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    uint32_t x = 0x9e3779b9u * (seed + 1u);
+    for (size_t i = 0; i < samples; ++i) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        pcm[i] = (int16_t)x;
+    }
+    wav_info_t wav = make_pcm_clip(pcm, spec->frames, spec->rate, spec->bits, spec->channels);
+    free(pcm);
+    return wav;
+}
+
+static bool all_idle(size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (!audio_pwm_dma_is_idle(&players[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Plays instances [first, first + n) together, instance k starting at
+// k * stagger cycles, and fills traces[0..n).
+static bool run(const wav_info_t *clips, size_t first, size_t n, uint64_t stagger) {
+    for (size_t k = 0; k < n; ++k) {
+        free(traces[k].events);
+        traces[k] = (trace_t){0};
+    }
+    trace_count = 0;
+    sim_hw_set_cc_hook(record_cc, NULL);
+
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = first + k;
+        if (k) {
+            sim_hw_run(stagger);
+        }
+        if (!audio_pwm_dma_init(&players[k], &clips[i], 2u * (uint)i)) {
+            fprintf(stderr, "init failed for %s\n", specs[i].name);
+            return false;
+        }
+        traces[k].slice = players[k].slice_num;
+        traces[k].channel = players[k].pwm_channel;
+        traces[k].origin = sim_hw_now();
+        traces[k].timer_paced = players[k].pace_timer >= 0;
+        trace_count = k + 1;
+        audio_pwm_dma_start(&players[k]);
+    }
+    while (!all_idle(n)) {
+        __wfe();
+    }
+    sim_hw_set_cc_hook(NULL, NULL);
+    for (size_t k = 0; k < n; ++k) {
+        audio_pwm_dma_deinit(&players[k]);
+    }
+    return true;
+}
+
+static bool same_trace(const trace_t *a, const trace_t *b) {
+    if (a->count != b->count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->count; ++i) {
+        if (a->events[i].cycle != b->events[i].cycle || a->events[i].level != b->events[i].level) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool claims_released(void) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+        if (dma_channel_is_claimed(ch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    uint32_t clk_hz = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 125000000u;
+    uint64_t stagger = clk_hz / 50u;
+    bool ok = true;
+
+    sim_hw_reset(clk_hz);
+    wav_info_t clips[MAX_INSTANCES];
+    for (uint i = 0; i < MAX_INSTANCES; ++i) {
+        clips[i] = make_clip(&specs[i], i);
+    }
+
+    trace_t solo[MAX_INSTANCES];
+    for (size_t i = 0; i < MAX_INSTANCES; ++i) {
+        if (!run(clips, i, 1, 0)) {
+            return 1;
+        }
+        solo[i] = traces[0];
+        traces[0] = (trace_t){0};
+    }
+
+    if (!run(clips, 0, MAX_INSTANCES, stagger)) {
+        return 1;
+    }
+    printf("%-18s %6s %8s %10s  %s\n", "instance", "slice", "pace", "samples", "vs solo");
+    for (size_t i = 0; i < MAX_INSTANCES; ++i) {
+        bool same = same_trace(&solo[i], &traces[i]);
+        ok = ok && same;
+        printf("%-18s %6u %8s %10zu  %s\n", specs[i].name, traces[i].slice,
+               traces[i].timer_paced ? "timer" : "pwm", traces[i].count, same ? "identical" : "DIFFERS");
+    }
+
+    // Timer-paced players claim no pacing slice, so the slices they leave
+    // take more players: try one on each remaining slice, with a clip that
+    // was timer-paced if any was. The slices held must not overlap, and
+    // claims must not leak from the players refused.
+    for (size_t i = 0; i < MAX_INSTANCES; ++i) {
+        audio_pwm_dma_init(&players[i], &clips[i], 2u * (uint)i);
+    }
+    size_t timer_clip = 0, timer_paced = 0;
+    for (size_t i = 0; i < MAX_INSTANCES; ++i) {
+        if (players[i].pace_timer >= 0) {
+            timer_clip = i;
+            ++timer_paced;
+        }
+    }
+    static audio_player_t extra[MAX_INSTANCES];
+    size_t fitted = 0;
+    for (uint gpio = 2u * MAX_INSTANCES; gpio < 2u * NUM_PWM_SLICES; gpio += 2u) {
+        fitted += audio_pwm_dma_init(&extra[fitted], &clips[timer_clip], gpio);
+    }
+    bool exclusive = true;
+    uint32_t held = 0;
+    for (size_t k = 0; k < MAX_INSTANCES + fitted; ++k) {
+        const audio_player_t *p = k < MAX_INSTANCES ? &players[k] : &extra[k - MAX_INSTANCES];
+        bool own_pace = p->pace_slice != p->slice_num;
+        uint32_t uses = (1u << p->slice_num) | (1u << p->pace_slice);
+        exclusive = exclusive && own_pace == (p->pace_timer < 0) && !(held & uses);
+        held |= uses;
+    }
+    for (size_t i = 0; i < MAX_INSTANCES; ++i) {
+        audio_pwm_dma_deinit(&players[i]);
+    }
+    for (size_t k = 0; k < fitted; ++k) {
+        audio_pwm_dma_deinit(&extra[k]);
+    }
+    // The top slice, the first one claimed for pacing, must be free again.
+    static audio_player_t last;
+    bool released = claims_released() && audio_pwm_dma_init(&last, &clips[0], 2u * NUM_PWM_SLICES - 2u);
+    audio_pwm_dma_deinit(&last);
+    released = released && claims_released();
+    ok = ok && exclusive && (fitted > 0 || timer_paced == 0) && released;
+    printf("%zu timer-paced, %zu more players fit, slices held once each: %s; claims released after deinit: %s\n",
+           timer_paced, fitted, exclusive ? "yes" : "NO", released ? "yes" : "NO");
+
+    printf("%s\n", ok ? "no interference" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
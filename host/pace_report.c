@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_pwm_dma.h"
+#include "pace_solver.h"
+#include "sim_hw.h"
+
+// Tabulates pacing accuracy for common sample rates and clocks, checks every
+// chosen setting against PACE_BOUND_PPM, and confirms on the simulator that
+// the programmed DREQ actually runs at the reported rate. Rates too slow for
+// any divider must be refused. Exits non-zero if any check fails.
+
+static const uint32_t clocks[] = {125000000u, 133000000u, 150000000u, 200000000u};
+static const uint32_t rates[] = {100,   500,   1000,  2000,  4000,  8000,   11025,  16000,  22050,
+                                 24000, 32000, 37800, 44056, 44100, 47250, 48000, 50000, 64000,
+                                 88200, 96000, 176400, 192000};
+
+#define SIM_SAMPLES 2000u
+#define PACE_BOUND_PPM 5.0
+#define SIM_TOLERANCE_PPM 0.5
+
+static double ppm(int64_t ppb) {
+    return (double)ppb / 1000.0;
+}
+
+// Integer wrap with clkdiv 1.0, as the player used to program it.
+static double legacy_error_ppm(uint32_t clk_hz, uint32_t rate) {
+    uint32_t wrap = clk_hz / rate;
+    if (wrap == 0) {
+        wrap = 1;
+    }
+    if (wrap > 0x10000u) {
+        wrap = 0x10000u;
+    }
+    return ((double)clk_hz / wrap / rate - 1.0) * 1e6;
+}
+
+typedef struct {
+    uint slice;
+    uint64_t first;
+    uint64_t last;
+    uint32_t writes;
+} timing_t;
+
+static void time_cc(void *ctx, uint slice, uint32_t cc, uint64_t cycle) {
+    (void)cc;
+    timing_t *t = ctx;
+    if (slice != t->slice || t->writes == SIM_SAMPLES) {
+        return;
+    }
+    if (t->writes++ == 0) {
+        t->first = cycle;
+    }
+    t->last = cycle;
+}
+
+// Plays a silent u8 clip on the simulator and returns the measured DREQ rate.
+static double simulated_rate(uint32_t clk_hz, uint32_t rate, audio_player_t *player) {
+    static uint8_t *pcm;
+    if (!pcm) {
+        pcm = sim_hw_alloc(SIM_SAMPLES);
+        memset(pcm, 128, SIM_SAMPLES);
+    }
+    sim_hw_reset(clk_hz);
+    wav_info_t wav = {.data = pcm, .data_size = SIM_SAMPLES, .sample_rate = rate, .bits_per_sample = 8, .channels = 1};
+    if (!audio_pwm_dma_init(player, &wav, 0)) {
+        return 0.0;
+    }
+    timing_t t = {.slice = player->slice_num};
+    sim_hw_set_cc_hook(time_cc, &t);
+    audio_pwm_dma_start(player);
+    audio_pwm_dma_wait(player);
+    audio_pwm_dma_deinit(player);
+    sim_hw_set_cc_hook(NULL, NULL);
+    if (t.writes < SIM_SAMPLES) {
+        return 0.0;
+    }
+    return (double)(SIM_SAMPLES - 1u) * clk_hz / (double)(t.last - t.first);
+}
+
+// Rates below the slowest PWM divider and wrap (clk_sys / 2^24, about
+// 7.45 Hz at 125 MHz) must be refused by the solver and by init, with and
+// without the DMA timer, while the slowest reachable one still solves.
+static bool check_unreachable(audio_player_t *player) {
+    static const struct {
+        uint32_t rate;
+        bool reachable;
+    } cases[] = {{1, false}, {7, false}, {8, true}};
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        pace_solution_t pace;
+        bool pwm = pace_solve(125000000u, cases[i].rate, false, &pace);
+        bool any = pace_solve(125000000u, cases[i].rate, true, &pace);
+        sim_hw_reset(125000000u);
+        static uint8_t pcm[16];
+        wav_info_t wav = {.data = pcm, .data_size = sizeof(pcm), .sample_rate = cases[i].rate, .bits_per_sample = 8,
+                          .channels = 1};
+        bool init = audio_pwm_dma_init(player, &wav, 0);
+        if (init) {
+            audio_pwm_dma_deinit(player);
+        }
+        bool right = pwm == cases[i].reachable && any == cases[i].reachable && init == cases[i].reachable;
+        printf("%3lu Hz at 125 MHz: %s%s\n", (unsigned long)cases[i].rate, any ? "solved" : "refused",
+               right ? "" : "  WRONG");
+        ok = ok && right;
+    }
+    return ok;
+}
+
+int main(void) {
+    static audio_player_t player;
+    bool ok = true;
+    double worst_ppm = 0.0;
+
+    for (size_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); ++c) {
+        uint32_t clk_hz = clocks[c];
+        printf("clk_sys %lu Hz\n", (unsigned long)clk_hz);
+        printf("%8s %12s %10s %10s  %-20s %10s\n", "rate", "legacy ppm", "pwm ppm", "chosen ppm", "chosen",
+               "sim ppm");
+        for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r) {
+            uint32_t rate = rates[r];
+            pace_solution_t pwm, best;
+            pace_solve(clk_hz, rate, false, &pwm);
+            pace_solve(clk_hz, rate, true, &best);
+
+            double pwm_ppm = ppm(pwm.error_ppb);
+            double best_ppm = ppm(best.error_ppb);
+            double abs_pwm = pwm_ppm < 0 ? -pwm_ppm : pwm_ppm;
+            double abs_best = best_ppm < 0 ? -best_ppm : best_ppm;
+            if (abs_best > PACE_BOUND_PPM || abs_best > abs_pwm) {
+                ok = false;
+            }
+
+            char chosen[32];
+            if (best.source == PACE_SOURCE_PWM) {
+                snprintf(chosen, sizeof(chosen), "pwm (%u+%u/16)*%u", best.pwm_div_int, best.pwm_div_frac,
+                         best.pwm_wrap + 1u);
+            } else {
+                snprintf(chosen, sizeof(chosen), "timer %u/%u", best.timer_num, best.timer_den);
+            }
+
+            double measured = simulated_rate(clk_hz, rate, &player);
+            double sim_ppm = (measured / rate - 1.0) * 1e6;
+            double reported_ppm = ((player.pace_rate_millihz / 1000.0) / rate - 1.0) * 1e6;
+            if (measured == 0.0 || sim_ppm - reported_ppm > SIM_TOLERANCE_PPM ||
+                reported_ppm - sim_ppm > SIM_TOLERANCE_PPM) {
+                ok = false;
+            }
+
+            if (abs_best > worst_ppm) {
+                worst_ppm = abs_best;
+            }
+            printf("%8lu %12.3f %10.3f %10.3f  %-20s %10.3f\n", (unsigned long)rate,
+                   legacy_error_ppm(clk_hz, rate), pwm_ppm, best_ppm, chosen, sim_ppm);
+        }
+        printf("\n");
+    }
+
+    ok = check_unreachable(&player) && ok;
+    printf("worst chosen error %.3f ppm (bound %.1f ppm); %s\n", worst_ppm, PACE_BOUND_PPM,
+           ok ? "all checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
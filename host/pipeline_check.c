@@ -0,0 +1,251 @@
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "audio_mixer.h"
+#include "audio_pwm_dma.h"
+#include "capture.h"
+#include "sim_hw.h"
+#include "wav.h"
+#include "wav_convert.h"
+#include "wav_io.h"
+
+// Checks pipeline players, whose ring core 1 refills, with core 1 as a
+// host thread beside the simulator. In lockstep (the simulator waits for
+// core 1 to fill the ring before each step) every source, dither,
+// sigma-delta and a mixer must give exactly the output of the same player
+// refilled by its IRQ, with no underruns; so must a clip started with
+// audio_pwm_dma_play() over one still playing. Then a stress run lets both
+// threads race, with the simulator stepping and sleeping at random over a
+// small ring: every run must finish, and any output that differs from the
+// clean one must show underruns. Prints the ring occupancy stats. Exits
+// non-zero on any failure.
+
+#define CLK_HZ 125000000u
+#define STRESS_RUNS 24u
+#define STRESS_FRAMES 11025u
+
+typedef struct {
+    const char *name;
+    const wav_info_t *wav;
+    audio_mixer_t *mixer;
+    audio_pwm_dma_dither_t dither;
+    uint oversample;
+    uint count;
+    uint samples;
+} case_t;
+
+static audio_player_t player;
+static uint16_t ring_storage[16 * 256];
+
+// Lets core 1 fill every buffer it may before the simulator goes on.
+static void wait_for_core1(void) {
+    while (!audio_pwm_dma_is_idle(&player) && atomic_load(&player.pipe_drain) == 0 &&
+           atomic_load(&player.pipe_filled) - atomic_load(&player.pipe_done) < player.buffer_count) {
+        sched_yield();
+    }
+}
+
+static bool start(const case_t *c, bool pipeline, capture_t *cap) {
+    audio_pwm_dma_config_t config = audio_pwm_dma_get_default_config(0);
+    config.buffers = ring_storage;
+    config.buffer_count = c->count;
+    config.buffer_samples = c->samples;
+    config.dither = c->dither;
+    config.oversample = c->oversample;
+    config.mixer = c->mixer;
+    config.pipeline = pipeline;
+    if (!audio_pwm_dma_init_with_config(&player, c->wav, &config)) {
+        return false;
+    }
+    memset(cap, 0, sizeof(*cap));
+    cap->slice = player.slice_num;
+    cap->channel = player.pwm_channel;
+    sim_hw_set_cc_hook(capture_cc, cap);
+    cap->armed = true;
+    audio_pwm_dma_start(&player);
+    return true;
+}
+
+// Plays a case to its end (a mixer for frames) in steps of a quarter
+// buffer, in lockstep with core 1 when pipelined.
+static bool render(const case_t *c, bool pipeline, size_t frames, capture_t *cap, audio_pwm_dma_stats_t *stats) {
+    sim_hw_reset(CLK_HZ);
+    if (c->mixer) {
+        audio_mixer_init(c->mixer, c->wav->sample_rate, false);
+        audio_mixer_play(c->mixer, c->wav, AUDIO_MIXER_UNITY / 2, 0, true);
+        audio_mixer_play(c->mixer, c->wav, AUDIO_MIXER_UNITY, 0, false);
+    }
+    if (!start(c, pipeline, cap)) {
+        return false;
+    }
+    uint64_t step = (uint64_t)CLK_HZ / c->wav->sample_rate * (c->samples / c->oversample / 4u);
+    while (!audio_pwm_dma_is_idle(&player) && (!c->mixer || cap->count < frames)) {
+        if (pipeline) {
+            wait_for_core1();
+        }
+        sim_hw_run(step);
+    }
+    cap->armed = false;
+    audio_pwm_dma_get_stats(&player, stats);
+    audio_pwm_dma_deinit(&player);
+    return true;
+}
+
+static bool same_capture(const capture_t *a, const capture_t *b, size_t length) {
+    return a->count >= length && b->count >= length && !memcmp(a->levels, b->levels, length * sizeof(*a->levels));
+}
+
+static void print_row(const char *name, const audio_pwm_dma_stats_t *stats, uint count, uint samples,
+                      const char *result) {
+    printf("%-16s %9u %8u %10u %10u %9u  %s\n", name, (unsigned)stats->underruns, (unsigned)stats->refills,
+           (unsigned)stats->queued_min, (unsigned)stats->queued_avg, count * samples, result);
+}
+
+static bool check_exact(const case_t *c) {
+    capture_t want, got;
+    audio_pwm_dma_stats_t ref_stats, stats;
+    size_t frames = c->wav->sample_rate;
+    bool ok = render(c, false, frames, &want, &ref_stats) && render(c, true, frames, &got, &stats);
+    size_t length = c->mixer ? frames : want.count;
+    ok = ok && got.count == want.count && same_capture(&got, &want, length) && stats.underruns == 0 &&
+         ref_stats.underruns == 0;
+    print_row(c->name, &stats, c->count, c->samples, ok ? "exact" : "MISMATCH");
+    capture_free(&want);
+    capture_free(&got);
+    return ok;
+}
+
+// audio_pwm_dma_play() over a clip still playing stops core 1, re-primes
+// the ring and restarts it; from there the output must be the new clip's.
+static bool check_replay(const case_t *first, const case_t *second) {
+    capture_t want, got;
+    audio_pwm_dma_stats_t stats;
+    bool ok = render(second, false, 0, &want, &stats);
+    sim_hw_reset(CLK_HZ);
+    ok = ok && start(first, true, &got);
+    for (int i = 0; ok && i < 40; ++i) {
+        wait_for_core1();
+        sim_hw_run(CLK_HZ / 1000u);
+    }
+    audio_pwm_dma_config_t config = audio_pwm_dma_get_default_config(8);
+    config.pipeline = true;
+    static audio_player_t other;
+    bool refused = !audio_pwm_dma_init_with_config(&other, second->wav, &config);
+    ok = ok && audio_pwm_dma_play(&player, second->wav);
+    got.count = 0;
+    while (ok && !audio_pwm_dma_is_idle(&player)) {
+        wait_for_core1();
+        sim_hw_run(CLK_HZ / 4000u);
+    }
+    got.armed = false;
+    audio_pwm_dma_get_stats(&player, &stats);
+    audio_pwm_dma_deinit(&player);
+    ok = ok && refused && got.count == want.count && same_capture(&got, &want, want.count);
+    print_row("play over play", &stats, first->count, first->samples, ok ? "exact" : "MISMATCH");
+    printf("second pipeline player %s\n", refused ? "refused" : "NOT REFUSED");
+    capture_free(&want);
+    capture_free(&got);
+    return ok;
+}
+
+// Both threads free-running: the simulator steps up to one and a half
+// buffers at a time and sometimes sleeps, so core 1 is sometimes ahead and
+// sometimes late.
+static bool check_stress(const case_t *c) {
+    capture_t clean, cap;
+    audio_pwm_dma_stats_t stats;
+    if (!render(c, false, 0, &clean, &stats)) {
+        return false;
+    }
+    // A late final IRQ only lets more midpoint through before the stop, so
+    // outputs are compared without their trailing midpoint run.
+    size_t length = capture_audible_length(&clean, 128);
+    uint32_t seed = 0x6d2b79f5u;
+    uint64_t frame_cycles = CLK_HZ / c->wav->sample_rate;
+    uint32_t glitched = 0, underrun_runs = 0, underruns = 0, queued_min = UINT32_MAX;
+    uint64_t queued_sum = 0;
+    bool ok = true;
+    for (uint r = 0; r < STRESS_RUNS && ok; ++r) {
+        sim_hw_reset(CLK_HZ);
+        if (!start(c, true, &cap)) {
+            return false;
+        }
+        uint64_t limit = sim_hw_now() + 4u * frame_cycles * STRESS_FRAMES;
+        while (!audio_pwm_dma_is_idle(&player) && sim_hw_now() < limit) {
+            seed = seed * 1664525u + 1013904223u;
+            sim_hw_run(frame_cycles * (1u + (seed >> 8) % (c->samples * 3u / 2u)));
+            if ((seed >> 4) % 4u != 0) {
+                usleep(200u + (seed >> 12) % 800u);
+            }
+        }
+        bool finished = audio_pwm_dma_is_idle(&player);
+        cap.armed = false;
+        audio_pwm_dma_get_stats(&player, &stats);
+        audio_pwm_dma_deinit(&player);
+        bool same = capture_audible_length(&cap, 128) == length && same_capture(&cap, &clean, length);
+        glitched += !same;
+        underrun_runs += stats.underruns != 0;
+        underruns += stats.underruns;
+        queued_min = stats.queued_min < queued_min ? stats.queued_min : queued_min;
+        queued_sum += stats.queued_avg;
+        if (!finished || (!same && stats.underruns == 0)) {
+            printf("stress run %u: %s\n", r, finished ? "GLITCH WITHOUT UNDERRUNS" : "DID NOT FINISH");
+            ok = false;
+        }
+        capture_free(&cap);
+    }
+    printf("stress, %ux%u ring: %u runs, %u glitched, %u with underruns (%u in all), queued min %u avg %llu\n",
+           c->count, c->samples, STRESS_RUNS, glitched, underrun_runs, underruns, queued_min,
+           (unsigned long long)(queued_sum / STRESS_RUNS));
+    capture_free(&clean);
+    return ok;
+}
+
+int main(void) {
+    sim_hw_reset(CLK_HZ);
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(EMBED_SOURCE, &length);
+    wav_info_t source = {0};
+    if (!file || !parse_wav(file, length, &source)) {
+        fprintf(stderr, "%s: cannot load\n", EMBED_SOURCE);
+        return 1;
+    }
+    static wav_info_t s16, adpcm, qoa, mulaw, cut;
+    wav_convert_options_t to_s16 = {WAV_CONVERT_S16, 0, true}, to_adpcm = {WAV_CONVERT_IMA_ADPCM, 0, true},
+                          to_qoa = {WAV_CONVERT_QOA, 0, true}, to_mulaw = {WAV_CONVERT_MULAW, 0, true};
+    if (!wav_convert(&source, &to_s16, &s16) || !wav_convert(&source, &to_adpcm, &adpcm) ||
+        !wav_convert(&source, &to_qoa, &qoa) || !wav_convert(&source, &to_mulaw, &mulaw)) {
+        fprintf(stderr, "%s: conversion failed\n", EMBED_SOURCE);
+        return 1;
+    }
+    cut = s16;
+    cut.data_size = STRESS_FRAMES * 2u < s16.data_size ? STRESS_FRAMES * 2u : s16.data_size;
+
+    static audio_mixer_t mixer;
+    const case_t cases[] = {
+        {"s16", &s16, NULL, AUDIO_PWM_DMA_DITHER_NONE, 1, 4, 256},
+        {"s16 2x512", &s16, NULL, AUDIO_PWM_DMA_DITHER_NONE, 1, 2, 512},
+        {"s16 shaped2", &s16, NULL, AUDIO_PWM_DMA_DITHER_SHAPED2, 1, 4, 256},
+        {"adpcm", &adpcm, NULL, AUDIO_PWM_DMA_DITHER_NONE, 1, 8, 128},
+        {"qoa", &qoa, NULL, AUDIO_PWM_DMA_DITHER_TPDF, 1, 4, 256},
+        {"mulaw", &mulaw, NULL, AUDIO_PWM_DMA_DITHER_NONE, 1, 16, 64},
+        {"s16 sigma-delta", &s16, NULL, AUDIO_PWM_DMA_DITHER_NONE, 8, 4, 1024},
+        {"mixer", &s16, &mixer, AUDIO_PWM_DMA_DITHER_NONE, 1, 4, 256},
+    };
+    const case_t short_clip = {"s16 cut", &cut, NULL, AUDIO_PWM_DMA_DITHER_NONE, 1, 4, 256};
+    const case_t stress = {"stress", &cut, NULL, AUDIO_PWM_DMA_DITHER_NONE, 1, 4, 64};
+
+    printf("%-16s %9s %8s %10s %10s %9s  %s\n", "case", "underruns", "refills", "queued min", "queued avg", "ring",
+           "output");
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        ok = check_exact(&cases[i]) && ok;
+    }
+    ok = check_replay(&cases[0], &short_clip) && ok;
+    ok = check_stress(&stress) && ok;
+    printf("%s\n", ok ? "pipeline checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
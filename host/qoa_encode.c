@@ -0,0 +1,75 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "qoa.h"
+#include "qoa_ref.h"
+#include "sim_hw.h"
+#include "wav.h"
+#include "wav_io.h"
+
+// Converts an 8/16-bit PCM WAV to QOA, about a fifth of the 16-bit size, for
+// the player to decode on the fly. Prints the size and the SNR of the
+// decoded result against the input.
+
+static void usage(void) {
+    fprintf(stderr, "usage: qoa_encode in.wav out.qoa\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3 || argv[1][0] == '-' || argv[2][0] == '-') {
+        usage();
+    }
+
+    sim_hw_reset(125000000u);
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(argv[1], &length);
+    wav_info_t wav = {0};
+    if (!file || !parse_wav(file, length, &wav) || wav.encoding != WAV_ENCODING_PCM || wav.is_float ||
+        wav.bits_per_sample > 16) {
+        fprintf(stderr, "%s: not an 8/16-bit PCM WAV\n", argv[1]);
+        return 1;
+    }
+
+    size_t frames = wav_frame_count(&wav);
+    size_t samples = frames * wav.channels;
+    int16_t *pcm = malloc(samples * sizeof(*pcm));
+    if (!pcm) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < samples; ++i) {
+        pcm[i] = wav.bits_per_sample == 8 ? (int16_t)((wav.data[i] - 128) * 256)
+                                           : (int16_t)(wav.data[2 * i] | (wav.data[2 * i + 1] << 8));
+    }
+
+    size_t size = 0;
+    uint8_t *qoa = qoa_ref_encode(pcm, frames, wav.channels, wav.sample_rate, &size);
+    FILE *f = qoa ? fopen(argv[2], "wb") : NULL;
+    bool ok = f && fwrite(qoa, 1, size, f) == size;
+    if (!f || fclose(f) != 0 || !ok) {
+        fprintf(stderr, "%s: write failed\n", argv[2]);
+        return 1;
+    }
+
+    // Round trip through the parser and the reference decoder.
+    wav_info_t check = {0};
+    int16_t *decoded = parse_qoa(qoa, size, &check) ? qoa_ref_decode(&check) : NULL;
+    if (!decoded || wav_frame_count(&check) != frames) {
+        fprintf(stderr, "%s: encoded file does not parse back\n", argv[2]);
+        return 1;
+    }
+    double signal = 0.0, noise = 0.0;
+    for (size_t i = 0; i < samples; ++i) {
+        double e = (double)pcm[i] - decoded[i];
+        signal += (double)pcm[i] * pcm[i];
+        noise += e * e;
+    }
+    printf("%zu frames, %zu -> %zu bytes (%.2f bits/sample), SNR %.1f dB\n", frames, wav.data_size, size,
+           size * 8.0 / (double)samples, 10.0 * log10(signal / (noise > 0.0 ? noise : 1e-9)));
+    free(decoded);
+    free(qoa);
+    free(pcm);
+    return 0;
+}
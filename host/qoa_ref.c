@@ -0,0 +1,200 @@
+#include "qoa_ref.h"
+
+#include <stdlib.h>
+
+#include "qoa.h"
+
+static const int ref_scalefactors[16] = {1,   7,   21,  45,  84,   138,  211,  304,
+                                         421, 562, 731, 928, 1157, 1419, 1715, 2048};
+
+// The code for each residual/scale factor from -8 to 8, as the spec pairs
+// them with the dequantized values below.
+static const int ref_quant[17] = {7, 7, 7, 5, 5, 3, 3, 1, 0, 0, 2, 2, 4, 4, 6, 6, 6};
+
+// Code q of scale factor sf: 0.75, 2.5, 4.5 or 7 times sf, with even codes
+// positive, rounded half away from zero. Computed rather than tabled so it
+// checks the player's table.
+static int ref_dequant(int sf, int q) {
+    static const int quarters[4] = {3, 10, 18, 28};
+    int v = (ref_scalefactors[sf] * quarters[q >> 1] + 2) / 4;
+    return q & 1 ? -v : v;
+}
+
+typedef struct {
+    int history[4];
+    int weights[4];
+} ref_lms_t;
+
+static int ref_predict(const ref_lms_t *lms) {
+    int sum = 0;
+    for (int i = 0; i < 4; ++i) {
+        sum += lms->history[i] * lms->weights[i];
+    }
+    return sum >> 13;
+}
+
+static int ref_clamp(int v, int lo, int hi) {
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+static void ref_update(ref_lms_t *lms, int sample, int residual) {
+    int delta = residual >> 4;
+    for (int i = 0; i < 4; ++i) {
+        lms->weights[i] += lms->history[i] < 0 ? -delta : delta;
+    }
+    for (int i = 0; i < 3; ++i) {
+        lms->history[i] = lms->history[i + 1];
+    }
+    lms->history[3] = sample;
+}
+
+static uint64_t ref_read_be(const uint8_t *p, unsigned bytes) {
+    uint64_t v = 0;
+    for (unsigned i = 0; i < bytes; ++i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static void ref_write_be(uint8_t *p, uint64_t v, unsigned bytes) {
+    for (unsigned i = bytes; i-- > 0;) {
+        p[i] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+int16_t *qoa_ref_decode(const wav_info_t *wav) {
+    size_t frames = wav_frame_count(wav);
+    uint16_t ch = wav->channels;
+    int16_t *out = malloc((frames ? frames : 1) * ch * sizeof(*out));
+    if (!out) {
+        return NULL;
+    }
+    // Sample k of QOA frame q: LMS state is reloaded at k == 0, and slice
+    // k / 20 of channel c is the (k / 20 * ch + c)th word after it.
+    ref_lms_t lms[2];
+    for (size_t f = 0; f < frames; ++f) {
+        size_t k = f % QOA_FRAME_LEN;
+        const uint8_t *base = wav->data + f / QOA_FRAME_LEN * wav->block_align;
+        for (uint16_t c = 0; c < ch; ++c) {
+            if (k == 0) {
+                for (int i = 0; i < 4; ++i) {
+                    lms[c].history[i] = (int16_t)ref_read_be(base + 8 + 16 * c + 2 * i, 2);
+                    lms[c].weights[i] = (int16_t)ref_read_be(base + 16 + 16 * c + 2 * i, 2);
+                }
+            }
+            const uint8_t *word = base + 8 + 16 * ch + 8 * ((k / QOA_SLICE_LEN) * ch + c);
+            uint64_t slice = ref_read_be(word, 8);
+            int sf = (int)(slice >> 60);
+            int q = (int)(slice >> (57 - 3 * (k % QOA_SLICE_LEN))) & 7;
+            int residual = ref_dequant(sf, q);
+            int sample = ref_clamp(ref_predict(&lms[c]) + residual, -32768, 32767);
+            ref_update(&lms[c], sample, residual);
+            out[f * ch + c] = (int16_t)sample;
+        }
+    }
+    return out;
+}
+
+// Residual over scale factor, rounded to nearest.
+static int ref_div(int v, int sf) {
+    int half = ref_scalefactors[sf] / 2;
+    return (v + (v < 0 ? -half : half)) / ref_scalefactors[sf];
+}
+
+// Sum of the squared weights above the level a stable predictor reaches,
+// squared: added to a trial's error so runaway weights lose the search.
+static int64_t ref_weights_penalty(const ref_lms_t *lms) {
+    int64_t sum = 0;
+    for (int i = 0; i < 4; ++i) {
+        sum += (int64_t)lms->weights[i] * lms->weights[i];
+    }
+    int64_t excess = (sum >> 18) - 0x8ff;
+    return excess > 0 ? excess * excess : 0;
+}
+
+// Encodes n samples of channel c from frame first into one slice word,
+// advancing lms. The search starts at the last slice's scale factor, so
+// the early exit cuts most trials short.
+static uint64_t ref_encode_slice(const int16_t *pcm, size_t first, size_t n, uint16_t ch, uint16_t c,
+                                 ref_lms_t *lms, int *prev_sf) {
+    uint64_t best_rank = UINT64_MAX, best_slice = 0;
+    ref_lms_t best_lms = *lms;
+    int best_sf = 0;
+    for (int i = 0; i < 16; ++i) {
+        int sf = (i + *prev_sf) % 16;
+        ref_lms_t trial = *lms;
+        uint64_t slice = (uint64_t)sf;
+        uint64_t rank = 0;
+        for (size_t s = 0; s < n; ++s) {
+            int sample = pcm[(first + s) * ch + c];
+            int predicted = ref_predict(&trial);
+            int q = ref_quant[ref_clamp(ref_div(sample - predicted, sf), -8, 8) + 8];
+            int residual = ref_dequant(sf, q);
+            int reconstructed = ref_clamp(predicted + residual, -32768, 32767);
+            int64_t error = sample - reconstructed;
+            rank += (uint64_t)(error * error + ref_weights_penalty(&trial));
+            if (rank > best_rank) {
+                break;
+            }
+            ref_update(&trial, reconstructed, residual);
+            slice = (slice << 3) | (uint64_t)q;
+        }
+        if (rank < best_rank) {
+            best_rank = rank;
+            best_slice = slice;
+            best_lms = trial;
+            best_sf = sf;
+        }
+    }
+    *prev_sf = best_sf;
+    *lms = best_lms;
+    return best_slice << (3 * (QOA_SLICE_LEN - n));
+}
+
+uint8_t *qoa_ref_encode(const int16_t *pcm, size_t frames, uint16_t channels, uint32_t sample_rate,
+                        size_t *size_out) {
+    size_t qframes = (frames + QOA_FRAME_LEN - 1) / QOA_FRAME_LEN;
+    size_t slices = (frames + QOA_SLICE_LEN - 1) / QOA_SLICE_LEN;
+    size_t size = 8 + qframes * (8 + 16u * channels) + slices * 8u * channels;
+    bool fits = frames && frames <= UINT32_MAX && channels <= 2 && sample_rate && sample_rate < (1u << 24);
+    uint8_t *out = fits ? malloc(size) : NULL;
+    if (!out) {
+        return NULL;
+    }
+    ref_write_be(out, 0x716f6166u, 4);
+    ref_write_be(out + 4, frames, 4);
+
+    ref_lms_t lms[2];
+    int prev_sf[2] = {0, 0};
+    for (uint16_t c = 0; c < channels; ++c) {
+        lms[c] = (ref_lms_t){.history = {0, 0, 0, 0}, .weights = {0, 0, -(1 << 13), 1 << 14}};
+    }
+    uint8_t *p = out + 8;
+    for (size_t first = 0; first < frames; first += QOA_FRAME_LEN) {
+        size_t n = frames - first < QOA_FRAME_LEN ? frames - first : QOA_FRAME_LEN;
+        size_t frame_size = 8 + 16u * channels + (n + QOA_SLICE_LEN - 1) / QOA_SLICE_LEN * 8u * channels;
+        uint64_t header = ((uint64_t)channels << 56) | ((uint64_t)sample_rate << 32) | ((uint64_t)n << 16);
+        ref_write_be(p, header | frame_size, 8);
+        p += 8;
+        for (uint16_t c = 0; c < channels; ++c) {
+            // The decoder only sees 16 bits of each; carry on from what it sees.
+            for (int i = 0; i < 4; ++i) {
+                lms[c].history[i] = (int16_t)lms[c].history[i];
+                lms[c].weights[i] = (int16_t)lms[c].weights[i];
+                ref_write_be(p + 2 * i, (uint16_t)lms[c].history[i], 2);
+                ref_write_be(p + 8 + 2 * i, (uint16_t)lms[c].weights[i], 2);
+            }
+            p += 16;
+        }
+        for (size_t s = 0; s < n; s += QOA_SLICE_LEN) {
+            size_t len = n - s < QOA_SLICE_LEN ? n - s : QOA_SLICE_LEN;
+            for (uint16_t c = 0; c < channels; ++c) {
+                ref_write_be(p, ref_encode_slice(pcm, first + s, len, channels, c, &lms[c], &prev_sf[c]), 8);
+                p += 8;
+            }
+        }
+    }
+    *size_out = size;
+    return out;
+}
@@ -0,0 +1,24 @@
+#ifndef QOA_REF_H
+#define QOA_REF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wav.h"
+
+// Host-side QOA reference, written from the format specification
+// independently of the player's decoder: a per-sample decoder to check it
+// against, and an encoder to make clips.
+
+// Decodes a parsed QOA file (see parse_qoa()) to interleaved s16; returns a
+// malloc'd buffer of wav_frame_count() frames, or NULL.
+int16_t *qoa_ref_decode(const wav_info_t *wav);
+
+// Encodes interleaved s16 frames into a whole QOA file. Each slice tries all
+// 16 scale factors and keeps the one with the least squared error, plus a
+// penalty on large LMS weights so the predictor stays stable. Returns a
+// malloc'd buffer and its size, or NULL.
+uint8_t *qoa_ref_encode(const int16_t *pcm, size_t frames, uint16_t channels, uint32_t sample_rate,
+                        size_t *size_out);
+
+#endif
@@ -0,0 +1,177 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "audio_ring.h"
+
+// Checks audio_ring_t on its own, built with ThreadSanitizer (no simulator:
+// TSan needs a position-independent binary, the simulator a fixed one).
+// First the edge cases on one thread: init limits, a full and an empty
+// ring, spans that stop at the wrap, copies across it, close. Then a
+// producer and a consumer thread stream a numbered sequence through rings
+// of several sizes, each side picking the copy or the span calls and the
+// block size at random: every frame must arrive once, in order, and the
+// consumer must see the end only after the last one. TSan reports any
+// access the ring's atomics do not order and fails the run with exit code
+// 66. Exits non-zero on any failure.
+
+#define STREAM_FRAMES (1u << 20)
+#define MAX_BLOCK 300u
+
+typedef struct {
+    audio_ring_t ring;
+    int16_t *storage;
+    bool ok;
+} stream_t;
+
+// The sample of channel c of frame i in the stream.
+static int16_t stream_sample(uint32_t i, uint c) {
+    return (int16_t)(i * 2654435761u >> 16) ^ (int16_t)c;
+}
+
+static uint32_t next_random(uint32_t *seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 8;
+}
+
+static void *producer(void *arg) {
+    stream_t *s = arg;
+    audio_ring_t *ring = &s->ring;
+    int16_t block[MAX_BLOCK * 2];
+    uint32_t seed = 0x9e3779b9u, written = 0;
+    while (written < STREAM_FRAMES) {
+        uint32_t r = next_random(&seed);
+        size_t want = 1u + r % MAX_BLOCK;
+        want = want < STREAM_FRAMES - written ? want : STREAM_FRAMES - written;
+        size_t n;
+        if (r & 0x10000u) {
+            int16_t *span = audio_ring_write_span(ring, &n);
+            n = n < want ? n : want;
+            for (size_t i = 0; i < n * ring->channels; ++i) {
+                span[i] = stream_sample(written + (uint32_t)(i / ring->channels), (uint)(i % ring->channels));
+            }
+            audio_ring_commit(ring, n);
+        } else {
+            for (size_t i = 0; i < want * ring->channels; ++i) {
+                block[i] = stream_sample(written + (uint32_t)(i / ring->channels), (uint)(i % ring->channels));
+            }
+            n = audio_ring_write(ring, block, want);
+        }
+        written += (uint32_t)n;
+        if (n == 0) {
+            sched_yield();
+        }
+    }
+    audio_ring_close(ring);
+    return NULL;
+}
+
+static bool check_frames(const int16_t *p, size_t frames, uint channels, uint32_t first) {
+    for (size_t i = 0; i < frames * channels; ++i) {
+        if (p[i] != stream_sample(first + (uint32_t)(i / channels), (uint)(i % channels))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *consumer(void *arg) {
+    stream_t *s = arg;
+    audio_ring_t *ring = &s->ring;
+    int16_t block[MAX_BLOCK * 2];
+    uint32_t seed = 0x85ebca6bu, read = 0;
+    s->ok = true;
+    while (s->ok) {
+        uint32_t r = next_random(&seed);
+        size_t want = 1u + r % MAX_BLOCK;
+        size_t n;
+        if (r & 0x10000u) {
+            const int16_t *span = audio_ring_read_span(ring, &n);
+            n = n < want ? n : want;
+            s->ok = check_frames(span, n, ring->channels, read);
+            audio_ring_consume(ring, n);
+        } else {
+            n = audio_ring_read(ring, block, want);
+            s->ok = check_frames(block, n, ring->channels, read);
+        }
+        read += (uint32_t)n;
+        if (n == 0) {
+            if (audio_ring_ended(ring)) {
+                break;
+            }
+            sched_yield();
+        }
+    }
+    if (s->ok && read != STREAM_FRAMES) {
+        s->ok = false;
+    }
+    if (!s->ok) {
+        printf("stream broke at frame %u of %u\n", read, STREAM_FRAMES);
+    }
+    return NULL;
+}
+
+static bool check_stream(uint32_t frames, bool stereo) {
+    stream_t s;
+    s.storage = malloc((size_t)frames * 2u * sizeof(int16_t));
+    if (!s.storage || !audio_ring_init(&s.ring, s.storage, frames, 16000, stereo)) {
+        free(s.storage);
+        return false;
+    }
+    pthread_t threads[2];
+    pthread_create(&threads[0], NULL, producer, &s);
+    pthread_create(&threads[1], NULL, consumer, &s);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    printf("%-6s %5u-frame ring: %u frames %s\n", stereo ? "stereo" : "mono", frames, STREAM_FRAMES,
+           s.ok ? "in order" : "BROKEN");
+    free(s.storage);
+    return s.ok;
+}
+
+static bool check_edges(void) {
+    static _Alignas(4) int16_t storage[16 * 2 + 1];
+    audio_ring_t ring;
+    bool ok = !audio_ring_init(&ring, storage, 12, 16000, false) && !audio_ring_init(&ring, storage, 1, 16000, false) &&
+              !audio_ring_init(&ring, storage, 16, 0, false) &&
+              !audio_ring_init(&ring, storage + 1, 16, 16000, false) && audio_ring_init(&ring, storage, 16, 8000, true);
+    wav_info_t out = audio_ring_output(&ring);
+    ok = ok && out.channels == 2 && out.bits_per_sample == 16 && out.sample_rate == 8000 && !out.data;
+
+    int16_t in[20 * 2], back[20 * 2];
+    for (int i = 0; i < 40; ++i) {
+        in[i] = (int16_t)(i * 101);
+    }
+    size_t n;
+    ok = ok && audio_ring_free(&ring) == 16 && audio_ring_available(&ring) == 0;
+    ok = ok && audio_ring_read(&ring, back, 4) == 0 && audio_ring_read_span(&ring, &n) && n == 0;
+    // Fill past capacity, then drain 10 so the next write wraps.
+    ok = ok && audio_ring_write(&ring, in, 20) == 16 && audio_ring_free(&ring) == 0;
+    ok = ok && audio_ring_write_span(&ring, &n) && n == 0 && audio_ring_write(&ring, in, 1) == 0;
+    ok = ok && audio_ring_read(&ring, back, 10) == 10 && back[19] == in[19];
+    ok = ok && audio_ring_write(&ring, in + 32, 4) == 4;
+    // 6 frames up to the wrap, then 4 from the start of storage.
+    ok = ok && audio_ring_read_span(&ring, &n) == storage + 20 && n == 6 && audio_ring_available(&ring) == 10;
+    int16_t *span = audio_ring_write_span(&ring, &n);
+    ok = ok && span == storage + 8 && n == 6;
+    ok = ok && audio_ring_read(&ring, back, 20) == 10 && back[0] == in[20] && back[11] == in[31] &&
+         back[12] == in[32] && back[19] == in[39];
+    ok = ok && !audio_ring_ended(&ring);
+    audio_ring_write(&ring, in, 3);
+    audio_ring_close(&ring);
+    ok = ok && !audio_ring_ended(&ring) && audio_ring_read(&ring, back, 20) == 3 && audio_ring_ended(&ring);
+    printf("edge cases %s\n", ok ? "pass" : "FAIL");
+    return ok;
+}
+
+int main(void) {
+    bool ok = check_edges();
+    static const uint32_t sizes[] = {2, 64, 4096};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        ok = check_stream(sizes[i], false) && ok;
+        ok = check_stream(sizes[i], true) && ok;
+    }
+    printf("%s\n", ok ? "ring checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,341 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_pwm_dma.h"
+#include "capture.h"
+#include "ima_adpcm_ref.h"
+#include "qoa.h"
+#include "qoa_ref.h"
+#include "sim_hw.h"
+#include "wav.h"
+
+// Encodes one clip as u8 and s16 PCM, IMA ADPCM and QOA, mono and stereo,
+// and checks seeking on each. The position reached must be the target
+// rounded down to the encoding's restart point (any frame, an ADPCM block,
+// a QOA frame), and the levels played from there must match the reference
+// decode from that frame on. Seeks are tried on a prepared player before
+// and between refills, and on the simulator while the ring is playing,
+// where the output must switch to the new position at a buffer boundary
+// with nothing lost or repeated, and on a player that has finished, which
+// must play again from there once started. QOA files cut short or with bad headers
+// must parse to their whole leading frames or be rejected. Exits non-zero
+// on any mismatch.
+
+#define CLK_HZ 125000000u
+#define RATE 22050u
+#define FRAMES 12000u
+#define CHUNK 256u
+#define ADPCM_BLOCK 256u
+
+typedef struct {
+    const char *name;
+    uint16_t bits;
+    uint16_t channels;
+    wav_encoding_t encoding;
+} clip_spec_t;
+
+static const clip_spec_t specs[] = {
+    {"u8 mono", 8, 1, WAV_ENCODING_PCM},           {"s16 mono", 16, 1, WAV_ENCODING_PCM},
+    {"s16 stereo", 16, 2, WAV_ENCODING_PCM},       {"adpcm mono", 4, 1, WAV_ENCODING_IMA_ADPCM},
+    {"adpcm stereo", 4, 2, WAV_ENCODING_IMA_ADPCM}, {"qoa mono", 16, 1, WAV_ENCODING_QOA},
+    {"qoa stereo", 16, 2, WAV_ENCODING_QOA},
+};
+
+static const size_t targets[] = {0, 1, 504, 505, 1234, 5119, 5120, 5121, 10239, 10240, 11999, 12000, 20000};
+
+typedef struct {
+    wav_info_t wav;
+    uint16_t *expect;  // mono level per frame, from the reference decode
+    size_t frames;
+    size_t step;  // frames between restart points
+} clip_t;
+
+static audio_player_t player;
+
+// Builds the clip in simulator memory with the levels it must play as.
+static clip_t make_clip(const clip_spec_t *spec, const int16_t *pcm) {
+    uint16_t ch = spec->channels;
+    size_t samples = (size_t)FRAMES * ch;
+    clip_t clip = {.wav = {.sample_rate = RATE, .bits_per_sample = spec->bits, .channels = ch,
+                           .encoding = spec->encoding}};
+    int16_t *decoded = NULL;
+    if (spec->encoding == WAV_ENCODING_QOA) {
+        size_t size = 0;
+        uint8_t *qoa = qoa_ref_encode(pcm, FRAMES, ch, RATE, &size);
+        uint8_t *file = sim_hw_alloc(size);
+        memcpy(file, qoa, size);
+        free(qoa);
+        if (!parse_qoa(file, size, &clip.wav)) {
+            fprintf(stderr, "%s: encoded clip does not parse\n", spec->name);
+            exit(1);
+        }
+        decoded = qoa_ref_decode(&clip.wav);
+    } else if (spec->encoding == WAV_ENCODING_IMA_ADPCM) {
+        size_t size = 0;
+        uint16_t block_align = (uint16_t)(ADPCM_BLOCK * ch);
+        uint8_t *blocks = ima_ref_encode(pcm, FRAMES, ch, block_align, &size);
+        uint8_t *data = sim_hw_alloc(size);
+        memcpy(data, blocks, size);
+        free(blocks);
+        clip.wav.data = data;
+        clip.wav.data_size = size;
+        clip.wav.block_align = block_align;
+        clip.wav.samples_per_block = (uint16_t)((ADPCM_BLOCK - 4u) * 2u + 1u);
+        decoded = ima_ref_decode(&clip.wav);
+    } else {
+        clip.wav = make_pcm_clip(pcm, FRAMES, RATE, spec->bits, ch);
+        decoded = malloc(samples * sizeof(*decoded));
+        for (size_t i = 0; decoded && i < samples; ++i) {
+            decoded[i] = spec->bits == 8 ? (int16_t)((clip.wav.data[i] - 128) * 256) : pcm[i];
+        }
+    }
+    clip.frames = wav_frame_count(&clip.wav);
+    clip.step = spec->encoding == WAV_ENCODING_PCM ? 1u : clip.wav.samples_per_block;
+    clip.expect = malloc(clip.frames * sizeof(*clip.expect));
+    if (!decoded || !clip.expect) {
+        fprintf(stderr, "%s: reference decode failed\n", spec->name);
+        exit(1);
+    }
+    for (size_t f = 0; f < clip.frames; ++f) {
+        int32_t l = decoded[f * ch], r = decoded[f * ch + ch - 1];
+        clip.expect[f] = (uint16_t)((l + r + 65536) >> 9);
+    }
+    free(decoded);
+    return clip;
+}
+
+static size_t expected_position(const clip_t *clip, size_t target) {
+    return target < clip->frames ? target / clip->step * clip->step : clip->frames;
+}
+
+// Levels until the end of the data, a refill-sized chunk at a time; returns
+// whether they are expect[from..].
+static bool fill_matches(const clip_t *clip, size_t from) {
+    static uint16_t out[FRAMES + CHUNK];
+    size_t want = clip->frames - from;
+    for (size_t i = 0; i < want; i += CHUNK) {
+        audio_pwm_dma_fill(&player, out + i, CHUNK);
+    }
+    return !memcmp(out, clip->expect + from, want * sizeof(*out));
+}
+
+// Seeks on a prepared player, first before any refill and then after
+// skip frames have been played. Returns the number of failures.
+static int check_fill(const clip_t *clip, const char *name) {
+    int failures = 0;
+    for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); ++t) {
+        for (size_t skip = 0; skip <= 3000; skip += 3000) {
+            static uint16_t scratch[3000];
+            memset(&player, 0, sizeof(player));
+            if (!audio_pwm_dma_prepare(&player, &clip->wav)) {
+                fprintf(stderr, "%s: prepare failed\n", name);
+                exit(1);
+            }
+            if (skip) {
+                audio_pwm_dma_fill(&player, scratch, skip);
+            }
+            size_t position = SIZE_MAX;
+            bool ok = audio_pwm_dma_seek(&player, targets[t], &position);
+            size_t expect = expected_position(clip, targets[t]);
+            if (!ok || position != expect || !fill_matches(clip, position)) {
+                printf("  %s: seek to %zu after %zu frames %s (reached %zu, expected %zu)\n", name, targets[t], skip,
+                       ok ? "played wrong levels" : "failed", position, expect);
+                ++failures;
+            }
+        }
+    }
+    return failures;
+}
+
+// Whether the capture holds want[0..n) from write at on.
+static bool captured(const capture_t *cap, size_t at, const uint16_t *want, size_t n) {
+    if (at + n > cap->count) {
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (cap->levels[at + i] != want[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Plays the clip on the simulator with the default ring and seeks to target
+// once `after` levels have been written: the output must be expect[0..k]
+// then expect[position..] for one buffer boundary k. Zero-copy players can
+// only seek before start, so for them the seek comes first and the live one
+// must be refused. Returns the number of failures.
+static int check_live(const clip_t *clip, const char *name, size_t target, size_t after) {
+    sim_hw_reset(CLK_HZ);
+    if (!audio_pwm_dma_init(&player, &clip->wav, 0)) {
+        fprintf(stderr, "%s: init failed\n", name);
+        exit(1);
+    }
+    capture_t cap = {.slice = player.slice_num, .channel = player.pwm_channel, .armed = true};
+    bool zero_copy = player.zero_copy;
+    size_t position = 0;
+    bool refused = false;
+    if (zero_copy && !audio_pwm_dma_seek(&player, target, &position)) {
+        refused = true;
+    }
+    sim_hw_set_cc_hook(capture_cc, &cap);
+    audio_pwm_dma_start(&player);
+    while (cap.count < after && !audio_pwm_dma_is_idle(&player)) {
+        sim_hw_run(CLK_HZ / 1000u);
+    }
+    if (zero_copy) {
+        size_t ignored;
+        refused = refused || audio_pwm_dma_seek(&player, 0, &ignored);
+    } else if (!audio_pwm_dma_seek(&player, target, &position)) {
+        refused = true;
+    }
+    audio_pwm_dma_wait(&player);
+    sim_hw_set_cc_hook(NULL, NULL);
+    size_t samples = player.buffer_samples;
+    audio_pwm_dma_deinit(&player);
+
+    bool found = false;
+    size_t tail = clip->frames - position;
+    if (zero_copy) {
+        found = captured(&cap, 0, clip->expect + position, tail);
+    } else {
+        for (size_t k = 0; k <= cap.count && !found; k += samples) {
+            found = captured(&cap, 0, clip->expect, k) && captured(&cap, k, clip->expect + position, tail);
+        }
+    }
+    capture_free(&cap);
+    bool ok = !refused && found && position == expected_position(clip, target);
+    if (!ok) {
+        printf("  %s: live seek to %zu %s\n", name, target,
+               refused ? "refused" : found ? "reached the wrong frame" : "played wrong levels");
+    }
+    return ok ? 0 : 1;
+}
+
+// Plays the clip to its end, then seeks the finished player to target and
+// starts it again: it must play expect[position..] and stop. Returns the
+// number of failures.
+static int check_after_finish(const clip_t *clip, const char *name, size_t target) {
+    sim_hw_reset(CLK_HZ);
+    if (!audio_pwm_dma_init(&player, &clip->wav, 0)) {
+        fprintf(stderr, "%s: init failed\n", name);
+        exit(1);
+    }
+    capture_t cap = {.slice = player.slice_num, .channel = player.pwm_channel, .armed = true};
+    audio_pwm_dma_start(&player);
+    audio_pwm_dma_wait(&player);
+    size_t position = SIZE_MAX;
+    bool ok = audio_pwm_dma_seek(&player, target, &position);
+    sim_hw_set_cc_hook(capture_cc, &cap);
+    audio_pwm_dma_start(&player);
+    // Bounded, since a player that never restarts never goes idle.
+    uint64_t limit = sim_hw_now() + (uint64_t)CLK_HZ * 2u * FRAMES / RATE;
+    while (!audio_pwm_dma_is_idle(&player) && sim_hw_now() < limit) {
+        sim_hw_run(CLK_HZ / 1000u);
+    }
+    bool stopped = audio_pwm_dma_is_idle(&player);
+    sim_hw_set_cc_hook(NULL, NULL);
+    audio_pwm_dma_deinit(&player);
+
+    size_t tail = clip->frames - (position < clip->frames ? position : clip->frames);
+    bool found = ok && captured(&cap, 0, clip->expect + position, tail);
+    capture_free(&cap);
+    ok = ok && stopped && found && position == expected_position(clip, target);
+    if (!ok) {
+        printf("  %s: seek to %zu after the end %s (%zu levels)\n", name, target,
+               !stopped ? "never finished" : found ? "reached the wrong frame" : "played wrong levels", cap.count);
+    }
+    return ok ? 0 : 1;
+}
+
+// Damaged copies of a QOA file: how many frames parse_qoa() must keep from
+// each, 0 for a rejected file. Returns the number of failures.
+static int check_qoa_parse(const int16_t *pcm) {
+    size_t size = 0;
+    uint8_t *qoa = qoa_ref_encode(pcm, FRAMES, 2, RATE, &size);
+    size_t frame = 8u + 32u + 256u * 16u;
+    struct {
+        const char *name;
+        size_t length;
+        size_t offset;  // big-endian u16 to overwrite, 0 for none
+        uint16_t value;
+        size_t frames;
+    } cases[] = {
+        {"whole", size, 0, 0, FRAMES},
+        {"cut in frame 3", size - 40, 0, 0, 2 * QOA_FRAME_LEN},
+        {"cut in frame 1", frame - 8, 0, 0, 0},
+        {"bad magic", size, 2, 0x6167, 0},
+        {"3 channels", size, 8, 0x0300, 0},
+        {"zero length", size, 6, 0, 0},
+        {"rate change", size, 8 + frame + 2, 0x5623, QOA_FRAME_LEN},
+        {"short frame 1", size, 8 + 4, 0x1300, 0},
+    };
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        uint8_t *copy = malloc(size);
+        memcpy(copy, qoa, size);
+        if (cases[i].offset) {
+            copy[cases[i].offset] = (uint8_t)(cases[i].value >> 8);
+            copy[cases[i].offset + 1] = (uint8_t)cases[i].value;
+        }
+        wav_info_t wav;
+        bool ok = parse_qoa(copy, cases[i].length, &wav);
+        size_t frames = ok ? wav_frame_count(&wav) : 0;
+        if (frames != cases[i].frames) {
+            printf("  qoa %s: %zu frames, expected %zu\n", cases[i].name, frames, cases[i].frames);
+            ++failures;
+        }
+        free(copy);
+    }
+    free(qoa);
+    return failures;
+}
+
+int main(void) {
+    static int16_t pcm[FRAMES * 2];
+    uint32_t x = 0x2545f491u;
+    for (size_t i = 0; i < FRAMES; ++i) {
+        for (size_t c = 0; c < 2; ++c) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            double t = (double)i / RATE;
+            double v = 9000.0 * sin(2.0 * M_PI * (220.0 + 110.0 * c) * t) + 4000.0 * sin(2.0 * M_PI * 1730.0 * t) +
+                       (double)(int16_t)x / 32.0;
+            pcm[i * 2 + c] = (int16_t)lrint(v);
+        }
+    }
+
+    int failures = 0;
+    sim_hw_reset(CLK_HZ);
+    printf("%-14s %8s %8s %8s\n", "clip", "frames", "step", "result");
+    for (size_t s = 0; s < sizeof(specs) / sizeof(specs[0]); ++s) {
+        const clip_spec_t *spec = &specs[s];
+        // Mono clips take the left channel of the stereo source.
+        static int16_t mono[FRAMES];
+        const int16_t *source = pcm;
+        if (spec->channels == 1) {
+            for (size_t i = 0; i < FRAMES; ++i) {
+                mono[i] = pcm[i * 2];
+            }
+            source = mono;
+        }
+        clip_t clip = make_clip(spec, source);
+        int before = failures;
+        failures += check_fill(&clip, spec->name);
+        failures += check_live(&clip, spec->name, 7000, 2000);
+        failures += check_live(&clip, spec->name, 300, 6000);
+        failures += check_after_finish(&clip, spec->name, 5121);
+        printf("%-14s %8zu %8zu %8s\n", spec->name, clip.frames, clip.step, failures == before ? "ok" : "FAILED");
+        free(clip.expect);
+    }
+
+    int parse_failures = check_qoa_parse(pcm);
+    printf("%-14s %8s %8s %8s\n", "qoa damaged", "", "", parse_failures ? "FAILED" : "ok");
+    failures += parse_failures;
+
+    printf("%s\n", failures ? "CHECK FAILED" : "seek checks pass");
+    return failures ? 1 : 0;
+}
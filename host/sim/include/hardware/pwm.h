@@ -0,0 +1,46 @@
+#ifndef _HARDWARE_PWM_H
+#define _HARDWARE_PWM_H
+
+#include "pico/types.h"
+#include "hardware/structs/pwm.h"
+
+enum pwm_chan {
+    PWM_CHAN_A = 0,
+    PWM_CHAN_B = 1,
+};
+
+typedef struct {
+    uint32_t csr;
+    uint32_t div;
+    uint32_t top;
+} pwm_config;
+
+#define PWM_CH0_CSR_EN_BITS 0x00000001u
+#define PWM_CH0_CSR_PH_CORRECT_BITS 0x00000002u
+#define PWM_CH0_CSR_A_INV_BITS 0x00000004u
+#define PWM_CH0_CSR_B_INV_BITS 0x00000008u
+#define PWM_CH0_DIV_INT_LSB 4u
+#define PWM_CH0_DIV_FRAC_BITS 0x0000000fu
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1u) & 7u;
+}
+
+static inline uint pwm_gpio_to_channel(uint gpio) {
+    return gpio & 1u;
+}
+
+pwm_config pwm_get_default_config(void);
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap);
+void pwm_config_set_clkdiv(pwm_config *c, float div);
+void pwm_config_set_clkdiv_int_frac(pwm_config *c, uint8_t integer, uint8_t fract);
+void pwm_config_set_phase_correct(pwm_config *c, bool phase_correct);
+void pwm_config_set_output_polarity(pwm_config *c, bool a, bool b);
+void pwm_init(uint slice_num, pwm_config *c, bool start);
+void pwm_set_enabled(uint slice_num, bool enabled);
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level);
+void pwm_set_both_levels(uint slice_num, uint16_t level_a, uint16_t level_b);
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+void pwm_set_output_polarity(uint slice_num, bool a, bool b);
+
+#endif
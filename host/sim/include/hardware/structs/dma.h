@@ -0,0 +1,64 @@
+#ifndef _HARDWARE_STRUCTS_DMA_H
+#define _HARDWARE_STRUCTS_DMA_H
+
+#include "pico/types.h"
+
+#define NUM_DMA_CHANNELS 12
+#define NUM_DMA_TIMERS 4
+
+// Same register layout and aliases as the RP2040 DMA channel block. The
+// simulator keeps every alias in sync; write through the SDK calls (or let a
+// DMA channel write here) rather than assigning fields directly.
+typedef struct {
+    volatile uint32_t read_addr;
+    volatile uint32_t write_addr;
+    volatile uint32_t transfer_count;
+    volatile uint32_t ctrl_trig;
+    volatile uint32_t al1_ctrl;
+    volatile uint32_t al1_read_addr;
+    volatile uint32_t al1_write_addr;
+    volatile uint32_t al1_transfer_count_trig;
+    volatile uint32_t al2_ctrl;
+    volatile uint32_t al2_transfer_count;
+    volatile uint32_t al2_read_addr;
+    volatile uint32_t al2_write_addr_trig;
+    volatile uint32_t al3_ctrl;
+    volatile uint32_t al3_write_addr;
+    volatile uint32_t al3_transfer_count;
+    volatile uint32_t al3_read_addr_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+    dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+    volatile uint32_t intr;
+    volatile uint32_t inte0;
+    volatile uint32_t intf0;
+    volatile uint32_t ints0;
+    volatile uint32_t inte1;
+    volatile uint32_t intf1;
+    volatile uint32_t ints1;
+    volatile uint32_t timer[NUM_DMA_TIMERS];
+    volatile uint32_t multi_channel_trigger;
+    volatile uint32_t chan_abort;
+} dma_hw_t;
+
+#define DMA_CH0_CTRL_TRIG_EN_BITS 0x00000001u
+#define DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_BITS 0x00000002u
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB 2u
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS 0x0000000cu
+#define DMA_CH0_CTRL_TRIG_INCR_READ_BITS 0x00000010u
+#define DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS 0x00000020u
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_LSB 6u
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_BITS 0x000003c0u
+#define DMA_CH0_CTRL_TRIG_RING_SEL_BITS 0x00000400u
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB 11u
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS 0x00007800u
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB 15u
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS 0x001f8000u
+#define DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS 0x00200000u
+#define DMA_CH0_CTRL_TRIG_BUSY_BITS 0x01000000u
+
+// DMA lives in bus-addressable simulator memory so control blocks can target it.
+extern dma_hw_t *dma_hw;
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _HARDWARE_STRUCTS_PWM_H
+#define _HARDWARE_STRUCTS_PWM_H
+
+#include "pico/types.h"
+
+#define NUM_PWM_SLICES 8
+
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t div;
+    volatile uint32_t ctr;
+    volatile uint32_t cc;
+    volatile uint32_t top;
+} pwm_slice_hw_t;
+
+typedef struct {
+    pwm_slice_hw_t slice[NUM_PWM_SLICES];
+    volatile uint32_t en;
+    volatile uint32_t intr;
+    volatile uint32_t inte;
+    volatile uint32_t intf;
+    volatile uint32_t ints;
+} pwm_hw_t;
+
+// Lives in bus-addressable simulator memory so DMA can target it.
+extern pwm_hw_t *pwm_hw;
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef _HARDWARE_SYNC_H
+#define _HARDWARE_SYNC_H
+
+#include "pico/types.h"
+
+// Sleep instructions advance the simulator's virtual clock until an IRQ
+// handler or alarm callback has run. __sev() has nothing to wake on the host.
+void __wfi(void);
+void __wfe(void);
+void __sev(void);
+
+// Handlers only run inside simulator calls, so there is nothing to mask.
+static inline uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+static inline void __dmb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif
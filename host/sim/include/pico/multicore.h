@@ -0,0 +1,13 @@
+#ifndef _PICO_MULTICORE_H
+#define _PICO_MULTICORE_H
+
+// Core 1 is a host thread running alongside the simulator, which stays on
+// the thread that reset it. The simulated hardware is not thread-safe, so
+// core 1 code may only touch memory; __wfe() there just yields.
+void multicore_launch_core1(void (*entry)(void));
+
+// Waits for core 1's entry function to return; the host cannot reset a
+// thread, so code using core 1 must tell it to return first.
+void multicore_reset_core1(void);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef _PICO_PLATFORM_H
+#define _PICO_PLATFORM_H
+
+#include "pico/types.h"
+
+// ISRs are ordinary functions on the host; the simulator calls them directly.
+#define __isr
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+
+static inline void tight_loop_contents(void) {
+}
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+#include "pico/platform.h"
+#include "pico/time.h"
+#include "pico/types.h"
+#include "hardware/gpio.h"
+
+#endif
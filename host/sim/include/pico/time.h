@@ -0,0 +1,16 @@
+#ifndef _PICO_TIME_H
+#define _PICO_TIME_H
+
+#include "pico/types.h"
+
+typedef int32_t alarm_id_t;
+
+// Return 0 to stop, >0 to fire again that many us after the callback returns.
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+// The simulated timer runs off the virtual clock at 1 MHz.
+uint64_t time_us_64(void);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef _PICO_TYPES_H
+#define _PICO_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Host stand-in for the Pico SDK base types used by the player sources.
+typedef unsigned int uint;
+
+#endif
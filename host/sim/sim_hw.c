@@ -0,0 +1,911 @@
+#define _GNU_SOURCE
+#include "sim_hw.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "pico/multicore.h"
+#include "pico/time.h"
+
+// Register blocks are plain statics; the host binary is linked without PIE so
+// their addresses fit in the 32-bit DMA address registers.
+static pwm_hw_t pwm_regs;
+static dma_hw_t dma_regs;
+pwm_hw_t *pwm_hw = &pwm_regs;
+dma_hw_t *dma_hw = &dma_regs;
+
+typedef struct {
+    uint32_t read_addr;
+    uint32_t write_addr;
+    uint32_t count;
+    uint32_t reload;
+    uint32_t ctrl;
+    uint32_t credit;
+    bool busy;
+    bool claimed;
+} sim_dma_channel_t;
+
+typedef struct {
+    bool running;
+    uint64_t origin;
+    uint64_t wraps;
+} sim_pwm_pace_t;
+
+// DMA pacing timer: pulse n lands at origin + ceil(n * den / num) cycles.
+typedef struct {
+    bool claimed;
+    uint32_t num;
+    uint32_t den;
+    uint64_t origin;
+    uint64_t pulses;
+} sim_dma_timer_t;
+
+#define SIM_MAX_ALARMS 16
+
+typedef struct {
+    alarm_callback_t callback;
+    void *user_data;
+    uint64_t target_us;
+} sim_alarm_t;
+
+static struct {
+    uint32_t clk_hz;
+    uint64_t now;
+    sim_hw_cc_hook_t cc_hook;
+    void *cc_ctx;
+    enum gpio_function gpio_fn[NUM_BANK0_GPIOS];
+    sim_pwm_pace_t pace[NUM_PWM_SLICES];
+    sim_dma_channel_t ch[NUM_DMA_CHANNELS];
+    sim_dma_timer_t timer[NUM_DMA_TIMERS];
+    sim_alarm_t alarm[SIM_MAX_ALARMS];
+    irq_handler_t irq_handler[NUM_IRQS];
+    bool irq_enabled[NUM_IRQS];
+    bool in_irq;
+    uint64_t wakeups;
+    uint64_t irq_latency;
+    uint64_t alarm_latency;
+    bool irq_waiting;
+    uint64_t irq_due;
+} sim;
+
+static void dma_service(void);
+
+static void sim_fatal(const char *msg) {
+    fprintf(stderr, "sim_hw: %s\n", msg);
+    abort();
+}
+
+static uint32_t bus_addr(const volatile void *ptr) {
+    uintptr_t addr = (uintptr_t)ptr;
+    if (addr >> 32) {
+        sim_fatal("pointer is not bus-addressable (use sim_hw_alloc or a static)");
+    }
+    return (uint32_t)addr;
+}
+
+static bool in_block(uint32_t addr, const volatile void *base, size_t size, uint32_t *offset) {
+    uint32_t start = bus_addr(base);
+    if (addr < start || addr - start >= size) {
+        return false;
+    }
+    *offset = addr - start;
+    return true;
+}
+
+// The thread that owns the simulator (core 0), and core 1's thread.
+static pthread_t sim_thread;
+static pthread_t core1_thread;
+static bool core1_running;
+
+void sim_hw_reset(uint32_t clk_sys_hz) {
+    sim_thread = pthread_self();
+    memset(&pwm_regs, 0, sizeof(pwm_regs));
+    memset(&dma_regs, 0, sizeof(dma_regs));
+    memset(&sim, 0, sizeof(sim));
+    sim.clk_hz = clk_sys_hz;
+    for (uint i = 0; i < NUM_BANK0_GPIOS; ++i) {
+        sim.gpio_fn[i] = GPIO_FUNC_NULL;
+    }
+}
+
+void *sim_hw_alloc(size_t size) {
+    void *mem = mmap(NULL, size ? size : 1, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (mem == MAP_FAILED) {
+        sim_fatal("bus memory allocation failed");
+    }
+    return mem;
+}
+
+uint64_t sim_hw_now(void) {
+    return sim.now;
+}
+
+void sim_hw_set_alarm_latency(uint64_t cycles) {
+    sim.alarm_latency = cycles;
+}
+
+void sim_hw_set_irq_latency(uint64_t cycles) {
+    sim.irq_latency = cycles;
+    sim.irq_waiting = false;
+}
+
+void sim_hw_set_cc_hook(sim_hw_cc_hook_t hook, void *ctx) {
+    sim.cc_hook = hook;
+    sim.cc_ctx = ctx;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    (void)clk_index;
+    return sim.clk_hz;
+}
+
+// ---------------------------------------------------------------------------
+// GPIO / IRQ
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    if (gpio >= NUM_BANK0_GPIOS) {
+        sim_fatal("gpio out of range");
+    }
+    sim.gpio_fn[gpio] = fn;
+}
+
+enum gpio_function gpio_get_function(uint gpio) {
+    return gpio < NUM_BANK0_GPIOS ? sim.gpio_fn[gpio] : GPIO_FUNC_NULL;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    if (sim.irq_handler[num] && sim.irq_handler[num] != handler) {
+        sim_fatal("exclusive IRQ handler already set");
+    }
+    sim.irq_handler[num] = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    sim.irq_enabled[num] = enabled;
+}
+
+bool irq_is_enabled(uint num) {
+    return sim.irq_enabled[num];
+}
+
+void irq_set_priority(uint num, uint8_t hardware_priority) {
+    (void)num;
+    (void)hardware_priority;
+}
+
+// Runs the DMA IRQ handlers until nothing is pending. ISRs take zero virtual
+// time; nested dispatch from inside a handler is deferred to the outer loop.
+static bool irq_pending(void) {
+    return (sim.irq_enabled[DMA_IRQ_0] && sim.irq_handler[DMA_IRQ_0] && dma_hw->ints0) ||
+           (sim.irq_enabled[DMA_IRQ_1] && sim.irq_handler[DMA_IRQ_1] && dma_hw->ints1);
+}
+
+static void irq_dispatch(void) {
+    if (sim.in_irq) {
+        return;
+    }
+    // With a latency set, a pending IRQ is held off that many cycles, as if
+    // masked by another handler; anything raised meanwhile shares the entry.
+    if (sim.irq_latency) {
+        if (!irq_pending()) {
+            sim.irq_waiting = false;
+            return;
+        }
+        if (!sim.irq_waiting) {
+            sim.irq_waiting = true;
+            sim.irq_due = sim.now + sim.irq_latency;
+        }
+        if (sim.now < sim.irq_due) {
+            return;
+        }
+        sim.irq_waiting = false;
+    }
+    sim.in_irq = true;
+    for (int guard = 0;; ++guard) {
+        bool ran = false;
+        if (sim.irq_enabled[DMA_IRQ_0] && sim.irq_handler[DMA_IRQ_0] && dma_hw->ints0) {
+            sim.irq_handler[DMA_IRQ_0]();
+            sim.wakeups++;
+            ran = true;
+        }
+        if (sim.irq_enabled[DMA_IRQ_1] && sim.irq_handler[DMA_IRQ_1] && dma_hw->ints1) {
+            sim.irq_handler[DMA_IRQ_1]();
+            sim.wakeups++;
+            ran = true;
+        }
+        if (!ran) {
+            break;
+        }
+        if (guard > 1000) {
+            sim_fatal("DMA IRQ never acknowledged");
+        }
+    }
+    sim.in_irq = false;
+}
+
+// ---------------------------------------------------------------------------
+// PWM
+
+static void pwm_write_cc(uint slice, uint32_t value) {
+    pwm_hw->slice[slice].cc = value;
+    if (sim.cc_hook) {
+        sim.cc_hook(sim.cc_ctx, slice, value, sim.now);
+    }
+}
+
+// Period of one counter wrap in 1/16 clk_sys cycles.
+static uint64_t pwm_period_x16(uint slice) {
+    const pwm_slice_hw_t *s = &pwm_hw->slice[slice];
+    uint64_t div = s->div & 0xfffu;
+    if ((div >> PWM_CH0_DIV_INT_LSB) == 0) {
+        div += 256u << PWM_CH0_DIV_INT_LSB;
+    }
+    uint64_t period = ((uint64_t)(s->top & 0xffffu) + 1u) * div;
+    if (s->csr & PWM_CH0_CSR_PH_CORRECT_BITS) {
+        period *= 2u;
+    }
+    return period;
+}
+
+static uint64_t pwm_next_wrap(uint slice) {
+    const sim_pwm_pace_t *p = &sim.pace[slice];
+    return p->origin + ((p->wraps + 1u) * pwm_period_x16(slice) + 15u) / 16u;
+}
+
+pwm_config pwm_get_default_config(void) {
+    pwm_config c = {0};
+    pwm_config_set_clkdiv_int_frac(&c, 1, 0);
+    pwm_config_set_wrap(&c, 0xffff);
+    return c;
+}
+
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) {
+    c->top = wrap;
+}
+
+void pwm_config_set_clkdiv(pwm_config *c, float div) {
+    c->div = (uint32_t)(div * (float)(1u << PWM_CH0_DIV_INT_LSB));
+}
+
+void pwm_config_set_clkdiv_int_frac(pwm_config *c, uint8_t integer, uint8_t fract) {
+    c->div = ((uint32_t)integer << PWM_CH0_DIV_INT_LSB) | (fract & PWM_CH0_DIV_FRAC_BITS);
+}
+
+void pwm_config_set_phase_correct(pwm_config *c, bool phase_correct) {
+    c->csr = (c->csr & ~PWM_CH0_CSR_PH_CORRECT_BITS) | (phase_correct ? PWM_CH0_CSR_PH_CORRECT_BITS : 0u);
+}
+
+void pwm_config_set_output_polarity(pwm_config *c, bool a, bool b) {
+    c->csr = (c->csr & ~(PWM_CH0_CSR_A_INV_BITS | PWM_CH0_CSR_B_INV_BITS)) |
+             (a ? PWM_CH0_CSR_A_INV_BITS : 0u) | (b ? PWM_CH0_CSR_B_INV_BITS : 0u);
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled) {
+    pwm_slice_hw_t *s = &pwm_hw->slice[slice_num];
+    if (enabled && !sim.pace[slice_num].running) {
+        sim.pace[slice_num] = (sim_pwm_pace_t){.running = true, .origin = sim.now};
+    }
+    if (!enabled) {
+        sim.pace[slice_num].running = false;
+    }
+    s->csr = (s->csr & ~PWM_CH0_CSR_EN_BITS) | (enabled ? PWM_CH0_CSR_EN_BITS : 0u);
+    pwm_hw->en = (pwm_hw->en & ~(1u << slice_num)) | ((enabled ? 1u : 0u) << slice_num);
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start) {
+    pwm_set_enabled(slice_num, false);
+    pwm_slice_hw_t *s = &pwm_hw->slice[slice_num];
+    s->csr = c->csr & ~PWM_CH0_CSR_EN_BITS;
+    s->div = c->div;
+    s->top = c->top;
+    s->ctr = 0;
+    pwm_write_cc(slice_num, 0);
+    pwm_set_enabled(slice_num, start);
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level) {
+    uint32_t cc = pwm_hw->slice[slice_num].cc;
+    uint shift = chan ? 16u : 0u;
+    cc = (cc & ~(0xffffu << shift)) | ((uint32_t)level << shift);
+    pwm_write_cc(slice_num, cc);
+}
+
+void pwm_set_both_levels(uint slice_num, uint16_t level_a, uint16_t level_b) {
+    pwm_write_cc(slice_num, ((uint32_t)level_b << 16) | level_a);
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+    pwm_set_chan_level(pwm_gpio_to_slice_num(gpio), pwm_gpio_to_channel(gpio), level);
+}
+
+void pwm_set_output_polarity(uint slice_num, bool a, bool b) {
+    pwm_config c = {.csr = pwm_hw->slice[slice_num].csr};
+    pwm_config_set_output_polarity(&c, a, b);
+    pwm_hw->slice[slice_num].csr = c.csr;
+}
+
+// ---------------------------------------------------------------------------
+// DMA
+
+static uint dma_treq(const sim_dma_channel_t *c) {
+    return (c->ctrl & DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS) >> DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB;
+}
+
+static void dma_sync(uint ch) {
+    const sim_dma_channel_t *c = &sim.ch[ch];
+    dma_channel_hw_t *hw = &dma_hw->ch[ch];
+    uint32_t ctrl = c->ctrl | (c->busy ? DMA_CH0_CTRL_TRIG_BUSY_BITS : 0u);
+    hw->read_addr = hw->al1_read_addr = hw->al2_read_addr = hw->al3_read_addr_trig = c->read_addr;
+    hw->write_addr = hw->al1_write_addr = hw->al2_write_addr_trig = hw->al3_write_addr = c->write_addr;
+    hw->transfer_count = hw->al1_transfer_count_trig = hw->al2_transfer_count = hw->al3_transfer_count =
+        c->count;
+    hw->ctrl_trig = hw->al1_ctrl = hw->al2_ctrl = hw->al3_ctrl = ctrl;
+    dma_hw->ints0 = (dma_hw->intr | dma_hw->intf0) & dma_hw->inte0;
+    dma_hw->ints1 = (dma_hw->intr | dma_hw->intf1) & dma_hw->inte1;
+}
+
+static void dma_trigger(uint ch) {
+    sim_dma_channel_t *c = &sim.ch[ch];
+    if (!(c->ctrl & DMA_CH0_CTRL_TRIG_EN_BITS) || c->busy) {
+        return;
+    }
+    c->busy = true;
+    c->count = c->reload;
+    c->credit = 0;
+    dma_sync(ch);
+}
+
+// Writing zero to a trigger alias is a null trigger: it starts nothing but
+// raises the IRQ of a quiet channel (end of a control block list).
+static void dma_trigger_value(uint ch, uint32_t value) {
+    if (value) {
+        dma_trigger(ch);
+    } else if (sim.ch[ch].ctrl & DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS) {
+        dma_hw->intr |= 1u << ch;
+        dma_sync(ch);
+    }
+}
+
+static void dma_complete(uint ch) {
+    sim_dma_channel_t *c = &sim.ch[ch];
+    c->busy = false;
+    if (!(c->ctrl & DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS)) {
+        dma_hw->intr |= 1u << ch;
+    }
+    dma_sync(ch);
+    uint chain = (c->ctrl & DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS) >> DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB;
+    if (chain != ch) {
+        dma_trigger(chain);
+    }
+}
+
+// Register write into the DMA block, honouring the four alias layouts.
+static void dma_reg_write(uint32_t offset, uint32_t value) {
+    if (offset >= sizeof(dma_hw->ch)) {
+        if (offset == offsetof(dma_hw_t, multi_channel_trigger)) {
+            dma_start_channel_mask(value);
+        } else if (offset == offsetof(dma_hw_t, intr)) {
+            dma_hw->intr &= ~value;
+        } else {
+            *(volatile uint32_t *)((uint8_t *)dma_hw + offset) = value;
+        }
+        for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+            dma_sync(ch);
+        }
+        return;
+    }
+
+    uint ch = offset / sizeof(dma_channel_hw_t);
+    uint reg = (offset % sizeof(dma_channel_hw_t)) / 4u;
+    sim_dma_channel_t *c = &sim.ch[ch];
+    switch (reg) {
+    case 0: case 5: case 10: case 15:
+        c->read_addr = value;
+        break;
+    case 1: case 6: case 11: case 13:
+        c->write_addr = value;
+        break;
+    case 2: case 7: case 9: case 14:
+        c->reload = value;
+        break;
+    default:
+        c->ctrl = value & ~DMA_CH0_CTRL_TRIG_BUSY_BITS;
+        break;
+    }
+    dma_sync(ch);
+    if (reg == 3 || reg == 7 || reg == 11 || reg == 15) {
+        dma_trigger_value(ch, value);
+    }
+}
+
+static uint32_t mem_read(uint32_t addr, uint size) {
+    uint32_t value = 0;
+    memcpy(&value, (const void *)(uintptr_t)addr, size);
+    return value;
+}
+
+// Narrow writes to APB/AHB register blocks are replicated across all byte
+// lanes, exactly as on the RP2040 bus fabric.
+static void mem_write(uint32_t addr, uint32_t value, uint size) {
+    uint32_t offset;
+    bool is_pwm = in_block(addr, pwm_hw, sizeof(*pwm_hw), &offset);
+    bool is_dma = !is_pwm && in_block(addr, dma_hw, sizeof(*dma_hw), &offset);
+    if (!is_pwm && !is_dma) {
+        memcpy((void *)(uintptr_t)addr, &value, size);
+        return;
+    }
+
+    if (size == 1) {
+        value = (value & 0xffu) * 0x01010101u;
+    } else if (size == 2) {
+        value = (value & 0xffffu) * 0x00010001u;
+    }
+    offset &= ~3u;
+    if (is_dma) {
+        dma_reg_write(offset, value);
+        return;
+    }
+
+    uint slice = offset / sizeof(pwm_slice_hw_t);
+    uint reg = offset % sizeof(pwm_slice_hw_t);
+    if (slice < NUM_PWM_SLICES && reg == offsetof(pwm_slice_hw_t, cc)) {
+        pwm_write_cc(slice, value);
+    } else {
+        *(volatile uint32_t *)((uint8_t *)pwm_hw + offset) = value;
+    }
+}
+
+static uint32_t dma_advance(uint32_t addr, uint size, uint ring_bits) {
+    if (!ring_bits) {
+        return addr + size;
+    }
+    uint32_t mask = (1u << ring_bits) - 1u;
+    return (addr & ~mask) | ((addr + size) & mask);
+}
+
+static void dma_transfer_one(uint ch) {
+    sim_dma_channel_t *c = &sim.ch[ch];
+    uint size = 1u << ((c->ctrl & DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS) >> DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB);
+    uint ring = (c->ctrl & DMA_CH0_CTRL_TRIG_RING_SIZE_BITS) >> DMA_CH0_CTRL_TRIG_RING_SIZE_LSB;
+    bool ring_write = (c->ctrl & DMA_CH0_CTRL_TRIG_RING_SEL_BITS) != 0;
+
+    // Latch addresses first: the write may land in this channel's own registers.
+    uint32_t read_addr = c->read_addr;
+    uint32_t write_addr = c->write_addr;
+    if (c->ctrl & DMA_CH0_CTRL_TRIG_INCR_READ_BITS) {
+        c->read_addr = dma_advance(read_addr, size, ring_write ? 0 : ring);
+    }
+    if (c->ctrl & DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS) {
+        c->write_addr = dma_advance(write_addr, size, ring_write ? ring : 0);
+    }
+    c->count--;
+    dma_sync(ch);
+
+    mem_write(write_addr, mem_read(read_addr, size), size);
+    if (c->busy && c->count == 0) {
+        dma_complete(ch);
+    }
+}
+
+// Runs every channel that has a DREQ credit (or is unpaced) until the DMA is
+// idle, then delivers any completion IRQs. High-priority channels go first,
+// as they win arbitration on the hardware.
+static void dma_service(void) {
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (uint i = 0; i < 2u * NUM_DMA_CHANNELS; ++i) {
+            uint ch = i % NUM_DMA_CHANNELS;
+            sim_dma_channel_t *c = &sim.ch[ch];
+            bool high = c->ctrl & DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_BITS;
+            if (high != (i < NUM_DMA_CHANNELS)) {
+                continue;
+            }
+            // A busy channel with EN cleared is paused, not finished.
+            while (c->busy && (c->ctrl & DMA_CH0_CTRL_TRIG_EN_BITS) && (dma_treq(c) == DREQ_FORCE || c->credit)) {
+                if (dma_treq(c) != DREQ_FORCE) {
+                    c->credit--;
+                }
+                dma_transfer_one(ch);
+                progress = true;
+            }
+        }
+    }
+    irq_dispatch();
+}
+
+static bool dreq_wanted(uint dreq) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+        if (sim.ch[ch].busy && dma_treq(&sim.ch[ch]) == dreq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void dreq_pulse(uint dreq) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+        if (sim.ch[ch].busy && dma_treq(&sim.ch[ch]) == dreq) {
+            sim.ch[ch].credit++;
+        }
+    }
+}
+
+int dma_claim_unused_channel(bool required) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+        if (!sim.ch[ch].claimed) {
+            sim.ch[ch].claimed = true;
+            return (int)ch;
+        }
+    }
+    if (required) {
+        sim_fatal("no DMA channels available");
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    sim.ch[channel].claimed = false;
+}
+
+bool dma_channel_is_claimed(uint channel) {
+    return sim.ch[channel].claimed;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c = {0};
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, DREQ_FORCE);
+    channel_config_set_chain_to(&c, channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_ring(&c, false, 0);
+    channel_config_set_irq_quiet(&c, false);
+    channel_config_set_enable(&c, true);
+    return c;
+}
+
+dma_channel_config dma_get_channel_config(uint channel) {
+    return (dma_channel_config){.ctrl = sim.ch[channel].ctrl};
+}
+
+static void config_set_bits(dma_channel_config *c, uint32_t mask, uint32_t value) {
+    c->ctrl = (c->ctrl & ~mask) | (value & mask);
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    config_set_bits(c, DMA_CH0_CTRL_TRIG_INCR_READ_BITS, incr ? ~0u : 0u);
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    config_set_bits(c, DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS, incr ? ~0u : 0u);
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    config_set_bits(c, DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS, dreq << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB);
+}
+
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) {
+    config_set_bits(c, DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS, chain_to << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    config_set_bits(c, DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS, (uint32_t)size << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB);
+}
+
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    config_set_bits(c, DMA_CH0_CTRL_TRIG_RING_SIZE_BITS | DMA_CH0_CTRL_TRIG_RING_SEL_BITS,
+                    (size_bits << DMA_CH0_CTRL_TRIG_RING_SIZE_LSB) | (write ? DMA_CH0_CTRL_TRIG_RING_SEL_BITS : 0u));
+}
+
+void channel_config_set_irq_quiet(dma_channel_config *c, bool irq_quiet) {
+    config_set_bits(c, DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS, irq_quiet ? ~0u : 0u);
+}
+
+void channel_config_set_high_priority(dma_channel_config *c, bool high_priority) {
+    config_set_bits(c, DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_BITS, high_priority ? ~0u : 0u);
+}
+
+void channel_config_set_enable(dma_channel_config *c, bool enable) {
+    config_set_bits(c, DMA_CH0_CTRL_TRIG_EN_BITS, enable ? ~0u : 0u);
+}
+
+static void dma_cpu_write(uint channel, size_t reg_offset, uint32_t value) {
+    dma_reg_write((uint32_t)(channel * sizeof(dma_channel_hw_t) + reg_offset), value);
+    dma_service();
+}
+
+void dma_channel_set_config(uint channel, const dma_channel_config *config, bool trigger) {
+    dma_cpu_write(channel, trigger ? offsetof(dma_channel_hw_t, ctrl_trig) : offsetof(dma_channel_hw_t, al1_ctrl),
+                  config->ctrl);
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    dma_cpu_write(channel,
+                  trigger ? offsetof(dma_channel_hw_t, al3_read_addr_trig) : offsetof(dma_channel_hw_t, read_addr),
+                  bus_addr(read_addr));
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger) {
+    dma_cpu_write(channel,
+                  trigger ? offsetof(dma_channel_hw_t, al2_write_addr_trig) : offsetof(dma_channel_hw_t, write_addr),
+                  bus_addr(write_addr));
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {
+    dma_cpu_write(channel,
+                  trigger ? offsetof(dma_channel_hw_t, al1_transfer_count_trig)
+                          : offsetof(dma_channel_hw_t, transfer_count),
+                  trans_count);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    dma_channel_set_read_addr(channel, read_addr, false);
+    dma_channel_set_write_addr(channel, write_addr, false);
+    dma_channel_set_trans_count(channel, transfer_count, false);
+    dma_channel_set_config(channel, config, trigger);
+}
+
+void dma_start_channel_mask(uint32_t chan_mask) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+        if (chan_mask & (1u << ch)) {
+            dma_trigger(ch);
+        }
+    }
+    dma_service();
+}
+
+void dma_channel_start(uint channel) {
+    dma_start_channel_mask(1u << channel);
+}
+
+void dma_channel_abort(uint channel) {
+    sim.ch[channel].busy = false;
+    sim.ch[channel].credit = 0;
+    dma_sync(channel);
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return sim.ch[channel].busy;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    if (enabled) {
+        dma_hw->inte0 |= 1u << channel;
+    } else {
+        dma_hw->inte0 &= ~(1u << channel);
+    }
+    dma_sync(channel);
+}
+
+bool dma_channel_get_irq0_status(uint channel) {
+    return (dma_hw->ints0 >> channel) & 1u;
+}
+
+void dma_channel_acknowledge_irq0(uint channel) {
+    dma_hw->intr &= ~(1u << channel);
+    dma_sync(channel);
+}
+
+int dma_claim_unused_timer(bool required) {
+    for (uint t = 0; t < NUM_DMA_TIMERS; ++t) {
+        if (!sim.timer[t].claimed) {
+            sim.timer[t].claimed = true;
+            return (int)t;
+        }
+    }
+    if (required) {
+        sim_fatal("no DMA timers available");
+    }
+    return -1;
+}
+
+void dma_timer_unclaim(uint timer) {
+    sim.timer[timer].claimed = false;
+}
+
+void dma_timer_set_fraction(uint timer, uint16_t numerator, uint16_t denominator) {
+    dma_hw->timer[timer] = ((uint32_t)numerator << 16) | denominator;
+    sim.timer[timer].num = numerator;
+    sim.timer[timer].den = denominator;
+    sim.timer[timer].origin = sim.now;
+    sim.timer[timer].pulses = 0;
+}
+
+static uint64_t timer_next_pulse(uint t) {
+    const sim_dma_timer_t *tm = &sim.timer[t];
+    return tm->origin + ((tm->pulses + 1u) * tm->den + tm->num - 1u) / tm->num;
+}
+
+// ---------------------------------------------------------------------------
+// Timer
+
+uint64_t time_us_64(void) {
+    return (sim.now * 1000000u) / sim.clk_hz;
+}
+
+static uint64_t us_to_cycles(uint64_t us) {
+    return (us * sim.clk_hz + 999999u) / 1000000u;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    (void)fire_if_past;
+    for (int i = 0; i < SIM_MAX_ALARMS; ++i) {
+        if (!sim.alarm[i].callback) {
+            sim.alarm[i] = (sim_alarm_t){callback, user_data, time_us_64() + us};
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    if (alarm_id <= 0 || alarm_id > SIM_MAX_ALARMS || !sim.alarm[alarm_id - 1].callback) {
+        return false;
+    }
+    sim.alarm[alarm_id - 1].callback = NULL;
+    return true;
+}
+
+static void fire_alarms(void) {
+    for (int i = 0; i < SIM_MAX_ALARMS; ++i) {
+        sim_alarm_t *a = &sim.alarm[i];
+        if (!a->callback || us_to_cycles(a->target_us) + sim.alarm_latency > sim.now) {
+            continue;
+        }
+        alarm_callback_t callback = a->callback;
+        a->callback = NULL;
+        sim.wakeups++;
+        int64_t again = callback(i + 1, a->user_data);
+        if (again > 0 && !a->callback) {
+            *a = (sim_alarm_t){callback, a->user_data, time_us_64() + (uint64_t)again};
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Virtual clock
+
+static uint64_t next_event(void) {
+    uint64_t next = UINT64_MAX;
+    if (sim.irq_waiting) {
+        next = sim.irq_due;
+    }
+    for (int i = 0; i < SIM_MAX_ALARMS; ++i) {
+        if (sim.alarm[i].callback) {
+            uint64_t t = us_to_cycles(sim.alarm[i].target_us) + sim.alarm_latency;
+            if (t < next) {
+                next = t;
+            }
+        }
+    }
+    for (uint t = 0; t < NUM_DMA_TIMERS; ++t) {
+        if (sim.timer[t].num && dreq_wanted(DREQ_DMA_TIMER0 + t)) {
+            uint64_t next_t = timer_next_pulse(t);
+            if (next_t < next) {
+                next = next_t;
+            }
+        }
+    }
+    for (uint slice = 0; slice < NUM_PWM_SLICES; ++slice) {
+        if (sim.pace[slice].running && dreq_wanted(DREQ_PWM_WRAP0 + slice)) {
+            uint64_t t = pwm_next_wrap(slice);
+            if (t < next) {
+                next = t;
+            }
+        }
+    }
+    return next;
+}
+
+// Wraps of slices nobody is listening to are skipped in bulk so an idle
+// slice does not stall the clock.
+static void fire_events(uint64_t now) {
+    for (uint t = 0; t < NUM_DMA_TIMERS; ++t) {
+        sim_dma_timer_t *tm = &sim.timer[t];
+        if (!tm->num) {
+            continue;
+        }
+        uint64_t pulses = ((now - tm->origin) * tm->num) / tm->den;
+        bool pulse = pulses > tm->pulses;
+        tm->pulses = pulses;
+        if (pulse) {
+            dreq_pulse(DREQ_DMA_TIMER0 + t);
+        }
+    }
+    for (uint slice = 0; slice < NUM_PWM_SLICES; ++slice) {
+        sim_pwm_pace_t *p = &sim.pace[slice];
+        if (!p->running) {
+            continue;
+        }
+        uint64_t period = pwm_period_x16(slice);
+        uint64_t wraps = ((now - p->origin) * 16u) / period;
+        bool pulse = wraps > p->wraps;
+        p->wraps = wraps;
+        if (pulse) {
+            dreq_pulse(DREQ_PWM_WRAP0 + slice);
+        }
+    }
+}
+
+static void advance_to(uint64_t t) {
+    sim.now = t;
+    fire_events(t);
+    dma_service();
+    fire_alarms();
+    dma_service();
+}
+
+void sim_hw_run(uint64_t cycles) {
+    uint64_t end = sim.now + cycles;
+    dma_service();
+    for (;;) {
+        uint64_t t = next_event();
+        if (t > end) {
+            sim.now = end;
+            fire_events(end);
+            break;
+        }
+        advance_to(t);
+    }
+}
+
+// The core sleeps until an IRQ handler or alarm callback has run. With
+// nothing left that could wake it, returning keeps host loops from hanging.
+void sim_hw_wait_for_interrupt(void) {
+    uint64_t wakeups = sim.wakeups;
+    dma_service();
+    while (sim.wakeups == wakeups) {
+        uint64_t t = next_event();
+        if (t == UINT64_MAX) {
+            return;
+        }
+        advance_to(t);
+    }
+}
+
+void __wfi(void) {
+    sim_hw_wait_for_interrupt();
+}
+
+void __wfe(void) {
+    if (!pthread_equal(pthread_self(), sim_thread)) {
+        sched_yield();
+        return;
+    }
+    sim_hw_wait_for_interrupt();
+}
+
+static void *core1_main(void *entry) {
+    ((void (*)(void))entry)();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    if (core1_running) {
+        fprintf(stderr, "sim: core 1 is already running\n");
+        abort();
+    }
+    core1_running = pthread_create(&core1_thread, NULL, core1_main, (void *)entry) == 0;
+}
+
+void multicore_reset_core1(void) {
+    if (core1_running) {
+        pthread_join(core1_thread, NULL);
+        core1_running = false;
+    }
+}
+
+void __sev(void) {
+}
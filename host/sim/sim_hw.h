@@ -0,0 +1,40 @@
+#ifndef SIM_HW_H
+#define SIM_HW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pico/types.h"
+
+// Called for every write (CPU or DMA) that lands in a PWM slice's CC register.
+typedef void (*sim_hw_cc_hook_t)(void *ctx, uint slice, uint32_t cc, uint64_t cycle);
+
+// Resets all simulated peripherals and restarts the virtual clock at zero.
+void sim_hw_reset(uint32_t clk_sys_hz);
+
+// Allocates zeroed memory that the simulated DMA can address with 32-bit
+// bus addresses. Statics in the (non-PIE) host binary are addressable too.
+void *sim_hw_alloc(size_t size);
+
+// Current virtual time in clk_sys cycles.
+uint64_t sim_hw_now(void);
+
+// Advances the virtual clock, servicing DREQs, DMA transfers and IRQs.
+void sim_hw_run(uint64_t cycles);
+
+// Advances the virtual clock until an IRQ handler or alarm callback has run,
+// or returns at once if nothing is pending that could ever wake the core.
+// This is what __wfi() and __wfe() do on the host.
+void sim_hw_wait_for_interrupt(void);
+
+// Delays every DMA IRQ by this many cycles after it becomes pending, to
+// model interrupt interference. Zero (the default) dispatches at once.
+void sim_hw_set_irq_latency(uint64_t cycles);
+
+// Runs every alarm callback this many cycles after its target time, as if
+// the timer IRQ were held off. Zero (the default) runs them on time.
+void sim_hw_set_alarm_latency(uint64_t cycles);
+
+void sim_hw_set_cc_hook(sim_hw_cc_hook_t hook, void *ctx);
+
+#endif
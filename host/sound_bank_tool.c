@@ -0,0 +1,268 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "incbin.h"
+#include "qoa.h"
+#include "sound_bank.h"
+#include "sound_bank_writer.h"
+#include "wav.h"
+#include "wav_convert.h"
+#include "wav_io.h"
+
+// Builds and inspects sound banks (sound_bank.h). build converts every clip
+// a manifest lists and writes NAME.bin with the bank, NAME.c, which pulls it
+// in with .incbin and defines the opened sound_bank_t NAME, and NAME.h with
+// it and an enum of clip ids; pico_sound_bank() runs it at build time.
+// Manifest lines are "name file format [RATE hz] [MONO]", with formats as
+// for wav_embed, files relative to the manifest and # starting a comment.
+// inspect lists a bank's entries.
+
+#define MAX_CLIPS 4096u
+
+typedef struct {
+    char name[64];
+    wav_info_t info;
+    uint8_t *data;
+} clip_t;
+
+static const char *const encoding_names[] = {
+    [WAV_ENCODING_PCM] = "pcm", [WAV_ENCODING_IMA_ADPCM] = "adpcm", [WAV_ENCODING_QOA] = "qoa",
+    [WAV_ENCODING_ALAW] = "alaw", [WAV_ENCODING_MULAW] = "mulaw",
+};
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: sound_bank build --name NAME manifest.txt outdir\n"
+            "       sound_bank inspect bank.bin\n");
+    exit(2);
+}
+
+static bool is_identifier(const char *name) {
+    if (!*name || isdigit((unsigned char)*name)) {
+        return false;
+    }
+    for (const char *p = name; *p; ++p) {
+        if (!isalnum((unsigned char)*p) && *p != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void put_upper(FILE *f, const char *s) {
+    for (; *s; ++s) {
+        fputc(toupper((unsigned char)*s), f);
+    }
+}
+
+// Converts one manifest line's clip; false with a message on failure.
+static bool load_clip(const char *manifest, unsigned line, char *text, const char *dir, clip_t *clip) {
+    char *name = strtok(text, " \t\r\n");
+    char *file = strtok(NULL, " \t\r\n");
+    char *format = strtok(NULL, " \t\r\n");
+    wav_convert_options_t options = {0};
+    if (!name || !file || !format || !is_identifier(name) || strlen(name) >= sizeof(clip->name) ||
+        !wav_convert_format_from_name(format, &options.format)) {
+        fprintf(stderr, "%s:%u: expected \"name file format [RATE hz] [MONO]\"\n", manifest, line);
+        return false;
+    }
+    for (char *opt = strtok(NULL, " \t\r\n"); opt; opt = strtok(NULL, " \t\r\n")) {
+        char *rate = !strcmp(opt, "RATE") ? strtok(NULL, " \t\r\n") : NULL;
+        if (rate) {
+            options.sample_rate = (uint32_t)strtoul(rate, NULL, 0);
+        } else if (!strcmp(opt, "MONO")) {
+            options.mono = true;
+        } else {
+            fprintf(stderr, "%s:%u: unknown option %s\n", manifest, line, opt);
+            return false;
+        }
+    }
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s%s", file[0] == '/' ? "" : dir, file);
+    size_t length = 0;
+    const uint8_t *bytes = wav_io_load(path, &length);
+    wav_info_t in = {0};
+    if (!bytes || (!parse_wav(bytes, length, &in) && !parse_qoa(bytes, length, &in))) {
+        fprintf(stderr, "%s:%u: %s is not a WAV or QOA file the player supports\n", manifest, line, path);
+        return false;
+    }
+    if (!(clip->data = wav_convert(&in, &options, &clip->info))) {
+        fprintf(stderr, "%s:%u: %s: conversion failed\n", manifest, line, path);
+        return false;
+    }
+    snprintf(clip->name, sizeof(clip->name), "%s", name);
+    return true;
+}
+
+static size_t read_manifest(const char *manifest, clip_t *clips) {
+    FILE *f = fopen(manifest, "r");
+    if (!f) {
+        fprintf(stderr, "%s: cannot read\n", manifest);
+        return 0;
+    }
+    // Files are relative to the manifest's directory.
+    char dir[4096];
+    snprintf(dir, sizeof(dir), "%s", manifest);
+    char *slash = strrchr(dir, '/');
+    if (slash) {
+        slash[1] = '\0';
+    } else {
+        dir[0] = '\0';
+    }
+
+    char text[1024];
+    size_t count = 0;
+    bool ok = true;
+    for (unsigned line = 1; ok && fgets(text, sizeof(text), f); ++line) {
+        char *hash = strchr(text, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        if (strspn(text, " \t\r\n") == strlen(text)) {
+            continue;
+        }
+        if (count == MAX_CLIPS) {
+            fprintf(stderr, "%s: more than %u clips\n", manifest, MAX_CLIPS);
+            ok = false;
+        } else if ((ok = load_clip(manifest, line, text, dir, &clips[count]))) {
+            for (size_t i = 0; i < count; ++i) {
+                if (!strcmp(clips[i].name, clips[count].name)) {
+                    fprintf(stderr, "%s:%u: clip %s listed twice\n", manifest, line, clips[i].name);
+                    ok = false;
+                }
+            }
+            ++count;
+        }
+    }
+    fclose(f);
+    if (ok && count == 0) {
+        fprintf(stderr, "%s: no clips\n", manifest);
+    }
+    return ok ? count : 0;
+}
+
+static int build(const char *name, const char *manifest, const char *dir) {
+    static clip_t clips[MAX_CLIPS];
+    static wav_info_t infos[MAX_CLIPS];
+    size_t count = read_manifest(manifest, clips);
+    if (count == 0) {
+        return 1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        infos[i] = clips[i].info;
+    }
+    size_t size = 0;
+    uint8_t *bank = sound_bank_write(infos, count, &size);
+    char bin_path[4096], path[4096], symbol[256];
+    snprintf(bin_path, sizeof(bin_path), "%s/%s.bin", dir, name);
+    if (!bank || !incbin_write_file(bin_path, bank, size)) {
+        return 1;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s.h", dir, name);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        return 1;
+    }
+    fprintf(f, "// Generated by sound_bank from %s; do not edit.\n#ifndef SOUND_BANK_", manifest);
+    put_upper(f, name);
+    fputs("_H\n#define SOUND_BANK_", f);
+    put_upper(f, name);
+    fputs("_H\n"
+          "\n"
+          "#include \"sound_bank.h\"\n"
+          "\n"
+          "// Clip ids for sound_bank_get().\n"
+          "enum {\n",
+          f);
+    for (size_t i = 0; i < count; ++i) {
+        fputs("    ", f);
+        put_upper(f, name);
+        fputc('_', f);
+        put_upper(f, clips[i].name);
+        fprintf(f, " = %zu,\n", i);
+    }
+    fputs("    ", f);
+    put_upper(f, name);
+    fprintf(f,
+            "_COUNT = %zu,\n"
+            "};\n"
+            "\n"
+            "// %zu clips, %zu bytes.\n"
+            "extern const sound_bank_t %s;\n"
+            "\n"
+            "#endif\n",
+            count, count, size, name);
+    bool ok = fclose(f) == 0;
+
+    snprintf(path, sizeof(path), "%s/%s.c", dir, name);
+    if (!(f = fopen(path, "w"))) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        return 1;
+    }
+    snprintf(symbol, sizeof(symbol), "%s_data", name);
+    fprintf(f, "// Generated by sound_bank from %s; do not edit.\n#include \"%s.h\"\n\n", manifest, name);
+    incbin_write(f, symbol, bin_path);
+    fprintf(f,
+            "\n"
+            "const sound_bank_t %s = {\n"
+            "    .base = %s,\n"
+            "    .size = %zu,\n"
+            "    .count = %zu,\n"
+            "    .index = %s + SOUND_BANK_HEADER_SIZE,\n"
+            "};\n",
+            name, symbol, size, count, symbol);
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", path);
+        return 1;
+    }
+    printf("%s: %zu clips, %zu bytes\n", name, count, size);
+    return 0;
+}
+
+static int inspect(const char *path) {
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(path, &length);
+    sound_bank_t bank;
+    if (!file || !sound_bank_open(&bank, file, length)) {
+        fprintf(stderr, "%s: not a sound bank\n", path);
+        return 1;
+    }
+    printf("%u clips, %zu bytes\n", (unsigned)bank.count, bank.size);
+    printf("%5s %8s %8s %6s %3s %-6s %4s %8s %8s\n", "id", "offset", "bytes", "rate", "ch", "enc", "bits",
+           "frames", "seconds");
+    bool ok = true;
+    for (uint32_t id = 0; id < bank.count; ++id) {
+        wav_info_t wav;
+        if (!sound_bank_get(&bank, id, &wav)) {
+            printf("%5u BAD ENTRY\n", (unsigned)id);
+            ok = false;
+            continue;
+        }
+        size_t frames = wav_frame_count(&wav);
+        printf("%5u %8zu %8zu %6u %3u %-6s %4u %8zu %8.3f\n", (unsigned)id, (size_t)(wav.data - bank.base),
+               wav.data_size, (unsigned)wav.sample_rate, (unsigned)wav.channels, encoding_names[wav.encoding],
+               (unsigned)wav.bits_per_sample, frames, (double)frames / wav.sample_rate);
+    }
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && !strcmp(argv[1], "inspect")) {
+        return inspect(argv[2]);
+    }
+    if (argc == 6 && !strcmp(argv[1], "build") && !strcmp(argv[2], "--name")) {
+        if (!is_identifier(argv[3])) {
+            fprintf(stderr, "%s: not a C identifier\n", argv[3]);
+            return 2;
+        }
+        return build(argv[3], argv[4], argv[5]);
+    }
+    usage();
+    return 2;
+}
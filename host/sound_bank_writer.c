@@ -0,0 +1,58 @@
+#include "sound_bank_writer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sound_bank.h"
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static size_t align4(size_t n) {
+    return (n + 3u) & ~(size_t)3u;
+}
+
+uint8_t *sound_bank_write(const wav_info_t *clips, size_t count, size_t *size_out) {
+    size_t size = align4(SOUND_BANK_HEADER_SIZE + count * SOUND_BANK_ENTRY_SIZE);
+    for (size_t i = 0; i < count; ++i) {
+        size = align4(size + clips[i].data_size);
+    }
+    if (count > UINT32_MAX || size > UINT32_MAX) {
+        return NULL;
+    }
+    uint8_t *bank = calloc(size ? size : 1u, 1);
+    if (!bank) {
+        return NULL;
+    }
+    memcpy(bank, "PWSB", 4);
+    put_u16(bank + 4, SOUND_BANK_VERSION);
+    put_u16(bank + 6, SOUND_BANK_ENTRY_SIZE);
+    put_u32(bank + 8, (uint32_t)count);
+    put_u32(bank + 12, SOUND_BANK_HEADER_SIZE);
+
+    size_t offset = align4(SOUND_BANK_HEADER_SIZE + count * SOUND_BANK_ENTRY_SIZE);
+    for (size_t i = 0; i < count; ++i) {
+        const wav_info_t *c = &clips[i];
+        uint8_t *e = bank + SOUND_BANK_HEADER_SIZE + i * SOUND_BANK_ENTRY_SIZE;
+        put_u32(e, (uint32_t)offset);
+        put_u32(e + 4, (uint32_t)c->data_size);
+        put_u32(e + 8, c->sample_rate);
+        put_u16(e + 12, c->block_align);
+        put_u16(e + 14, c->samples_per_block);
+        e[16] = (uint8_t)c->encoding;
+        e[17] = (uint8_t)c->channels;
+        e[18] = (uint8_t)c->bits_per_sample;
+        e[19] = c->is_float ? 1u : 0u;
+        memcpy(bank + offset, c->data, c->data_size);
+        offset = align4(offset + c->data_size);
+    }
+    *size_out = size;
+    return bank;
+}
@@ -0,0 +1,13 @@
+#ifndef SOUND_BANK_WRITER_H
+#define SOUND_BANK_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wav.h"
+
+// Packs described clips into a sound bank (see sound_bank.h), clip i under
+// id i. Returns a malloc'd bank and its size, or NULL.
+uint8_t *sound_bank_write(const wav_info_t *clips, size_t count, size_t *size_out);
+
+#endif
@@ -0,0 +1,273 @@
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_pwm_dma.h"
+#include "capture.h"
+#include "audio_source.h"
+#include "sim_hw.h"
+#include "wav.h"
+#include "wav_convert.h"
+#include "wav_io.h"
+
+// Checks players that pull from an audio_source_t on the simulated
+// hardware. A clip in each stored format, read by audio_source_wav(), must
+// play exactly as the clip itself does: through the native 8-bit path for
+// u8 and G.711 and through s16 otherwise, with dither, sigma-delta and on
+// core 1, and through s16 for u8 and G.711 too when read_u8 is left out.
+// A callback source that returns short reads must play as the same frames
+// from memory, and end where it returns 0. The tone generator must hold its
+// amplitude and frequency and stop after its frames. Exits non-zero on any
+// failure.
+
+#define CLK_HZ 125000000u
+#define RATE 16000u
+#define TONE_HZ 1000u
+#define TONE_FRAMES 48000u
+
+typedef struct {
+    const char *name;
+    const wav_info_t *wav;
+    audio_pwm_dma_dither_t dither;
+    uint oversample;
+    bool stereo;
+    bool pipeline;
+    bool wide;  // drop read_u8, so 8-bit clips go through s16
+} case_t;
+
+static audio_player_t player;
+static uint16_t ring_storage[4 * 256 * 8];
+
+// Plays wav, or source if not NULL, to its end with the case's settings.
+static bool render(const case_t *c, const wav_info_t *wav, const audio_source_t *source, capture_t *cap) {
+    memset(cap, 0, sizeof(*cap));
+    sim_hw_reset(CLK_HZ);
+    audio_pwm_dma_config_t config = audio_pwm_dma_get_default_config(0);
+    config.buffers = ring_storage;
+    config.buffer_count = 4;
+    config.buffer_samples = 256 * (c->oversample > 1 ? c->oversample : 1u);
+    config.dither = c->dither;
+    config.oversample = c->oversample;
+    config.stereo = c->stereo;
+    config.pipeline = c->pipeline && source;
+    config.source = source;
+    if (!audio_pwm_dma_init_with_config(&player, wav, &config)) {
+        return false;
+    }
+    cap->slice = player.slice_num;
+    cap->channel = player.pwm_channel;
+    cap->whole = player.stereo_output;
+    sim_hw_set_cc_hook(capture_cc, cap);
+    cap->armed = true;
+    audio_pwm_dma_start(&player);
+    uint64_t limit = sim_hw_now() + (uint64_t)CLK_HZ * 8u;
+    while (!audio_pwm_dma_is_idle(&player) && sim_hw_now() < limit) {
+        // Lockstep with core 1, as pipeline_check runs it.
+        while (config.pipeline && !audio_pwm_dma_is_idle(&player) && atomic_load(&player.pipe_drain) == 0 &&
+               atomic_load(&player.pipe_filled) - atomic_load(&player.pipe_done) < player.buffer_count) {
+            sched_yield();
+        }
+        sim_hw_run(CLK_HZ / 4000u);
+    }
+    cap->armed = false;
+    bool finished = audio_pwm_dma_is_idle(&player);
+    audio_pwm_dma_deinit(&player);
+    return finished;
+}
+
+// The level output ends on, held for a while that depends on where the
+// stream ended within a ring buffer and on the zero-copy path's ramp.
+static uint32_t final_level(const capture_t *cap) {
+    return cap->count ? cap->levels[cap->count - 1] : 0;
+}
+
+static bool same_audio(const capture_t *a, const capture_t *b) {
+    size_t length = capture_audible_length(a, final_level(a));
+    return length > 0 && capture_audible_length(b, final_level(b)) == length &&
+           !memcmp(a->levels, b->levels, length * sizeof(*a->levels));
+}
+
+static bool check_wav(const case_t *c) {
+    static audio_wav_reader_t reader;
+    audio_source_t source;
+    capture_t want, got;
+    bool ok = audio_source_wav(&source, &reader, c->wav);
+    bool narrow = ok && source.ops->read_u8;
+    audio_source_ops_t wide_ops;
+    if (ok && c->wide) {
+        wide_ops = (audio_source_ops_t){source.ops->read_frames, NULL};
+        source.ops = &wide_ops;
+    }
+    ok = ok && render(c, c->wav, NULL, &want) && render(c, NULL, &source, &got) && same_audio(&got, &want);
+    printf("%-24s %-6s %s\n", c->name, narrow && !c->wide ? "u8" : "s16", ok ? "exact" : "MISMATCH");
+    capture_free(&want);
+    capture_free(&got);
+    return ok;
+}
+
+// A source of its own: a clip in memory handed out a few frames per read.
+typedef struct {
+    const int16_t *frames;
+    size_t count;
+    size_t pos;
+} drip_t;
+
+static size_t drip_read_frames(void *ctx, int16_t *dst, size_t frames) {
+    drip_t *d = ctx;
+    size_t n = d->count - d->pos;
+    n = n < 7u ? n : 7u;
+    n = n < frames ? n : frames;
+    memcpy(dst, d->frames + d->pos, n * sizeof(int16_t));
+    d->pos += n;
+    return n;
+}
+
+static bool check_callback(const wav_info_t *mono) {
+    static const audio_source_ops_t drip_ops = {drip_read_frames, NULL};
+    drip_t drip = {(const int16_t *)mono->data, wav_frame_count(mono), 0};
+    audio_source_t source = {&drip_ops, &drip, mono->sample_rate, 1};
+    case_t c = {"callback, short reads", mono, AUDIO_PWM_DMA_DITHER_NONE, 1, false, false, false};
+    capture_t want, got;
+    bool ok = render(&c, mono, NULL, &want) && render(&c, NULL, &source, &got) && same_audio(&got, &want);
+    printf("%-24s %-6s %s\n", c.name, "s16", ok ? "exact" : "MISMATCH");
+    capture_free(&want);
+    capture_free(&got);
+    return ok;
+}
+
+// Reads the tone straight from its source, then plays it: it must stay
+// within two steps of a sine at the amplitude and frequency, and the player
+// must stop after the tone's frames.
+static bool check_tone(void) {
+    static int16_t samples[TONE_FRAMES];
+    audio_tone_t tone;
+    audio_source_t source;
+    bool ok = !audio_source_tone(&source, &tone, RATE, RATE / 2u, 1000, TONE_FRAMES) &&
+              audio_source_tone(&source, &tone, RATE, TONE_HZ, 20000, TONE_FRAMES);
+    size_t n = 0, got;
+    while (ok && (got = source.ops->read_frames(source.ctx, samples + n, AUDIO_SOURCE_MIN_FRAMES)) > 0) {
+        n += got;
+    }
+    int peak = 0;
+    size_t crossings = 0;
+    double err = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        peak = abs(samples[i]) > peak ? abs(samples[i]) : peak;
+        crossings += i && (samples[i - 1] < 0) != (samples[i] < 0);
+        double ideal = 20000.0 * sin(2.0 * M_PI * TONE_HZ * (double)(i + 1) / RATE);
+        err = fabs(samples[i] - ideal) > err ? fabs(samples[i] - ideal) : err;
+    }
+    size_t half_periods = 2u * TONE_FRAMES / RATE * TONE_HZ;
+    ok = ok && n == TONE_FRAMES && peak >= 19990 && peak <= 20001 && err <= 2.0 && crossings + 1 >= half_periods &&
+         crossings <= half_periods;
+
+    audio_source_tone(&source, &tone, RATE, TONE_HZ, 20000, TONE_FRAMES);
+    case_t c = {"tone", NULL, AUDIO_PWM_DMA_DITHER_NONE, 1, false, false, false};
+    capture_t cap;
+    bool played = render(&c, NULL, &source, &cap);
+    size_t length = capture_audible_length(&cap, final_level(&cap));
+    ok = ok && played && length <= TONE_FRAMES && length + 2u * RATE / TONE_HZ > TONE_FRAMES;
+    printf("tone %u Hz: %zu frames, peak %d, %zu zero crossings, worst error %.0f against a sine, %s\n", TONE_HZ, n,
+           peak, crossings, err, ok ? "ok" : "FAILED");
+    capture_free(&cap);
+    return ok;
+}
+
+// A player has one source, and a source player neither seeks nor replays.
+static bool check_refusals(const wav_info_t *wav) {
+    static audio_wav_reader_t reader;
+    static audio_mixer_t mixer;
+    audio_source_t source, empty = {NULL, NULL, RATE, 1};
+    sim_hw_reset(CLK_HZ);
+    audio_source_wav(&source, &reader, wav);
+    audio_mixer_init(&mixer, RATE, false);
+    audio_pwm_dma_config_t config = audio_pwm_dma_get_default_config(0);
+    config.source = &empty;
+    bool ok = !audio_pwm_dma_init_with_config(&player, wav, &config);
+    config.source = &source;
+    config.mixer = &mixer;
+    ok = ok && !audio_pwm_dma_init_with_config(&player, wav, &config);
+    config.mixer = NULL;
+    ok = ok && audio_pwm_dma_init_with_config(&player, wav, &config);
+    ok = ok && !audio_pwm_dma_seek(&player, 0, NULL) && !audio_pwm_dma_play(&player, wav);
+    audio_pwm_dma_deinit(&player);
+    wav_info_t wide = *wav;
+    wide.bits_per_sample = 24;
+    ok = ok && !audio_source_wav(&source, &reader, &wide);
+    printf("empty source, source with mixer, seek, play and 24-bit clips %s\n", ok ? "refused" : "NOT REFUSED");
+    return ok;
+}
+
+int main(void) {
+    sim_hw_reset(CLK_HZ);
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(EMBED_SOURCE, &length);
+    wav_info_t source = {0};
+    if (!file || !parse_wav(file, length, &source)) {
+        fprintf(stderr, "%s: cannot load\n", EMBED_SOURCE);
+        return 1;
+    }
+    static wav_info_t u8, s16, alaw, mulaw, adpcm, qoa;
+    const struct {
+        wav_info_t *out;
+        wav_convert_format_t format;
+    } formats[] = {
+        {&u8, WAV_CONVERT_U8},       {&s16, WAV_CONVERT_S16},         {&alaw, WAV_CONVERT_ALAW},
+        {&mulaw, WAV_CONVERT_MULAW}, {&adpcm, WAV_CONVERT_IMA_ADPCM}, {&qoa, WAV_CONVERT_QOA},
+    };
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+        wav_convert_options_t options = {formats[f].format, RATE, true};
+        if (!wav_convert(&source, &options, formats[f].out)) {
+            fprintf(stderr, "%s: conversion failed\n", EMBED_SOURCE);
+            return 1;
+        }
+    }
+    // A stereo clip from the mono one: the right channel inverted at half
+    // level, so a swap or a downmix shows.
+    size_t frames = wav_frame_count(&s16);
+    int16_t *lr = malloc(frames * 2u * sizeof(int16_t));
+    if (!lr) {
+        return 1;
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        int16_t s = ((const int16_t *)s16.data)[i];
+        lr[2 * i] = s;
+        lr[2 * i + 1] = (int16_t)(-s / 2);
+    }
+    wav_info_t stereo = s16;
+    stereo.data = (const uint8_t *)lr;
+    stereo.data_size = frames * 4u;
+    stereo.channels = 2;
+    stereo.block_align = 4;
+
+    const case_t cases[] = {
+        {"u8", &u8, AUDIO_PWM_DMA_DITHER_NONE, 1, false, false, false},
+        {"u8 through s16", &u8, AUDIO_PWM_DMA_DITHER_NONE, 1, false, false, true},
+        {"s16", &s16, AUDIO_PWM_DMA_DITHER_NONE, 1, false, false, false},
+        {"s16 shaped2", &s16, AUDIO_PWM_DMA_DITHER_SHAPED2, 1, false, false, false},
+        {"s16 stereo", &stereo, AUDIO_PWM_DMA_DITHER_NONE, 1, true, false, false},
+        {"s16 stereo downmix", &stereo, AUDIO_PWM_DMA_DITHER_TPDF, 1, false, false, false},
+        {"s16 sigma-delta 8x", &s16, AUDIO_PWM_DMA_DITHER_NONE, 8, false, false, false},
+        {"alaw", &alaw, AUDIO_PWM_DMA_DITHER_NONE, 1, false, false, false},
+        {"mulaw", &mulaw, AUDIO_PWM_DMA_DITHER_NONE, 1, false, false, false},
+        {"mulaw through s16", &mulaw, AUDIO_PWM_DMA_DITHER_NONE, 1, false, false, true},
+        {"mulaw stereo out", &mulaw, AUDIO_PWM_DMA_DITHER_NONE, 1, true, false, false},
+        {"adpcm", &adpcm, AUDIO_PWM_DMA_DITHER_NONE, 1, false, false, false},
+        {"qoa tpdf", &qoa, AUDIO_PWM_DMA_DITHER_TPDF, 1, false, false, false},
+        {"qoa pipeline", &qoa, AUDIO_PWM_DMA_DITHER_NONE, 1, false, true, false},
+        {"u8 pipeline", &u8, AUDIO_PWM_DMA_DITHER_NONE, 1, false, true, false},
+    };
+    printf("%-24s %-6s %s\n", "clip source", "read", "output");
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        ok = check_wav(&cases[i]) && ok;
+    }
+    ok = check_callback(&s16) && ok;
+    ok = check_tone() && ok;
+    ok = check_refusals(&s16) && ok;
+    free(lr);
+    printf("%s\n", ok ? "source checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
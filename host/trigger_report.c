@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_mixer.h"
+#include "audio_pwm_dma.h"
+#include "capture.h"
+#include "sim_hw.h"
+#include "wav.h"
+#include "wav_convert.h"
+#include "wav_io.h"
+
+// Fires short one-shot clips at random times into a mixer player on the
+// simulated hardware, over a looping background voice, and prints the
+// distribution of trigger-to-sound latency: from the call to the PWM CC
+// write of the clip's first frame, found from the captured output. Runs
+// each ring shape with audio_pwm_dma_trigger() and with a plain
+// audio_mixer_play(), whose voices wait behind the queued ring. The
+// output of every run must equal an offline mix with each clip started at
+// the frame it was heard from. With TPDF dither the output must be that
+// mix dithered as one stream: queued frames a trigger remixes are dithered
+// again, so may land up to two levels away, and every other frame must keep
+// its place in the dither sequence. Exits non-zero on a mismatch, an
+// underrun, or a trigger later than AUDIO_PWM_DMA_TRIGGER_LEAD plus one
+// sample.
+
+#define CLK_HZ 125000000u
+#define RATE 16000u
+#define CYCLES_PER_FRAME (CLK_HZ / RATE)
+#define TRIGGERS 250u
+#define CLICK_FRAMES 96u
+
+typedef struct {
+    uint count;
+    uint samples;
+} ring_t;
+
+static const ring_t rings[] = {{4, 256}, {2, 512}, {16, 64}};
+
+typedef struct {
+    uint64_t cycle;  // when the call was made
+    uint64_t frame;  // mixer frame the clip starts at
+    uint64_t end;    // first frame the trigger did not remix
+} trigger_t;
+
+static wav_info_t background, click;
+static uint16_t ring_storage[16 * 256];
+
+// Plays the background loop and fires the click TRIGGERS times, 8 to 40 ms
+// apart. Fills in where each click was heard from and the player's stats.
+static bool run(ring_t ring, bool trigger, audio_pwm_dma_dither_t dither, capture_t *cap, trigger_t *fired,
+                audio_pwm_dma_stats_t *stats) {
+    static audio_mixer_t mixer;
+    static audio_player_t player;
+    sim_hw_reset(CLK_HZ);
+    memset(cap, 0, sizeof(*cap));
+    sim_hw_set_cc_hook(capture_cc, cap);
+    audio_mixer_init(&mixer, RATE, false);
+    audio_mixer_play(&mixer, &background, AUDIO_MIXER_UNITY / 4, 0, true);
+    audio_pwm_dma_config_t config = audio_pwm_dma_get_default_config(0);
+    config.mixer = &mixer;
+    config.buffers = ring_storage;
+    config.buffer_count = ring.count;
+    config.buffer_samples = ring.samples;
+    config.dither = dither;
+    if (!audio_pwm_dma_init_with_config(&player, NULL, &config)) {
+        return false;
+    }
+    cap->slice = player.slice_num;
+    cap->channel = player.pwm_channel;
+    audio_pwm_dma_start(&player);
+    cap->armed = true;
+
+    bool ok = true;
+    uint32_t seed = 0x2545f491u;
+    for (size_t i = 0; i < TRIGGERS; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        sim_hw_run(CLK_HZ / 125u + (uint64_t)(seed >> 8) % (CLK_HZ / 31u));
+        fired[i].cycle = sim_hw_now();
+        if (trigger) {
+            // The DMA has written one CC value per frame so far, so the
+            // read position is the capture count.
+            uint32_t delay = 0;
+            ok = ok && audio_pwm_dma_trigger(&player, &click, AUDIO_MIXER_UNITY, 0, &delay) >= 0;
+            fired[i].frame = cap->count + delay;
+        } else {
+            fired[i].frame = mixer.frames_mixed;
+        }
+        fired[i].end = mixer.frames_mixed;
+        if (!trigger) {
+            ok = ok && audio_mixer_play(&mixer, &click, AUDIO_MIXER_UNITY, 0, false) >= 0;
+        }
+    }
+    sim_hw_run(CLK_HZ / 10u);
+    cap->armed = false;
+    audio_pwm_dma_get_stats(&player, stats);
+    audio_pwm_dma_deinit(&player);
+    return ok;
+}
+
+// The same mix offline, each click started at the frame it was heard from,
+// as levels: truncated, or dithered by a player reading the mix as one s16
+// stream.
+static uint8_t *expected_levels(size_t count, const trigger_t *fired, audio_pwm_dma_dither_t dither) {
+    static audio_mixer_t mixer;
+    static audio_player_t player;
+    audio_mixer_init(&mixer, RATE, false);
+    audio_mixer_play(&mixer, &background, AUDIO_MIXER_UNITY / 4, 0, true);
+    int16_t *mix = malloc(count * sizeof(*mix));
+    uint16_t *levels = malloc(count * sizeof(*levels));
+    uint8_t *out = malloc(count);
+    if (!mix || !levels || !out) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    size_t next = 0;
+    for (size_t f = 0; f < count; ++f) {
+        for (; next < TRIGGERS && fired[next].frame == f; ++next) {
+            audio_mixer_play(&mixer, &click, AUDIO_MIXER_UNITY, 0, false);
+        }
+        audio_mixer_render(&mixer, &mix[f], 1);
+    }
+    memset(&player, 0, sizeof(player));
+    player.dither = dither;
+    wav_info_t wav = {(const uint8_t *)mix, count * 2u, RATE, 16, 1, false, WAV_ENCODING_PCM, 2, 0};
+    audio_pwm_dma_prepare(&player, &wav);
+    audio_pwm_dma_fill(&player, levels, count);
+    for (size_t f = 0; f < count; ++f) {
+        out[f] = (uint8_t)levels[f];
+    }
+    free(mix);
+    free(levels);
+    return out;
+}
+
+// Returns the first captured frame that differs from want, or the capture
+// count. Frames a trigger remixed were dithered twice, so may land up to
+// two levels away.
+static size_t first_difference(const capture_t *cap, const trigger_t *fired, const uint8_t *want, bool dithered) {
+    size_t next = 0;
+    for (size_t f = 0; f < cap->count; ++f) {
+        while (next < TRIGGERS && fired[next].end <= f) {
+            ++next;
+        }
+        int diff = (int)cap->levels[f] - want[f];
+        bool remixed = false;
+        for (size_t i = next; i < TRIGGERS && fired[i].frame <= f; ++i) {
+            remixed = remixed || f < fired[i].end;
+        }
+        if (diff != 0 && !(dithered && remixed && diff >= -2 && diff <= 2)) {
+            return f;
+        }
+    }
+    return cap->count;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Prints one row; returns the worst latency in cycles.
+static uint64_t report(ring_t ring, const char *call, const capture_t *cap, const trigger_t *fired, bool exact,
+                       const audio_pwm_dma_stats_t *stats) {
+    static uint64_t latency[TRIGGERS];
+    for (size_t i = 0; i < TRIGGERS; ++i) {
+        latency[i] = fired[i].frame < cap->count ? cap->cycles[fired[i].frame] - fired[i].cycle : UINT64_MAX;
+    }
+    qsort(latency, TRIGGERS, sizeof(latency[0]), compare_u64);
+    size_t at[] = {0, TRIGGERS / 2, TRIGGERS * 9 / 10, TRIGGERS * 99 / 100, TRIGGERS - 1};
+    printf("%2ux%-4u %-9s", ring.count, ring.samples, call);
+    for (size_t k = 0; k < sizeof(at) / sizeof(at[0]); ++k) {
+        uint64_t c = latency[at[k]];
+        printf(" %6.1f/%-7.0f", (double)c / CYCLES_PER_FRAME, (double)c * 1e6 / CLK_HZ);
+    }
+    printf(" %9u %s\n", (unsigned)stats->underruns, exact ? "exact" : "MISMATCH");
+    return latency[TRIGGERS - 1];
+}
+
+int main(void) {
+    sim_hw_reset(CLK_HZ);
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(EMBED_SOURCE, &length);
+    wav_info_t source = {0};
+    if (!file || !parse_wav(file, length, &source)) {
+        fprintf(stderr, "%s: cannot load\n", EMBED_SOURCE);
+        return 1;
+    }
+    wav_convert_options_t s16 = {WAV_CONVERT_S16, RATE, true}, mulaw = {WAV_CONVERT_MULAW, RATE, true};
+    if (!wav_convert(&source, &s16, &background) || !wav_convert(&source, &mulaw, &click)) {
+        fprintf(stderr, "%s: conversion failed\n", EMBED_SOURCE);
+        return 1;
+    }
+    click.data += click.data_size / 3u;
+    click.data_size = CLICK_FRAMES;
+
+    printf("%u one-shot clips at %u Hz over a background loop; latency in samples/us\n", TRIGGERS, RATE);
+    printf("%-7s %-9s %-14s %-14s %-14s %-14s %-14s %9s %s\n", "ring", "call", "min", "median", "p90", "p99", "max",
+           "underruns", "output");
+    bool ok = true;
+    static trigger_t fired[TRIGGERS];
+    static const struct {
+        const char *name;
+        bool trigger;
+        audio_pwm_dma_dither_t dither;
+    } calls[] = {
+        {"trigger", true, AUDIO_PWM_DMA_DITHER_NONE},
+        {"play", false, AUDIO_PWM_DMA_DITHER_NONE},
+        {"trig+tpdf", true, AUDIO_PWM_DMA_DITHER_TPDF},
+    };
+    for (size_t r = 0; r < sizeof(rings) / sizeof(rings[0]); ++r) {
+        for (size_t c = 0; c < sizeof(calls) / sizeof(calls[0]); ++c) {
+            capture_t cap;
+            audio_pwm_dma_stats_t stats;
+            bool dithered = calls[c].dither != AUDIO_PWM_DMA_DITHER_NONE;
+            bool ran = run(rings[r], calls[c].trigger, calls[c].dither, &cap, fired, &stats);
+            uint8_t *want = expected_levels(cap.count, fired, calls[c].dither);
+            bool exact = ran && first_difference(&cap, fired, want, dithered) == cap.count;
+            uint64_t worst = report(rings[r], calls[c].name, &cap, fired, exact, &stats);
+            ok = ok && exact && stats.underruns == 0;
+            if (calls[c].trigger) {
+                ok = ok && worst <= (uint64_t)(AUDIO_PWM_DMA_TRIGGER_LEAD + 1) * CYCLES_PER_FRAME;
+            }
+            free(want);
+            capture_free(&cap);
+        }
+    }
+    printf("%s\n", ok ? "trigger checks pass" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
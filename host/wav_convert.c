@@ -0,0 +1,172 @@
+#include "wav_convert.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "g711_ref.h"
+#include "ima_adpcm_ref.h"
+#include "qoa.h"
+#include "qoa_ref.h"
+
+// Bytes per channel in each IMA ADPCM block, as adpcm_encode defaults to.
+#define ADPCM_BLOCK 512u
+
+static const char *const format_names[] = {
+    [WAV_CONVERT_U8] = "u8",     [WAV_CONVERT_S16] = "s16",         [WAV_CONVERT_ALAW] = "alaw",
+    [WAV_CONVERT_MULAW] = "mulaw", [WAV_CONVERT_IMA_ADPCM] = "adpcm", [WAV_CONVERT_QOA] = "qoa",
+};
+
+bool wav_convert_format_from_name(const char *name, wav_convert_format_t *format) {
+    for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); ++i) {
+        if (!strcmp(name, format_names[i])) {
+            *format = (wav_convert_format_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// One PCM sample in s16 scale: the top 16 bits of integers, floats
+// truncated towards zero and saturated.
+static int16_t pcm_to_s16(const uint8_t *p, const wav_info_t *wav) {
+    if (wav->is_float) {
+        float x;
+        memcpy(&x, p, sizeof(x));
+        double y = isnan(x) ? 0.0 : trunc((double)x * 32768.0);
+        return (int16_t)(y >= 32767.0 ? 32767 : y <= -32768.0 ? -32768 : (int32_t)y);
+    }
+    uint32_t bytes = wav->bits_per_sample / 8u;
+    if (bytes == 1) {
+        return (int16_t)((p[0] - 128) * 256);
+    }
+    return (int16_t)(p[bytes - 2] | (p[bytes - 1] << 8));
+}
+
+int16_t *wav_convert_decode(const wav_info_t *wav) {
+    switch (wav->encoding) {
+    case WAV_ENCODING_IMA_ADPCM:
+        return ima_ref_decode(wav);
+    case WAV_ENCODING_QOA:
+        return qoa_ref_decode(wav);
+    case WAV_ENCODING_ALAW:
+    case WAV_ENCODING_MULAW:
+        return g711_ref_decode(wav);
+    default:
+        break;
+    }
+    size_t samples = wav_frame_count(wav) * wav->channels;
+    int16_t *out = malloc((samples ? samples : 1) * sizeof(*out));
+    if (!out) {
+        return NULL;
+    }
+    size_t bytes = wav->bits_per_sample / 8u;
+    for (size_t i = 0; i < samples; ++i) {
+        out[i] = pcm_to_s16(wav->data + i * bytes, wav);
+    }
+    return out;
+}
+
+// Linear interpolation between neighbouring source frames, with the
+// position in 32.16 fixed point. Good enough for voice prompts; resample
+// music beforehand with a proper filter.
+static int16_t *resample(const int16_t *in, size_t frames, uint16_t channels, uint32_t from, uint32_t to,
+                         size_t *frames_out) {
+    size_t n = (size_t)((uint64_t)frames * to / from);
+    int16_t *out = malloc((n ? n : 1) * channels * sizeof(*out));
+    if (!out) {
+        return NULL;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t pos = (uint64_t)i * from;
+        size_t k = (size_t)(pos / to);
+        int32_t frac = (int32_t)(((pos % to) << 16) / to);
+        size_t k1 = k + 1 < frames ? k + 1 : k;
+        for (uint16_t c = 0; c < channels; ++c) {
+            int32_t a = in[k * channels + c], b = in[k1 * channels + c];
+            out[i * channels + c] = (int16_t)(a + (((b - a) * frac) >> 16));
+        }
+    }
+    *frames_out = n;
+    return out;
+}
+
+// Encodes s16 frames in the requested format into *out.
+static uint8_t *encode(const int16_t *pcm, size_t frames, uint16_t channels, uint32_t rate,
+                       wav_convert_format_t format, wav_info_t *out) {
+    size_t samples = frames * channels;
+    *out = (wav_info_t){.sample_rate = rate, .channels = channels, .bits_per_sample = 8};
+    uint8_t *data = NULL;
+    switch (format) {
+    case WAV_CONVERT_QOA: {
+        size_t size = 0;
+        data = qoa_ref_encode(pcm, frames, channels, rate, &size);
+        if (data && !parse_qoa(data, size, out)) {
+            free(data);
+            data = NULL;
+        }
+        return data;
+    }
+    case WAV_CONVERT_IMA_ADPCM: {
+        uint16_t block_align = (uint16_t)(ADPCM_BLOCK * channels);
+        data = ima_ref_encode(pcm, frames, channels, block_align, &out->data_size);
+        out->bits_per_sample = 4;
+        out->encoding = WAV_ENCODING_IMA_ADPCM;
+        out->block_align = block_align;
+        out->samples_per_block = (uint16_t)((ADPCM_BLOCK - 4u) * 2u + 1u);
+        break;
+    }
+    case WAV_CONVERT_S16:
+        data = malloc(samples ? 2u * samples : 1u);
+        for (size_t i = 0; data && i < samples; ++i) {
+            data[2 * i] = (uint8_t)pcm[i];
+            data[2 * i + 1] = (uint8_t)((uint16_t)pcm[i] >> 8);
+        }
+        out->data_size = 2u * samples;
+        out->bits_per_sample = 16;
+        out->block_align = (uint16_t)(2u * channels);
+        break;
+    default:
+        data = malloc(samples ? samples : 1u);
+        for (size_t i = 0; data && i < samples; ++i) {
+            data[i] = format == WAV_CONVERT_ALAW    ? g711_ref_encode_alaw(pcm[i])
+                      : format == WAV_CONVERT_MULAW ? g711_ref_encode_ulaw(pcm[i])
+                                                    : (uint8_t)((pcm[i] + 32768) >> 8);
+        }
+        out->data_size = samples;
+        out->encoding = format == WAV_CONVERT_ALAW    ? WAV_ENCODING_ALAW
+                        : format == WAV_CONVERT_MULAW ? WAV_ENCODING_MULAW
+                                                      : WAV_ENCODING_PCM;
+        out->block_align = channels;
+        break;
+    }
+    out->data = data;
+    return data;
+}
+
+uint8_t *wav_convert(const wav_info_t *in, const wav_convert_options_t *options, wav_info_t *out) {
+    int16_t *pcm = wav_convert_decode(in);
+    if (!pcm) {
+        return NULL;
+    }
+    size_t frames = wav_frame_count(in);
+    uint16_t channels = in->channels;
+    if (options->mono && channels == 2) {
+        for (size_t i = 0; i < frames; ++i) {
+            pcm[i] = (int16_t)((pcm[2 * i] + pcm[2 * i + 1]) >> 1);
+        }
+        channels = 1;
+    }
+    uint32_t rate = in->sample_rate;
+    if (options->sample_rate && options->sample_rate != rate) {
+        int16_t *resampled = resample(pcm, frames, channels, rate, options->sample_rate, &frames);
+        free(pcm);
+        if (!(pcm = resampled)) {
+            return NULL;
+        }
+        rate = options->sample_rate;
+    }
+    uint8_t *data = frames ? encode(pcm, frames, channels, rate, options->format, out) : NULL;
+    free(pcm);
+    return data;
+}
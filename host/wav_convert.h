@@ -0,0 +1,41 @@
+#ifndef WAV_CONVERT_H
+#define WAV_CONVERT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wav.h"
+
+// Host-side clip conversion for build-time embedding: any clip the player
+// can parse is decoded to s16, optionally downmixed and resampled, then
+// re-encoded in one of the formats the player reads from flash.
+
+typedef enum {
+    WAV_CONVERT_U8 = 0,
+    WAV_CONVERT_S16,
+    WAV_CONVERT_ALAW,
+    WAV_CONVERT_MULAW,
+    WAV_CONVERT_IMA_ADPCM,
+    WAV_CONVERT_QOA,
+} wav_convert_format_t;
+
+typedef struct {
+    wav_convert_format_t format;
+    uint32_t sample_rate;  // 0 keeps the source rate
+    bool mono;             // downmix stereo sources
+} wav_convert_options_t;
+
+// Looks up a format by its name: u8, s16, alaw, mulaw, adpcm or qoa.
+bool wav_convert_format_from_name(const char *name, wav_convert_format_t *format);
+
+// Decodes a parsed clip to interleaved s16; returns a malloc'd buffer of
+// wav_frame_count() frames, or NULL.
+int16_t *wav_convert_decode(const wav_info_t *wav);
+
+// Converts a parsed clip and describes the result in *out as parse_wav()
+// or parse_qoa() would, with out->data pointing into the returned malloc'd
+// buffer (for QOA, past the file header). Returns NULL on failure.
+uint8_t *wav_convert(const wav_info_t *in, const wav_convert_options_t *options, wav_info_t *out);
+
+#endif
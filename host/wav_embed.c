@@ -0,0 +1,155 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "incbin.h"
+#include "qoa.h"
+#include "wav.h"
+#include "wav_convert.h"
+#include "wav_io.h"
+
+// Build-time half of pico_wav_embed() (cmake/pico_wav_embed.cmake): converts
+// a WAV or QOA file and writes NAME.bin with the sample data, NAME.c, which
+// pulls the data in with .incbin and defines a wav_info_t describing it,
+// and NAME.h declaring that. The player then needs no parsing at startup.
+
+static const char *const encoding_names[] = {
+    [WAV_ENCODING_PCM] = "WAV_ENCODING_PCM",     [WAV_ENCODING_IMA_ADPCM] = "WAV_ENCODING_IMA_ADPCM",
+    [WAV_ENCODING_QOA] = "WAV_ENCODING_QOA",     [WAV_ENCODING_ALAW] = "WAV_ENCODING_ALAW",
+    [WAV_ENCODING_MULAW] = "WAV_ENCODING_MULAW",
+};
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: wav_embed --name NAME --format u8|s16|alaw|mulaw|adpcm|qoa [--rate HZ] [--mono]\n"
+            "                 in.wav|in.qoa outdir\n"
+            "  --name NAME    C identifier of the clip's wav_info_t; also names the files\n"
+            "  --rate HZ      resample (linear interpolation) to HZ\n"
+            "  --mono         downmix stereo to mono\n");
+    exit(2);
+}
+
+static bool is_identifier(const char *name) {
+    if (!*name || isdigit((unsigned char)*name)) {
+        return false;
+    }
+    for (const char *p = name; *p; ++p) {
+        if (!isalnum((unsigned char)*p) && *p != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static FILE *open_output(const char *dir, const char *name, const char *ext, char *path, size_t size) {
+    snprintf(path, size, "%s/%s.%s", dir, name, ext);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "%s: cannot write\n", path);
+    }
+    return f;
+}
+
+static bool write_outputs(const char *dir, const char *name, const char *source, const wav_info_t *wav) {
+    char bin_path[4096], path[4096], symbol[256];
+    snprintf(bin_path, sizeof(bin_path), "%s/%s.bin", dir, name);
+    if (!incbin_write_file(bin_path, wav->data, wav->data_size)) {
+        return false;
+    }
+
+    size_t frames = wav_frame_count(wav);
+    FILE *f = open_output(dir, name, "h", path, sizeof(path));
+    if (!f) {
+        return false;
+    }
+    fprintf(f,
+            "// Generated by wav_embed from %s; do not edit.\n"
+            "#ifndef WAV_EMBED_%s_H\n"
+            "#define WAV_EMBED_%s_H\n"
+            "\n"
+            "#include \"wav.h\"\n"
+            "\n"
+            "// %zu frames at %u Hz, %u channel(s), %zu bytes.\n"
+            "extern const wav_info_t %s;\n"
+            "\n"
+            "#endif\n",
+            source, name, name, frames, (unsigned)wav->sample_rate, (unsigned)wav->channels, wav->data_size, name);
+    bool ok = fclose(f) == 0;
+
+    if (!(f = open_output(dir, name, "c", path, sizeof(path)))) {
+        return false;
+    }
+    snprintf(symbol, sizeof(symbol), "%s_data", name);
+    fprintf(f, "// Generated by wav_embed from %s; do not edit.\n#include \"%s.h\"\n\n", source, name);
+    incbin_write(f, symbol, bin_path);
+    fprintf(f,
+            "\n"
+            "const wav_info_t %s = {\n"
+            "    .data = %s,\n"
+            "    .data_size = %zu,\n"
+            "    .sample_rate = %u,\n"
+            "    .bits_per_sample = %u,\n"
+            "    .channels = %u,\n"
+            "    .is_float = false,\n"
+            "    .encoding = %s,\n"
+            "    .block_align = %u,\n"
+            "    .samples_per_block = %u,\n"
+            "};\n",
+            name, symbol, wav->data_size, (unsigned)wav->sample_rate, (unsigned)wav->bits_per_sample,
+            (unsigned)wav->channels, encoding_names[wav->encoding], (unsigned)wav->block_align,
+            (unsigned)wav->samples_per_block);
+    return fclose(f) == 0 && ok;
+}
+
+int main(int argc, char **argv) {
+    const char *name = NULL, *format_name = NULL;
+    const char *paths[2] = {0};
+    int npaths = 0;
+    wav_convert_options_t options = {0};
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--name") && i + 1 < argc) {
+            name = argv[++i];
+        } else if (!strcmp(argv[i], "--format") && i + 1 < argc) {
+            format_name = argv[++i];
+        } else if (!strcmp(argv[i], "--rate") && i + 1 < argc) {
+            options.sample_rate = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--mono")) {
+            options.mono = true;
+        } else if (argv[i][0] != '-' && npaths < 2) {
+            paths[npaths++] = argv[i];
+        } else {
+            usage();
+        }
+    }
+    if (npaths != 2 || !name || !format_name) {
+        usage();
+    }
+    if (!is_identifier(name)) {
+        fprintf(stderr, "%s: not a C identifier\n", name);
+        return 2;
+    }
+    if (!wav_convert_format_from_name(format_name, &options.format)) {
+        fprintf(stderr, "%s: unknown format\n", format_name);
+        return 2;
+    }
+
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(paths[0], &length);
+    wav_info_t in = {0};
+    if (!file || (!parse_wav(file, length, &in) && !parse_qoa(file, length, &in))) {
+        fprintf(stderr, "%s: not a WAV or QOA file the player supports\n", paths[0]);
+        return 1;
+    }
+    wav_info_t out = {0};
+    uint8_t *data = wav_convert(&in, &options, &out);
+    if (!data) {
+        fprintf(stderr, "%s: conversion failed\n", paths[0]);
+        return 1;
+    }
+    if (!write_outputs(paths[1], name, paths[0], &out)) {
+        return 1;
+    }
+    free(data);
+    return 0;
+}
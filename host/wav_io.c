@@ -0,0 +1,98 @@
+#include "wav_io.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The simulator's DMA only reaches memory with 32-bit bus addresses; the
+// tools have no simulator and load into the heap.
+#if WAV_IO_BUS_MEMORY
+#include "sim_hw.h"
+#define wav_io_alloc sim_hw_alloc
+#else
+#define wav_io_alloc malloc
+#endif
+
+uint8_t *wav_io_load(const char *path, size_t *length_out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = length > 0 ? wav_io_alloc((size_t)length) : NULL;
+    if (!data || fread(data, 1, (size_t)length, f) != (size_t)length) {
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    *length_out = (size_t)length;
+    return data;
+}
+
+static void put_u16(FILE *f, uint16_t v) {
+    uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+    fwrite(b, 1, sizeof(b), f);
+}
+
+static void put_u32(FILE *f, uint32_t v) {
+    uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    fwrite(b, 1, sizeof(b), f);
+}
+
+bool wav_io_write(const char *path, const void *samples, size_t frames, uint32_t sample_rate,
+                  uint16_t bits_per_sample, uint16_t channels) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    uint32_t block_align = (uint32_t)(bits_per_sample / 8) * channels;
+    uint32_t data_size = (uint32_t)(frames * block_align);
+    fwrite("RIFF", 1, 4, f);
+    put_u32(f, 36 + data_size);
+    fwrite("WAVEfmt ", 1, 8, f);
+    put_u32(f, 16);
+    put_u16(f, 1);
+    put_u16(f, channels);
+    put_u32(f, sample_rate);
+    put_u32(f, sample_rate * block_align);
+    put_u16(f, (uint16_t)block_align);
+    put_u16(f, bits_per_sample);
+    fwrite("data", 1, 4, f);
+    put_u32(f, data_size);
+    bool ok = fwrite(samples, 1, data_size, f) == data_size;
+    return fclose(f) == 0 && ok;
+}
+
+bool wav_io_write_ima_adpcm(const char *path, const uint8_t *blocks, size_t size, size_t frames,
+                            uint32_t sample_rate, uint16_t channels, uint16_t block_align) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    uint32_t samples_per_block = (block_align - 4u * channels) * 2u / channels + 1u;
+    uint32_t data_size = (uint32_t)size;
+    fwrite("RIFF", 1, 4, f);
+    put_u32(f, 4 + 28 + 12 + 8 + data_size + (data_size & 1u));
+    fwrite("WAVEfmt ", 1, 8, f);
+    put_u32(f, 20);
+    put_u16(f, 0x11);
+    put_u16(f, channels);
+    put_u32(f, sample_rate);
+    put_u32(f, (uint32_t)((uint64_t)sample_rate * block_align / samples_per_block));
+    put_u16(f, block_align);
+    put_u16(f, 4);
+    put_u16(f, 2);
+    put_u16(f, (uint16_t)samples_per_block);
+    fwrite("fact", 1, 4, f);
+    put_u32(f, 4);
+    put_u32(f, (uint32_t)frames);
+    fwrite("data", 1, 4, f);
+    put_u32(f, data_size);
+    bool ok = fwrite(blocks, 1, data_size, f) == data_size;
+    if (data_size & 1u) {
+        fputc(0, f);
+    }
+    return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,21 @@
+#ifndef WAV_IO_H
+#define WAV_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Reads a whole file into memory: bus-addressable simulator memory when
+// built with WAV_IO_BUS_MEMORY (the simulator's checks), else the heap.
+uint8_t *wav_io_load(const char *path, size_t *length_out);
+
+// Writes interleaved little-endian PCM (8-bit unsigned or 16-bit signed).
+bool wav_io_write(const char *path, const void *samples, size_t frames, uint32_t sample_rate,
+                  uint16_t bits_per_sample, uint16_t channels);
+
+// Writes IMA ADPCM blocks (see ima_adpcm_ref.h) with the extended fmt and
+// fact chunks the format calls for.
+bool wav_io_write_ima_adpcm(const char *path, const uint8_t *blocks, size_t size, size_t frames,
+                            uint32_t sample_rate, uint16_t channels, uint16_t block_align);
+
+#endif
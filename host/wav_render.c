@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_pwm_dma.h"
+#include "capture.h"
+#include "g711_ref.h"
+#include "hardware/pwm.h"
+#include "ima_adpcm_ref.h"
+#include "qoa.h"
+#include "qoa_ref.h"
+#include "sim_hw.h"
+#include "wav.h"
+#include "wav_io.h"
+
+// Renders a WAV through the real player code running on the simulated
+// PWM/DMA/IRQ layer and stores every level written to the output CC
+// half-word as a new WAV. Output is bit-exact, so it works as a golden file.
+// IMA ADPCM, QOA and G.711 input is also decoded by the host reference
+// decoders, and the levels played must be exactly that output truncated
+// (undithered runs). QOA files are taken as input as they are, without a WAV wrapper.
+
+static audio_player_t player;
+
+// Mono output keeps the player's half of CC; stereo keeps whole writes,
+// A then B.
+static uint16_t sample_level(const capture_t *cap, size_t i, uint out_channels) {
+    return (uint16_t)(cap->levels[i / out_channels] >> (16u * (i % out_channels)));
+}
+
+// Compares the played levels with the reference decode of a compressed clip.
+static bool verify_decoded(const wav_info_t *wav, const capture_t *cap, size_t frames, bool stereo) {
+    const char *name;
+    int16_t *ref;
+    if (wav->encoding == WAV_ENCODING_QOA) {
+        name = "QOA";
+        ref = qoa_ref_decode(wav);
+    } else if (wav->encoding == WAV_ENCODING_IMA_ADPCM) {
+        name = "ADPCM";
+        ref = ima_ref_decode(wav);
+    } else {
+        name = "G.711";
+        ref = g711_ref_decode(wav);
+    }
+    if (!ref) {
+        fprintf(stderr, "reference decode failed\n");
+        return false;
+    }
+    uint ch = wav->channels;
+    size_t bad = 0, first = 0;
+    for (size_t f = 0; f < frames; ++f) {
+        int32_t l = ref[f * ch], r = ref[f * ch + ch - 1];
+        uint16_t expect[2] = {(uint16_t)((l + 32768) >> 8), (uint16_t)((r + 32768) >> 8)};
+        if (!stereo) {
+            expect[0] = (uint16_t)((l + r + 65536) >> 9);
+        }
+        for (uint c = 0; c < (stereo ? 2u : 1u); ++c) {
+            if (sample_level(cap, f * (stereo ? 2u : 1u) + c, stereo ? 2u : 1u) != expect[c] && bad++ == 0) {
+                first = f;
+            }
+        }
+    }
+    free(ref);
+    if (bad) {
+        printf("%s: %zu levels differ from the reference decoder, first at frame %zu\n", name, bad, first);
+    } else {
+        printf("%s: all %zu frames match the reference decoder\n", name, frames);
+    }
+    return bad == 0;
+}
+
+static const char *const dither_names[] = {"none", "tpdf", "shaped1", "shaped2"};
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: wav_render [--clk HZ] [--gpio N] [--tail N] [--ring COUNTxSAMPLES] [--stereo]\n"
+            "                  [--dither none|tpdf|shaped1|shaped2] in.wav|in.qoa out.wav\n"
+            "  --clk HZ   simulated clk_sys (default 125000000)\n"
+            "  --gpio N   audio output pin (default 0)\n"
+            "  --tail N   post-EOF samples to keep in the output (default 0)\n"
+            "  --ring CxS DMA ring of C buffers of S samples (default: player's own)\n"
+            "  --stereo   drive channels A and B of the slice; writes a stereo WAV\n"
+            "  --dither M requantization of 16-bit sources (default none)\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    uint32_t clk_hz = 125000000u;
+    uint gpio = 0;
+    size_t tail = 0;
+    uint ring_count = 0;
+    uint ring_samples = 0;
+    bool stereo = false;
+    int dither = -1;
+    const char *paths[2] = {0};
+    int npaths = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--clk") && i + 1 < argc) {
+            clk_hz = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--gpio") && i + 1 < argc) {
+            gpio = (uint)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--tail") && i + 1 < argc) {
+            tail = (size_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--ring") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%ux%u", &ring_count, &ring_samples) != 2) {
+                usage();
+            }
+        } else if (!strcmp(argv[i], "--dither") && i + 1 < argc) {
+            ++i;
+            for (int m = 0; m < (int)(sizeof(dither_names) / sizeof(dither_names[0])); ++m) {
+                if (!strcmp(argv[i], dither_names[m])) {
+                    dither = m;
+                }
+            }
+            if (dither < 0) {
+                usage();
+            }
+        } else if (!strcmp(argv[i], "--stereo")) {
+            stereo = true;
+        } else if (argv[i][0] != '-' && npaths < 2) {
+            paths[npaths++] = argv[i];
+        } else {
+            usage();
+        }
+    }
+    if (npaths != 2) {
+        usage();
+    }
+
+    sim_hw_reset(clk_hz);
+
+    size_t length = 0;
+    const uint8_t *file = wav_io_load(paths[0], &length);
+    wav_info_t wav = {0};
+    if (!file || (!parse_wav(file, length, &wav) && !parse_qoa(file, length, &wav))) {
+        fprintf(stderr, "%s: not a supported WAV or QOA file\n", paths[0]);
+        return 1;
+    }
+
+    audio_pwm_dma_config_t config = audio_pwm_dma_get_default_config(gpio);
+    config.stereo = stereo;
+    if (dither > 0) {
+        config.dither = (audio_pwm_dma_dither_t)dither;
+    }
+    uint out_channels = stereo ? 2u : 1u;
+    if (ring_count) {
+        config.buffers = sim_hw_alloc((size_t)ring_count * ring_samples * out_channels * sizeof(uint16_t));
+        config.buffer_count = ring_count;
+        config.buffer_samples = ring_samples;
+    }
+    if (!audio_pwm_dma_init_with_config(&player, &wav, &config)) {
+        fprintf(stderr, "audio_pwm_dma_init failed\n");
+        return 1;
+    }
+
+    capture_t cap = {.slice = player.slice_num, .channel = player.pwm_channel, .whole = stereo};
+    sim_hw_set_cc_hook(capture_cc, &cap);
+    cap.armed = true;
+    uint64_t start = sim_hw_now();
+    audio_pwm_dma_start(&player);
+
+    size_t frames = wav_frame_count(&wav);
+    size_t wanted = frames + tail;
+    uint64_t step = clk_hz / 100u;
+    uint64_t limit = start + ((uint64_t)wanted * out_channels * 2u / wav.sample_rate + 2u) * clk_hz;
+    while (cap.count < wanted && sim_hw_now() < limit) {
+        size_t before = cap.count;
+        sim_hw_run(step);
+        if (audio_pwm_dma_is_idle(&player) && cap.count == before) {
+            break;
+        }
+    }
+    // A player that has gone idle leaves the pin parked at its last level.
+    while (audio_pwm_dma_is_idle(&player) && cap.count < wanted) {
+        capture_cc(&cap, cap.slice, pwm_hw->slice[cap.slice].cc, sim_hw_now());
+    }
+    if (cap.count < wanted) {
+        fprintf(stderr, "playback stalled after %zu of %zu frames\n", cap.count, wanted);
+        return 1;
+    }
+
+    // Levels on an 8-bit wrap are stored raw; wider wraps are centred into s16.
+    uint32_t top = pwm_hw->slice[player.slice_num].top;
+    bool ok;
+    if (top <= 0xffu) {
+        uint8_t *out = malloc(wanted * out_channels);
+        for (size_t i = 0; i < wanted * out_channels; ++i) {
+            out[i] = (uint8_t)sample_level(&cap, i, out_channels);
+        }
+        ok = wav_io_write(paths[1], out, wanted, wav.sample_rate, 8, (uint16_t)out_channels);
+        free(out);
+    } else {
+        int16_t *out = malloc(wanted * out_channels * sizeof(*out));
+        for (size_t i = 0; i < wanted * out_channels; ++i) {
+            out[i] = (int16_t)(((int64_t)sample_level(&cap, i, out_channels) * 65536) / (top + 1u) - 32768);
+        }
+        ok = wav_io_write(paths[1], out, wanted, wav.sample_rate, 16, (uint16_t)out_channels);
+        free(out);
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", paths[1]);
+        return 1;
+    }
+
+    audio_pwm_dma_stats_t stats;
+    audio_pwm_dma_get_stats(&player, &stats);
+    printf("underruns %u, refills %u, %u IRQs (avg %u, max %u host cycles)\n", stats.underruns, stats.refills,
+           stats.isr_count, stats.isr_cycles_avg, stats.isr_cycles_max);
+
+    double seconds = (double)(sim_hw_now() - start) / clk_hz;
+    printf("rendered %zu samples (%zu frames + %zu tail) in %.3f s virtual time, idle=%d\n",
+           wanted, frames, tail, seconds, audio_pwm_dma_is_idle(&player));
+    if (wav.encoding != WAV_ENCODING_PCM && dither <= 0) {
+        ok = verify_decoded(&wav, &cap, frames, stereo);
+    }
+    capture_free(&cap);
+    return ok ? 0 : 1;
+}
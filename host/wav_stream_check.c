@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_hw.h"
+#include "wav.h"
+#include "wav_io.h"
+
+// Feeds WAVs to the streaming parser in random chunk sizes, including one
+// byte at a time, and checks it agrees with parse_wav() on the whole file:
+// same accept/reject, same format, same data bytes. Covers built-in layouts
+// (extra and odd-sized chunks, extended fmt, partial frames, truncation,
+// unsupported formats) plus any files given on the command line. Exits
+// non-zero on the first disagreement.
+
+#define TRIALS 200u
+#define MAX_FILE 8192u  // largest built-in layout
+
+typedef struct {
+    const char *name;
+    uint16_t audio_format;
+    uint16_t channels;
+    uint16_t bits;
+    uint32_t fmt_size;     // 16, 18 with a cbSize field, 20 for IMA ADPCM, 40 for WAVE_FORMAT_EXTENSIBLE
+    uint32_t data_size;    // as declared in the header
+    uint32_t data_stored;  // bytes actually present, to truncate the file
+    bool list_before;      // odd-sized LIST chunk between fmt and data
+    bool chunk_after;      // trailing chunk after data
+} layout_t;
+
+static const layout_t layouts[] = {
+    {"u8 mono", 1, 1, 8, 16, 1000, 1000, false, false},
+    {"s16 stereo", 1, 2, 16, 16, 4000, 4000, false, false},
+    {"odd data + pad", 1, 1, 8, 16, 999, 999, false, true},
+    {"partial frame", 1, 2, 16, 16, 1003, 1003, false, true},
+    {"odd LIST", 1, 1, 16, 16, 2000, 2000, true, false},
+    {"fmt cbSize", 1, 2, 8, 18, 1500, 1500, true, true},
+    {"float 16", 3, 1, 16, 16, 1000, 1000, false, false},
+    {"float 32", 3, 2, 32, 16, 4000, 4000, false, false},
+    {"ext s24", 1, 2, 24, 40, 3000, 3000, true, false},
+    {"ext float", 3, 1, 32, 40, 2000, 2000, false, true},
+    {"ext alaw", 6, 1, 8, 40, 1000, 1000, false, false},
+    {"ima adpcm st", 0x11, 2, 4, 20, 1300, 1300, true, false},
+    {"ima adpcm tail", 0x11, 1, 4, 20, 775, 775, false, true},
+    {"ima bad block", 0x11, 1, 4, 16, 1000, 1000, false, false},
+    {"3 channels", 1, 3, 16, 16, 1200, 1200, false, false},
+    {"24-bit", 1, 1, 24, 16, 1200, 1200, false, false},
+    {"empty data", 1, 1, 8, 16, 0, 0, false, true},
+    {"no whole frame", 1, 2, 16, 16, 3, 3, false, true},
+    {"truncated", 1, 1, 8, 16, 2000, 1200, false, false},
+};
+
+static uint32_t rng = 0x2468ace1u;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static size_t put_chunk(uint8_t *p, const char *id, uint32_t size) {
+    memcpy(p, id, 4);
+    put_u32(p + 4, size);
+    return 8;
+}
+
+static size_t build(const layout_t *l, uint8_t *file) {
+    size_t n = 12;
+    n += put_chunk(file + n, "fmt ", l->fmt_size);
+    uint8_t *fmt = file + n;
+    memset(fmt, 0, l->fmt_size);
+    put_u16(fmt + 0, l->audio_format);
+    put_u16(fmt + 2, l->channels);
+    put_u32(fmt + 4, 22050);
+    put_u32(fmt + 8, 22050u * l->channels * l->bits / 8u);
+    put_u16(fmt + 12, (uint16_t)(l->channels * l->bits / 8u));
+    put_u16(fmt + 14, l->bits);
+    if (l->audio_format == 0x11) {
+        // 256-byte blocks per channel; "bad block" leaves a 1-byte block.
+        uint16_t block_align = (uint16_t)(l->fmt_size == 20 ? 256u * l->channels : 1u);
+        put_u16(fmt + 12, block_align);
+        if (l->fmt_size == 20) {
+            put_u16(fmt + 16, 2);
+            put_u16(fmt + 18, (uint16_t)((block_align - 4u * l->channels) * 2u / l->channels + 1u));
+        }
+    }
+    if (l->fmt_size == 40) {
+        static const uint8_t guid_tail[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80,
+                                              0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71};
+        put_u16(fmt + 0, 0xfffe);
+        put_u16(fmt + 16, 22);
+        put_u16(fmt + 18, l->bits);
+        put_u16(fmt + 24, l->audio_format);
+        memcpy(fmt + 26, guid_tail, sizeof(guid_tail));
+    }
+    n += l->fmt_size;
+    if (l->list_before) {
+        n += put_chunk(file + n, "LIST", 13);
+        memset(file + n, 'x', 14);
+        n += 14;
+    }
+    n += put_chunk(file + n, "data", l->data_size);
+    for (uint32_t i = 0; i < l->data_stored; ++i) {
+        file[n++] = (uint8_t)next_random();
+    }
+    if (l->data_stored == l->data_size) {
+        if (l->data_size & 1u) {
+            file[n++] = 0;
+        }
+        if (l->chunk_after) {
+            n += put_chunk(file + n, "junk", 5);
+            memset(file + n, 'y', 6);
+            n += 6;
+        }
+    }
+    memcpy(file, "RIFF", 4);
+    put_u32(file + 4, (uint32_t)(n - 8));
+    memcpy(file + 8, "WAVE", 4);
+    return n;
+}
+
+// Streams the file in chunks of random size (max_chunk == 1: byte by byte)
+// and compares the result with the one-shot parse.
+static bool check_stream(const uint8_t *file, size_t length, size_t max_chunk, bool expect_ok,
+                         const wav_info_t *expect, uint8_t *data) {
+    wav_stream_t stream;
+    wav_stream_init(&stream);
+    size_t pos = 0, got = 0;
+    bool format = false, done = false, error = false;
+    while (pos < length && !done && !error) {
+        size_t chunk = 1u + next_random() % max_chunk;
+        if (chunk > length - pos) {
+            chunk = length - pos;
+        }
+        const uint8_t *p = file + pos;
+        size_t left = chunk;
+        for (;;) {
+            size_t used;
+            wav_stream_event_t event = wav_stream_feed(&stream, p, left, &used);
+            p += used;
+            left -= used;
+            if (event == WAV_STREAM_NEED_MORE) {
+                break;
+            }
+            if (event == WAV_STREAM_FORMAT) {
+                if (format) {
+                    return false;
+                }
+                format = true;
+            } else if (event == WAV_STREAM_DATA) {
+                // Spans must point into the chunk just fed.
+                if (!format || stream.span < file + pos || stream.span + stream.span_size > file + pos + chunk) {
+                    return false;
+                }
+                memcpy(data + got, stream.span, stream.span_size);
+                got += stream.span_size;
+            } else {
+                done = event == WAV_STREAM_DONE;
+                error = event == WAV_STREAM_ERROR;
+                break;
+            }
+        }
+        pos += chunk;
+    }
+
+    if (!expect_ok) {
+        return !done;
+    }
+    const wav_info_t *info = &stream.info;
+    return done && info->sample_rate == expect->sample_rate && info->channels == expect->channels &&
+           info->bits_per_sample == expect->bits_per_sample && info->is_float == expect->is_float &&
+           info->encoding == expect->encoding && info->block_align == expect->block_align &&
+           info->samples_per_block == expect->samples_per_block && info->data_size == expect->data_size &&
+           got == expect->data_size && !memcmp(data, expect->data, got);
+}
+
+static bool check_file(const char *name, const uint8_t *file, size_t length) {
+    wav_info_t expect;
+    bool expect_ok = parse_wav(file, length, &expect);
+    uint8_t *data = malloc(length);
+    if (!data) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (uint32_t t = 0; t < TRIALS; ++t) {
+        size_t max_chunk = t == 0 ? 1u : t < TRIALS / 2 ? 16u : 600u;
+        if (!check_stream(file, length, max_chunk, expect_ok, &expect, data)) {
+            printf("%-16s %-8s MISMATCH (trial %u, chunks up to %zu bytes)\n", name, expect_ok ? "accept" : "reject",
+                   t, max_chunk);
+            free(data);
+            return false;
+        }
+    }
+    free(data);
+    printf("%-16s %-8s ok\n", name, expect_ok ? "accept" : "reject");
+    return true;
+}
+
+int main(int argc, char **argv) {
+    sim_hw_reset(125000000u);
+    static uint8_t file[MAX_FILE];
+    bool ok = true;
+    printf("%u random chunkings per file, one byte at a time first\n", TRIALS);
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); ++i) {
+        size_t length = build(&layouts[i], file);
+        ok = check_file(layouts[i].name, file, length) && ok;
+    }
+    for (int i = 1; i < argc; ++i) {
+        size_t length;
+        uint8_t *contents = wav_io_load(argv[i], &length);
+        if (!contents) {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 1;
+        }
+        ok = check_file(argv[i], contents, length) && ok;
+    }
+    printf("%s\n", ok ? "streaming parser matches parse_wav" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+#include "ima_adpcm.h"
+
+static const int16_t step_table[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t index_table[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+void ima_adpcm_init(ima_adpcm_decoder_t *dec, const uint8_t *data, size_t size, uint16_t channels,
+                    uint16_t block_align) {
+    dec->cursor = data;
+    dec->remaining = size;
+    dec->block_left = 0;
+    dec->channels = channels;
+    dec->block_align = block_align;
+    for (uint16_t c = 0; c < 2; ++c) {
+        dec->predictor[c] = 0;
+        dec->step_index[c] = 0;
+    }
+}
+
+// Eight nibbles of one channel, low nibble first, written every stride
+// samples. The state lives in locals for the run of the word.
+static inline void decode_word(const uint8_t *p, int32_t *predictor, uint8_t *step_index, int16_t *out,
+                               size_t stride) {
+    int32_t pred = *predictor;
+    int32_t index = *step_index;
+    for (uint32_t k = 0; k < IMA_ADPCM_GROUP_FRAMES; ++k) {
+        uint32_t nibble = (p[k >> 1] >> ((k & 1u) * 4u)) & 0xfu;
+        int32_t step = step_table[index];
+        int32_t diff = step >> 3;
+        if (nibble & 1u) {
+            diff += step >> 2;
+        }
+        if (nibble & 2u) {
+            diff += step >> 1;
+        }
+        if (nibble & 4u) {
+            diff += step;
+        }
+        pred += (nibble & 8u) ? -diff : diff;
+        if (pred > 32767) {
+            pred = 32767;
+        } else if (pred < -32768) {
+            pred = -32768;
+        }
+        index += index_table[nibble & 7u];
+        if (index < 0) {
+            index = 0;
+        } else if (index > 88) {
+            index = 88;
+        }
+        out[k * stride] = (int16_t)pred;
+    }
+    *predictor = pred;
+    *step_index = (uint8_t)index;
+}
+
+size_t ima_adpcm_decode(ima_adpcm_decoder_t *dec, int16_t *out, size_t max_frames) {
+    uint32_t channels = dec->channels;
+    uint32_t header = 4u * channels;
+    size_t frames = 0;
+    while (dec->remaining >= header) {
+        if (dec->block_left == 0) {
+            // Block header: the first sample as-is, then the step index.
+            if (frames + 1u > max_frames) {
+                break;
+            }
+            for (uint32_t c = 0; c < channels; ++c) {
+                const uint8_t *h = dec->cursor + 4u * c;
+                dec->predictor[c] = (int16_t)(h[0] | (h[1] << 8));
+                dec->step_index[c] = h[2] > 88 ? 88 : h[2];
+                out[frames * channels + c] = (int16_t)dec->predictor[c];
+            }
+            dec->block_left = dec->block_align - header;
+            if (dec->block_left > dec->remaining - header) {
+                dec->block_left = dec->remaining - header;
+            }
+            dec->cursor += header;
+            dec->remaining -= header;
+            frames += 1u;
+            continue;
+        }
+        if (frames + IMA_ADPCM_GROUP_FRAMES > max_frames || dec->block_left < header) {
+            break;
+        }
+        for (uint32_t c = 0; c < channels; ++c) {
+            decode_word(dec->cursor + 4u * c, &dec->predictor[c], &dec->step_index[c], out + frames * channels + c,
+                        channels);
+        }
+        dec->cursor += header;
+        dec->remaining -= header;
+        dec->block_left -= header;
+        frames += IMA_ADPCM_GROUP_FRAMES;
+    }
+    return frames;
+}
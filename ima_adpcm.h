@@ -0,0 +1,33 @@
+#ifndef IMA_ADPCM_H
+#define IMA_ADPCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Frames one 4-byte word per channel decodes to; decode calls hand out whole
+// groups of these (or a block's header frame) at a time.
+#define IMA_ADPCM_GROUP_FRAMES 8u
+
+// Position in a Microsoft IMA ADPCM stream (WAV format 0x11): the next byte,
+// the bytes left in the stream and in the current block, and each channel's
+// predictor and step index.
+typedef struct {
+    const uint8_t *cursor;
+    size_t remaining;
+    size_t block_left;
+    uint16_t channels;
+    uint16_t block_align;
+    int32_t predictor[2];
+    uint8_t step_index[2];
+} ima_adpcm_decoder_t;
+
+void ima_adpcm_init(ima_adpcm_decoder_t *dec, const uint8_t *data, size_t size, uint16_t channels,
+                    uint16_t block_align);
+
+// Decodes up to max_frames interleaved s16 frames into out, stopping before
+// a group that would not fit; max_frames must be at least
+// IMA_ADPCM_GROUP_FRAMES. Returns the frames written, 0 once the data is
+// used up.
+size_t ima_adpcm_decode(ima_adpcm_decoder_t *dec, int16_t *out, size_t max_frames);
+
+#endif
@@ -0,0 +1,150 @@
+#include "pace_solver.h"
+
+#include <stddef.h>
+
+#define PWM_DIV_X16_MIN 16u    // 1.0
+#define PWM_DIV_X16_MAX 4095u  // 255 + 15/16
+#define PWM_PERIOD_MAX 0x10000u
+#define DMA_TIMER_MAX 0xffffu
+
+static uint64_t abs_diff(uint64_t a, uint64_t b) {
+    return a > b ? a - b : b - a;
+}
+
+// (achieved - requested) / requested in ppb, where achieved = num / den.
+static int32_t error_ppb(uint64_t num, uint64_t den) {
+    int64_t diff = (int64_t)num - (int64_t)den;
+    return (int32_t)((diff * 1000000000) / (int64_t)den);
+}
+
+// round(target / step). The search below runs this 4080 times at init and
+// the M0+ only divides 32 bits in hardware, so it stays in 32 bits whenever
+// every sum fits: clk_sys up to 256 MHz at 48 kHz.
+static inline uint64_t nearest_quotient(uint64_t target, uint64_t step, bool narrow) {
+    if (narrow) {
+        return (uint32_t)(target + step / 2u) / (uint32_t)step;
+    }
+    return (target + step / 2u) / step;
+}
+
+// Rate = 16 * clk / (div_x16 * period). Every divider is tried with the
+// nearest period in [period_min, period_max], so the result is the best
+// product the hardware can make. False if no divider reaches the range.
+static bool solve_pwm(uint32_t clk_hz, uint32_t sample_rate, uint32_t period_min, uint32_t period_max,
+                      pace_solution_t *out) {
+    uint64_t target = 16u * (uint64_t)clk_hz;
+    bool narrow = target + (uint64_t)sample_rate * PWM_DIV_X16_MAX <= UINT32_MAX;
+    uint64_t best_err = UINT64_MAX;
+    uint32_t best_div = 0;
+    uint32_t best_period = 0;
+
+    for (uint32_t div = PWM_DIV_X16_MIN; div <= PWM_DIV_X16_MAX; ++div) {
+        uint64_t step = (uint64_t)sample_rate * div;
+        uint64_t period = nearest_quotient(target, step, narrow);
+        if (period < period_min) {
+            period = period_min;
+        }
+        if (period > period_max) {
+            continue;
+        }
+        uint64_t err = abs_diff(target, step * period);
+        if (err < best_err) {
+            best_err = err;
+            best_div = div;
+            best_period = (uint32_t)period;
+            if (err == 0) {
+                break;
+            }
+        }
+    }
+
+    if (best_div == 0) {
+        return false;
+    }
+
+    uint64_t product = (uint64_t)best_div * best_period;
+    *out = (pace_solution_t){
+        .source = PACE_SOURCE_PWM,
+        .pwm_wrap = (uint16_t)(best_period - 1u),
+        .pwm_div_int = (uint8_t)(best_div >> 4),
+        .pwm_div_frac = (uint8_t)(best_div & 0xfu),
+        .rate_millihz = (uint32_t)((target * 1000u + product / 2u) / product),
+        .error_ppb = error_ppb(target, (uint64_t)sample_rate * product),
+    };
+    return true;
+}
+
+// Best rational approximation num/den of sample_rate/clk_hz with den within
+// the 16-bit timer field (continued fractions plus the last semiconvergent).
+static bool solve_dma_timer(uint32_t clk_hz, uint32_t sample_rate, pace_solution_t *out) {
+    uint64_t p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    uint64_t n = sample_rate, d = clk_hz;
+    while (d != 0) {
+        uint64_t a = n / d;
+        uint64_t q2 = q0 + a * q1;
+        if (q2 > DMA_TIMER_MAX) {
+            break;
+        }
+        uint64_t p2 = p0 + a * p1;
+        p0 = p1;
+        q0 = q1;
+        p1 = p2;
+        q1 = q2;
+        uint64_t r = n - a * d;
+        n = d;
+        d = r;
+    }
+
+    uint64_t num = p1, den = q1;
+    if (d != 0 && q1 != 0) {
+        uint64_t k = (DMA_TIMER_MAX - q0) / q1;
+        uint64_t sp = p0 + k * p1, sq = q0 + k * q1;
+        // Compare |sp/sq - r| with |p1/q1 - r| where r = sample_rate / clk_hz.
+        uint64_t err_semi = abs_diff(sp * clk_hz, (uint64_t)sample_rate * sq) * q1;
+        uint64_t err_conv = abs_diff(p1 * clk_hz, (uint64_t)sample_rate * q1) * sq;
+        if (err_semi < err_conv) {
+            num = sp;
+            den = sq;
+        }
+    }
+    if (num == 0 || den == 0 || num > DMA_TIMER_MAX || den > DMA_TIMER_MAX) {
+        return false;
+    }
+
+    *out = (pace_solution_t){
+        .source = PACE_SOURCE_DMA_TIMER,
+        .timer_num = (uint16_t)num,
+        .timer_den = (uint16_t)den,
+        .rate_millihz = (uint32_t)(((uint64_t)clk_hz * num * 1000u + den / 2u) / den),
+        .error_ppb = error_ppb((uint64_t)clk_hz * num, (uint64_t)sample_rate * den),
+    };
+    return true;
+}
+
+bool pace_solve(uint32_t clk_hz, uint32_t sample_rate, bool allow_dma_timer, pace_solution_t *out) {
+    if (!out || sample_rate == 0 || clk_hz == 0 || sample_rate > clk_hz) {
+        return false;
+    }
+
+    bool found = solve_pwm(clk_hz, sample_rate, 1u, PWM_PERIOD_MAX, out);
+
+    pace_solution_t timer;
+    if (allow_dma_timer && solve_dma_timer(clk_hz, sample_rate, &timer)) {
+        int64_t pwm_err = out->error_ppb < 0 ? -(int64_t)out->error_ppb : out->error_ppb;
+        int64_t timer_err = timer.error_ppb < 0 ? -(int64_t)timer.error_ppb : timer.error_ppb;
+        if (!found || timer_err < pwm_err) {
+            *out = timer;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool pace_solve_carrier(uint32_t clk_hz, uint32_t carrier_hz, uint32_t period_min, uint32_t period_max,
+                        pace_solution_t *out) {
+    if (!out || carrier_hz == 0 || clk_hz == 0 || period_min == 0 || period_min > period_max ||
+        period_max > PWM_PERIOD_MAX) {
+        return false;
+    }
+    return solve_pwm(clk_hz, carrier_hz, period_min, period_max, out);
+}
@@ -0,0 +1,36 @@
+#ifndef PACE_SOLVER_H
+#define PACE_SOLVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Where the sample-rate DREQ comes from.
+typedef enum {
+    PACE_SOURCE_PWM = 0,   // PWM slice wrap: clk_sys / (div * (wrap + 1)), div in 8.4 fixed point
+    PACE_SOURCE_DMA_TIMER, // DMA pacing timer: clk_sys * num / den, both 16-bit
+} pace_source_t;
+
+typedef struct {
+    pace_source_t source;
+    uint16_t pwm_wrap;
+    uint8_t pwm_div_int;
+    uint8_t pwm_div_frac;
+    uint16_t timer_num;
+    uint16_t timer_den;
+    uint32_t rate_millihz;  // achieved DREQ rate
+    int32_t error_ppb;      // (achieved - requested) / requested, parts per billion
+} pace_solution_t;
+
+// Picks the PWM divider/wrap pair closest to sample_rate and, if allowed and
+// strictly better, a DMA pacing timer fraction instead. Pure integer maths,
+// no hardware access. False if neither can make the rate (below about
+// clk_hz / 2^24 for PWM); *out is then left alone.
+bool pace_solve(uint32_t clk_hz, uint32_t sample_rate, bool allow_dma_timer, pace_solution_t *out);
+
+// Picks the PWM divider/period pair closest to carrier_hz with the period
+// (wrap + 1) kept within [period_min, period_max], for outputs whose own
+// wrap paces the DMA. False if the clock cannot reach the range.
+bool pace_solve_carrier(uint32_t clk_hz, uint32_t carrier_hz, uint32_t period_min, uint32_t period_max,
+                        pace_solution_t *out);
+
+#endif
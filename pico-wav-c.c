@@ -1,44 +1,81 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "pico/stdio_usb.h"
 #include "audio_pwm_dma.h"
-#include "wav_data.h"
 #include "wav.h"
+#include "wav_clip.h"
 
 // GPIO that feeds the RC filter / amplifier for PWM audio.
 #define AUDIO_PIN 0
 
-int main() {
-    stdio_init_all();
-    sleep_ms(2000);
+// How long to wait for a USB serial monitor before reporting.
+#define REPORT_WAIT_MS 2000
 
-    wav_info_t wav = {0};
-    if (!parse_wav(wav_data, wav_data_len, &wav)) {
-        // Parsing failed; stop early so we do not drive the pin with nonsense.
-        printf("ERROR: WAV parsing failed!\n");
-        while (true) {
-            tight_loop_contents();
-        }
+static void wait_for_usb(void) {
+    for (uint i = 0; i < REPORT_WAIT_MS / 10 && !stdio_usb_connected(); ++i) {
+        sleep_ms(10);
     }
+}
 
+int main() {
+    // Sound first: the clip was converted and described at build time
+    // (pico_wav_embed in CMakeLists.txt), so there is nothing to parse, and
+    // USB enumerates while it plays. The timer counts from clock setup.
+    uint64_t t_main = time_us_64();
+    const wav_info_t wav = wav_clip;
     audio_player_t player = {0};
-    if (!audio_pwm_dma_init(&player, &wav, AUDIO_PIN)) {
+    audio_pwm_dma_config_t config = audio_pwm_dma_get_default_config(AUDIO_PIN);
+    config.pipeline = AUDIO_PWM_DMA_PIPELINE;
+    bool ok = audio_pwm_dma_init_with_config(&player, &wav, &config);
+    uint64_t t_init = time_us_64();
+    if (ok) {
+        audio_pwm_dma_start(&player);
+    }
+    uint64_t t_start = time_us_64();
+
+    stdio_init_all();
+    if (!ok) {
+        wait_for_usb();
         printf("ERROR: Failed to initialize PWM + DMA audio\n");
         while (true) {
             tight_loop_contents();
         }
     }
 
-    audio_pwm_dma_start(&player);
+    // Sleep through playback; the player stops DMA, pacing and its IRQ at
+    // the end of the clip, so the core can stay asleep afterwards.
+    audio_pwm_dma_wait(&player);
+    wait_for_usb();
 
     printf("Pico WAV Player - USB Debug Enabled\n");
     printf("WAV Info:\n");
     printf("  Sample Rate: %lu Hz\n", wav.sample_rate);
+    printf("  Paced At: %lu.%03lu Hz (%ld ppb, %s)\n",
+           (unsigned long)(player.pace_rate_millihz / 1000u),
+           (unsigned long)(player.pace_rate_millihz % 1000u),
+           (long)player.pace_error_ppb,
+           player.pace_timer >= 0 ? "DMA timer" : "PWM slice");
     printf("  Bits per Sample: %u\n", wav.bits_per_sample);
     printf("  Channels: %u\n", wav.channels);
     printf("  Data Size: %zu bytes\n", wav.data_size);
-    printf("Playback started! PWM + DMA running (silence after EOF).\n");
+    printf("Time to sound: main() at %llu us, init took %llu us, DMA running at %llu us\n",
+           (unsigned long long)t_main, (unsigned long long)(t_init - t_main), (unsigned long long)t_start);
+    printf("Playback finished; idle.\n");
+
+    audio_pwm_dma_stats_t stats;
+    audio_pwm_dma_get_stats(&player, &stats);
+    printf("  Underruns: %lu\n", (unsigned long)stats.underruns);
+    printf("  Refills: %lu, samples played: %llu\n", (unsigned long)stats.refills,
+           (unsigned long long)stats.samples_played);
+    printf("  IRQ cycles: avg %lu, max %lu over %lu IRQs\n", (unsigned long)stats.isr_cycles_avg,
+           (unsigned long)stats.isr_cycles_max, (unsigned long)stats.isr_count);
+    if (config.pipeline) {
+        printf("  Queued by core 1: min %lu, avg %lu of %u samples\n", (unsigned long)stats.queued_min,
+               (unsigned long)stats.queued_avg, player.buffer_count * player.buffer_samples);
+    }
 
     while (true) {
-        tight_loop_contents();
+        __wfi();
     }
 }
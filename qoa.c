@@ -0,0 +1,193 @@
+#include "qoa.h"
+
+// "qoaf", then the total samples per channel, both big-endian.
+#define QOA_MAGIC 0x716f6166u
+#define QOA_HEADER_SIZE 8u
+
+// The 16 scale factors times the 8 residuals a 3-bit code stands for,
+// 0.75/2.5/4.5/7 with alternating signs, rounded away from zero.
+static const int16_t dequant_table[16][8] = {
+    {1, -1, 3, -3, 5, -5, 7, -7},
+    {5, -5, 18, -18, 32, -32, 49, -49},
+    {16, -16, 53, -53, 95, -95, 147, -147},
+    {34, -34, 113, -113, 203, -203, 315, -315},
+    {63, -63, 210, -210, 378, -378, 588, -588},
+    {104, -104, 345, -345, 621, -621, 966, -966},
+    {158, -158, 528, -528, 950, -950, 1477, -1477},
+    {228, -228, 760, -760, 1368, -1368, 2128, -2128},
+    {316, -316, 1053, -1053, 1895, -1895, 2947, -2947},
+    {422, -422, 1405, -1405, 2529, -2529, 3934, -3934},
+    {548, -548, 1828, -1828, 3290, -3290, 5117, -5117},
+    {696, -696, 2320, -2320, 4176, -4176, 6496, -6496},
+    {868, -868, 2893, -2893, 5207, -5207, 8099, -8099},
+    {1064, -1064, 3548, -3548, 6386, -6386, 9933, -9933},
+    {1286, -1286, 4288, -4288, 7718, -7718, 12005, -12005},
+    {1536, -1536, 5120, -5120, 9216, -9216, 14336, -14336},
+};
+
+static uint32_t read_u16_be(const uint8_t *p) {
+    return (uint32_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t read_u32_be(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t read_u64_be(const uint8_t *p) {
+    return ((uint64_t)read_u32_be(p) << 32) | read_u32_be(p + 4);
+}
+
+// Bytes in a frame of samples per channel: the 8-byte header, 16 bytes of
+// LMS state per channel, then one 8-byte slice per channel per 20 samples.
+static size_t frame_size(uint32_t channels, uint32_t samples) {
+    return 8u + 16u * channels + 8u * channels * ((samples + QOA_SLICE_LEN - 1u) / QOA_SLICE_LEN);
+}
+
+bool parse_qoa(const uint8_t *buffer, size_t length, wav_info_t *out) {
+    if (!buffer || !out) {
+        return false;
+    }
+    if (length < QOA_HEADER_SIZE + 8u || read_u32_be(buffer) != QOA_MAGIC) {
+        return false;
+    }
+    // A zero sample count marks a streamed file of unknown length.
+    uint32_t total = read_u32_be(buffer + 4);
+    const uint8_t *first = buffer + QOA_HEADER_SIZE;
+    uint32_t channels = first[0];
+    uint32_t rate = read_u32_be(first) & 0xffffffu;
+    if (total == 0 || rate == 0 || (channels != 1 && channels != 2)) {
+        return false;
+    }
+
+    // Every frame but the last holds QOA_FRAME_LEN samples, so a frame's
+    // offset follows from its index when seeking.
+    size_t offset = QOA_HEADER_SIZE;
+    uint32_t decoded = 0;
+    while (decoded < total && offset + 8u <= length) {
+        const uint8_t *h = buffer + offset;
+        uint32_t samples = read_u16_be(h + 4);
+        size_t size = read_u16_be(h + 6);
+        if (h[0] != channels || (read_u32_be(h) & 0xffffffu) != rate || samples == 0 ||
+            samples > QOA_FRAME_LEN || samples > total - decoded || size != frame_size(channels, samples) ||
+            size > length - offset) {
+            break;
+        }
+        offset += size;
+        decoded += samples;
+        if (samples < QOA_FRAME_LEN) {
+            break;
+        }
+    }
+    if (decoded == 0) {
+        return false;
+    }
+
+    *out = (wav_info_t){
+        .data = first,
+        .data_size = offset - QOA_HEADER_SIZE,
+        .sample_rate = rate,
+        .bits_per_sample = 16,
+        .channels = (uint16_t)channels,
+        .encoding = WAV_ENCODING_QOA,
+        .block_align = (uint16_t)frame_size(channels, QOA_FRAME_LEN),
+        .samples_per_block = QOA_FRAME_LEN,
+    };
+    return true;
+}
+
+void qoa_init(qoa_decoder_t *dec, const uint8_t *data, size_t size, uint16_t channels) {
+    dec->cursor = data;
+    dec->remaining = size;
+    dec->channels = channels;
+    dec->frame_left = 0;
+}
+
+// Reads a frame header and the LMS state after it: four history samples,
+// then four weights, per channel, as big-endian s16. Returns false at the
+// end of the data.
+static bool start_frame(qoa_decoder_t *dec) {
+    uint32_t channels = dec->channels;
+    uint32_t header = 8u + 16u * channels;
+    if (dec->remaining < header || read_u16_be(dec->cursor + 4) == 0) {
+        dec->remaining = 0;
+        return false;
+    }
+    dec->frame_left = (uint16_t)read_u16_be(dec->cursor + 4);
+    const uint8_t *p = dec->cursor + 8;
+    for (uint32_t c = 0; c < channels; ++c, p += 16) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            dec->history[c][i] = (int16_t)read_u16_be(p + 2u * i);
+            dec->weights[c][i] = (int16_t)read_u16_be(p + 8u + 2u * i);
+        }
+    }
+    dec->cursor += header;
+    dec->remaining -= header;
+    return true;
+}
+
+// n samples of one channel's slice, written every stride samples: a 4-bit
+// scale factor, then 3-bit residual codes from the top down. The predictor
+// lives in locals for the run of the slice.
+static inline void decode_slice(uint64_t slice, uint32_t n, int32_t *history, int32_t *weights, int16_t *out,
+                                size_t stride) {
+    const int16_t *dequant = dequant_table[slice >> 60];
+    int32_t h0 = history[0], h1 = history[1], h2 = history[2], h3 = history[3];
+    int32_t w0 = weights[0], w1 = weights[1], w2 = weights[2], w3 = weights[3];
+    slice <<= 4;
+    for (uint32_t i = 0; i < n; ++i) {
+        int32_t predicted = (h0 * w0 + h1 * w1 + h2 * w2 + h3 * w3) >> 13;
+        int32_t residual = dequant[slice >> 61];
+        slice <<= 3;
+        int32_t sample = predicted + residual;
+        if (sample > 32767) {
+            sample = 32767;
+        } else if (sample < -32768) {
+            sample = -32768;
+        }
+        out[i * stride] = (int16_t)sample;
+        // Sign-sign LMS: each weight moves by residual/16 towards its input.
+        int32_t delta = residual >> 4;
+        w0 += h0 < 0 ? -delta : delta;
+        w1 += h1 < 0 ? -delta : delta;
+        w2 += h2 < 0 ? -delta : delta;
+        w3 += h3 < 0 ? -delta : delta;
+        h0 = h1;
+        h1 = h2;
+        h2 = h3;
+        h3 = sample;
+    }
+    history[0] = h0;
+    history[1] = h1;
+    history[2] = h2;
+    history[3] = h3;
+    weights[0] = w0;
+    weights[1] = w1;
+    weights[2] = w2;
+    weights[3] = w3;
+}
+
+size_t qoa_decode(qoa_decoder_t *dec, int16_t *out, size_t max_frames) {
+    uint32_t channels = dec->channels;
+    uint32_t slices = 8u * channels;
+    size_t frames = 0;
+    while (frames + QOA_SLICE_LEN <= max_frames) {
+        if (dec->frame_left == 0 && !start_frame(dec)) {
+            break;
+        }
+        if (dec->remaining < slices) {
+            dec->frame_left = 0;
+            dec->remaining = 0;
+            break;
+        }
+        uint32_t n = dec->frame_left < QOA_SLICE_LEN ? dec->frame_left : QOA_SLICE_LEN;
+        for (uint32_t c = 0; c < channels; ++c) {
+            decode_slice(read_u64_be(dec->cursor + 8u * c), n, dec->history[c], dec->weights[c],
+                         out + frames * channels + c, channels);
+        }
+        dec->cursor += slices;
+        dec->remaining -= slices;
+        dec->frame_left = (uint16_t)(dec->frame_left - n);
+        frames += n;
+    }
+    return frames;
+}
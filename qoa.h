@@ -0,0 +1,42 @@
+#ifndef QOA_H
+#define QOA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wav.h"
+
+// Samples per channel in every QOA frame but the last, and in every slice.
+#define QOA_FRAME_LEN 5120u
+#define QOA_SLICE_LEN 20u
+
+// Position in a QOA ("Quite OK Audio") stream: the next byte, the bytes
+// left, the samples per channel left in the current frame, and each
+// channel's LMS predictor (history and weights).
+typedef struct {
+    const uint8_t *cursor;
+    size_t remaining;
+    uint16_t channels;
+    uint16_t frame_left;
+    int32_t history[2][4];
+    int32_t weights[2][4];
+} qoa_decoder_t;
+
+// Parses a QOA file held in memory into the same description parse_wav()
+// gives: data and data_size cover the frames from the first one on,
+// block_align is the size of a full frame and samples_per_block its
+// QOA_FRAME_LEN samples. Mono and stereo only. Frames are checked against
+// the first one's format and their own sample counts; anything from the
+// first bad or short frame on is dropped.
+bool parse_qoa(const uint8_t *buffer, size_t length, wav_info_t *out);
+
+// data must start at a frame header, so a stream can be opened on any frame.
+void qoa_init(qoa_decoder_t *dec, const uint8_t *data, size_t size, uint16_t channels);
+
+// Decodes up to max_frames interleaved s16 frames into out, stopping before
+// a slice that would not fit; max_frames must be at least QOA_SLICE_LEN.
+// Returns the frames written, 0 once the data is used up.
+size_t qoa_decode(qoa_decoder_t *dec, int16_t *out, size_t max_frames);
+
+#endif
@@ -0,0 +1,88 @@
+#include "sound_bank.h"
+
+#include "qoa.h"
+
+static uint16_t read_u16_le(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32_le(const uint8_t *p) {
+    return (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24));
+}
+
+bool sound_bank_open(sound_bank_t *bank, const uint8_t *data, size_t size) {
+    if (!bank || !data || size < SOUND_BANK_HEADER_SIZE) {
+        return false;
+    }
+    if (data[0] != 'P' || data[1] != 'W' || data[2] != 'S' || data[3] != 'B' ||
+        read_u16_le(data + 4) != SOUND_BANK_VERSION || read_u16_le(data + 6) != SOUND_BANK_ENTRY_SIZE) {
+        return false;
+    }
+    uint32_t count = read_u32_le(data + 8);
+    uint32_t index = read_u32_le(data + 12);
+    if (index < SOUND_BANK_HEADER_SIZE || index > size || count > (size - index) / SOUND_BANK_ENTRY_SIZE) {
+        return false;
+    }
+    *bank = (sound_bank_t){.base = data, .size = size, .count = count, .index = data + index};
+    return true;
+}
+
+// Whether a consumer can play the clip: PCM and G.711 in the sample formats
+// parse_wav() accepts, cut to whole frames, and the block codecs with the
+// layout parse_wav() or parse_qoa() would give, since they are counted and
+// seeked by dividing by their block size and frames per block.
+static bool playable(const wav_info_t *wav) {
+    uint16_t bits = wav->bits_per_sample;
+    uint16_t channels = wav->channels;
+    if (wav->sample_rate == 0 || (channels != 1 && channels != 2) || (wav->is_float && bits != 32)) {
+        return false;
+    }
+    switch (wav->encoding) {
+    case WAV_ENCODING_PCM:
+        return (bits == 8 || bits == 16 || bits == 24 || bits == 32) && wav->data_size % (bits / 8u * channels) == 0;
+    case WAV_ENCODING_ALAW:
+    case WAV_ENCODING_MULAW:
+        return bits == 8 && !wav->is_float && wav->data_size % channels == 0;
+    case WAV_ENCODING_IMA_ADPCM: {
+        uint32_t header = 4u * channels;
+        return bits == 4 && !wav->is_float && wav->block_align > header &&
+               (wav->block_align - header) % header == 0 &&
+               wav->samples_per_block == (wav->block_align - header) * 2u / channels + 1u;
+    }
+    case WAV_ENCODING_QOA: {
+        uint32_t slices = QOA_FRAME_LEN / QOA_SLICE_LEN;
+        return bits == 16 && !wav->is_float && wav->samples_per_block == QOA_FRAME_LEN &&
+               wav->block_align == 8u + 16u * channels + 8u * channels * slices;
+    }
+    default:
+        return false;
+    }
+}
+
+bool sound_bank_get(const sound_bank_t *bank, uint32_t id, wav_info_t *out) {
+    if (!bank || !out || id >= bank->count) {
+        return false;
+    }
+    const uint8_t *e = bank->index + (size_t)id * SOUND_BANK_ENTRY_SIZE;
+    uint32_t offset = read_u32_le(e);
+    uint32_t size = read_u32_le(e + 4);
+    if (offset > bank->size || size > bank->size - offset) {
+        return false;
+    }
+    wav_info_t wav = {
+        .data = bank->base + offset,
+        .data_size = size,
+        .sample_rate = read_u32_le(e + 8),
+        .bits_per_sample = e[18],
+        .channels = e[17],
+        .is_float = (e[19] & 1u) != 0,
+        .encoding = (wav_encoding_t)e[16],
+        .block_align = read_u16_le(e + 12),
+        .samples_per_block = read_u16_le(e + 14),
+    };
+    if (!playable(&wav)) {
+        return false;
+    }
+    *out = wav;
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef SOUND_BANK_H
+#define SOUND_BANK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wav.h"
+
+// A sound bank packs many clips, already converted and described, into one
+// blob: a 16-byte header, an index of fixed-size entries in clip id order,
+// then the sample data of each clip, 4-byte aligned. All fields are
+// little-endian.
+//
+//   header: "PWSB", u16 version, u16 entry size, u32 clip count, u32 index offset
+//   entry:  u32 data offset (from the start of the bank), u32 data size,
+//           u32 sample rate, u16 block align, u16 samples per block,
+//           u8 encoding (wav_encoding_t), u8 channels, u8 bits per sample,
+//           u8 flags (bit 0: IEEE float)
+//
+// Ids are dense, 0 to count - 1, so a lookup is one index read. Banks are
+// built by host/sound_bank_tool.c, or at build time by pico_sound_bank().
+#define SOUND_BANK_VERSION 1u
+#define SOUND_BANK_HEADER_SIZE 16u
+#define SOUND_BANK_ENTRY_SIZE 20u
+
+typedef struct {
+    const uint8_t *base;
+    size_t size;
+    uint32_t count;
+    const uint8_t *index;
+} sound_bank_t;
+
+// Checks a bank's header and that its index fits. Entries are checked as
+// they are looked up, so this does not depend on the number of clips.
+bool sound_bank_open(sound_bank_t *bank, const uint8_t *data, size_t size);
+
+// Describes clip id as parse_wav() would, without touching its data. False
+// for an id out of range, an entry that points outside the bank, or one no
+// consumer could play: a sample format parse_wav() would refuse, a zero
+// rate, PCM or G.711 data that is not whole frames, or an ADPCM or QOA
+// block layout that is not the codec's.
+bool sound_bank_get(const sound_bank_t *bank, uint32_t id, wav_info_t *out);
+
+#endif
@@ -10,6 +10,132 @@ static uint32_t read_u32_le(const uint8_t *p) {
     return (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24));
 }
 
+#define WAVE_FORMAT_PCM 1u
+#define WAVE_FORMAT_IEEE_FLOAT 3u
+#define WAVE_FORMAT_ALAW 6u
+#define WAVE_FORMAT_MULAW 7u
+#define WAVE_FORMAT_IMA_ADPCM 0x11u
+#define WAVE_FORMAT_EXTENSIBLE 0xfffeu
+
+// Bytes of "fmt " that matter: 16 for the basic header, 40 to reach the
+// sub-format GUID of WAVE_FORMAT_EXTENSIBLE.
+#define FMT_BASIC_SIZE 16u
+#define FMT_EXTENSIBLE_SIZE 40u
+
+// KSDATAFORMAT_SUBTYPE_PCM/IEEE_FLOAT/ALAW/MULAW share this GUID after the
+// format tag.
+static const uint8_t subformat_guid_tail[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80,
+                                                0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71};
+
+// The format tag, with WAVE_FORMAT_EXTENSIBLE resolved to its sub-format.
+// Returns 0 for an extensible header too short to carry one or with a GUID
+// outside the standard family.
+static uint16_t read_format_tag(const uint8_t *fmt, uint32_t size) {
+    uint16_t tag = read_u16_le(fmt);
+    if (tag != WAVE_FORMAT_EXTENSIBLE) {
+        return tag;
+    }
+    if (size < FMT_EXTENSIBLE_SIZE || memcmp(fmt + 26, subformat_guid_tail, sizeof(subformat_guid_tail))) {
+        return 0;
+    }
+    return read_u16_le(fmt + 24);
+}
+
+// Reads a "fmt " chunk of size bytes (at least FMT_BASIC_SIZE) into info,
+// leaving data and data_size alone. Returns whether the format is one the
+// player supports; the checks are shared by both parsers.
+static bool read_fmt(const uint8_t *fmt, uint32_t size, wav_info_t *info) {
+    uint16_t audio_format = read_format_tag(fmt, size);
+    info->channels = read_u16_le(fmt + 2);
+    info->sample_rate = read_u32_le(fmt + 4);
+    info->block_align = read_u16_le(fmt + 12);
+    info->bits_per_sample = read_u16_le(fmt + 14);
+    info->is_float = audio_format == WAVE_FORMAT_IEEE_FLOAT;
+    switch (audio_format) {
+    case WAVE_FORMAT_IMA_ADPCM:
+        info->encoding = WAV_ENCODING_IMA_ADPCM;
+        break;
+    case WAVE_FORMAT_ALAW:
+        info->encoding = WAV_ENCODING_ALAW;
+        break;
+    case WAVE_FORMAT_MULAW:
+        info->encoding = WAV_ENCODING_MULAW;
+        break;
+    default:
+        info->encoding = WAV_ENCODING_PCM;
+        break;
+    }
+    info->samples_per_block = 0;
+    if (info->sample_rate == 0 || (info->channels != 1 && info->channels != 2)) {
+        return false;
+    }
+
+    uint16_t bits = info->bits_per_sample;
+    switch (audio_format) {
+    case WAVE_FORMAT_PCM:
+        return bits == 8 || bits == 16 || bits == 24 || bits == 32;
+    case WAVE_FORMAT_IEEE_FLOAT:
+        return bits == 32;
+    case WAVE_FORMAT_ALAW:
+    case WAVE_FORMAT_MULAW:
+        return bits == 8;
+    case WAVE_FORMAT_IMA_ADPCM: {
+        // A 4-byte header per channel, then 4-byte words of 8 nibbles per
+        // channel in turn. The header holds the block's first sample.
+        uint32_t header = 4u * info->channels;
+        if (bits != 4 || info->block_align <= header || (info->block_align - header) % header) {
+            return false;
+        }
+        info->samples_per_block = (uint16_t)((info->block_align - header) * 2u / info->channels + 1u);
+        // wSamplesPerBlock, when present, must agree with the layout.
+        return size < 20u || read_u16_le(fmt + 16) < 2u || read_u16_le(fmt + 18) == info->samples_per_block;
+    }
+    default:
+        return false;
+    }
+}
+
+// A data chunk of size bytes cut back to what decodes to whole frames: for
+// PCM a multiple of the frame size, for IMA ADPCM whole blocks plus a last
+// block that stops after a whole group of words.
+static size_t usable_data_size(const wav_info_t *info, uint32_t size) {
+    if (info->encoding == WAV_ENCODING_IMA_ADPCM) {
+        uint32_t header = 4u * info->channels;
+        uint32_t tail = size % info->block_align;
+        if (tail < header) {
+            return size - tail;
+        }
+        return size - (tail - header) % header;
+    }
+    uint32_t stride = (info->bits_per_sample / 8u) * info->channels;
+    return size - (size % stride);
+}
+
+size_t wav_frame_count(const wav_info_t *wav) {
+    if (wav->encoding == WAV_ENCODING_IMA_ADPCM) {
+        uint32_t header = 4u * wav->channels;
+        size_t blocks = wav->data_size / wav->block_align;
+        size_t tail = wav->data_size % wav->block_align;
+        size_t frames = blocks * wav->samples_per_block;
+        if (tail >= header) {
+            frames += 1u + (tail - header) * 2u / wav->channels;
+        }
+        return frames;
+    }
+    if (wav->encoding == WAV_ENCODING_QOA) {
+        // Full frames, then the last frame's own sample count (big-endian,
+        // bytes 4-5 of its header).
+        size_t blocks = wav->data_size / wav->block_align;
+        size_t frames = blocks * wav->samples_per_block;
+        if (wav->data_size % wav->block_align) {
+            const uint8_t *last = wav->data + blocks * wav->block_align;
+            frames += (size_t)((last[4] << 8) | last[5]);
+        }
+        return frames;
+    }
+    return wav->data_size / ((wav->bits_per_sample / 8u) * wav->channels);
+}
+
 bool parse_wav(const uint8_t *buffer, size_t length, wav_info_t *out) {
     if (!buffer || !out) {
         return false;
@@ -18,10 +144,8 @@ bool parse_wav(const uint8_t *buffer, size_t length, wav_info_t *out) {
         return false;
     }
 
-    uint16_t audio_format = 0;
-    uint16_t channels = 0;
-    uint32_t sample_rate = 0;
-    uint16_t bits_per_sample = 0;
+    const uint8_t *fmt_ptr = NULL;
+    uint32_t fmt_size = 0;
     const uint8_t *data_ptr = NULL;
     uint32_t data_size = 0;
 
@@ -30,11 +154,9 @@ bool parse_wav(const uint8_t *buffer, size_t length, wav_info_t *out) {
         const uint8_t *chunk = buffer + offset;
         uint32_t chunk_size = read_u32_le(chunk + 4);
         const uint8_t *chunk_data = chunk + 8;
-        if (!memcmp(chunk, "fmt ", 4) && chunk_size >= 16 && offset + 8 + chunk_size <= length) {
-            audio_format = read_u16_le(chunk_data + 0);
-            channels = read_u16_le(chunk_data + 2);
-            sample_rate = read_u32_le(chunk_data + 4);
-            bits_per_sample = read_u16_le(chunk_data + 14);
+        if (!memcmp(chunk, "fmt ", 4) && chunk_size >= FMT_BASIC_SIZE && offset + 8 + chunk_size <= length) {
+            fmt_ptr = chunk_data;
+            fmt_size = chunk_size;
         } else if (!memcmp(chunk, "data", 4) && offset + 8 + chunk_size <= length) {
             data_ptr = chunk_data;
             data_size = chunk_size;
@@ -43,24 +165,154 @@ bool parse_wav(const uint8_t *buffer, size_t length, wav_info_t *out) {
         offset += 8 + chunk_size + (chunk_size & 1u);
     }
 
-    if (audio_format != 1 || !data_ptr || !data_size || sample_rate == 0) {
+    wav_info_t info;
+    if (!fmt_ptr || !data_ptr || !read_fmt(fmt_ptr, fmt_size, &info)) {
         return false;
     }
-    if (channels != 1 && channels != 2) {
+    info.data = data_ptr;
+    info.data_size = usable_data_size(&info, data_size);
+    if (info.data_size == 0) {
         return false;
     }
-    if (bits_per_sample != 8 && bits_per_sample != 16) {
-        return false;
+    *out = info;
+    return true;
+}
+
+enum {
+    STREAM_RIFF = 0,   // collecting the 12-byte RIFF/WAVE header
+    STREAM_CHUNK,      // collecting an 8-byte chunk header
+    STREAM_FMT,        // collecting the first 16-40 bytes of "fmt "
+    STREAM_SKIP,       // skipping the rest of a chunk and its pad byte
+    STREAM_DATA,       // handing out data spans
+    STREAM_DONE,
+    STREAM_ERROR,
+};
+
+static void stream_collect(wav_stream_t *stream, uint8_t state, uint8_t need) {
+    stream->state = state;
+    stream->held = 0;
+    stream->need = need;
+}
+
+static void stream_skip(wav_stream_t *stream, uint32_t skip) {
+    stream->skip = skip;
+    stream->state = STREAM_SKIP;
+    if (skip == 0) {
+        stream_collect(stream, STREAM_CHUNK, 8);
     }
+}
 
-    uint32_t stride = (bits_per_sample / 8) * channels;
-    out->data = data_ptr;
-    out->data_size = data_size - (data_size % stride);
-    out->sample_rate = sample_rate;
-    out->bits_per_sample = bits_per_sample;
-    out->channels = channels;
-    if (out->data_size == 0) {
-        return false;
+// A chunk header is complete: keep the format, start handing out data, or
+// skip it. Returns the event it raises, if any.
+static wav_stream_event_t stream_chunk(wav_stream_t *stream) {
+    const uint8_t *id = stream->hold;
+    uint32_t size = read_u32_le(stream->hold + 4);
+    if (!memcmp(id, "fmt ", 4) && size >= FMT_BASIC_SIZE) {
+        // Stash the remainder to skip once the fields are in.
+        uint8_t need = (uint8_t)(size < FMT_EXTENSIBLE_SIZE ? size : FMT_EXTENSIBLE_SIZE);
+        stream->skip = size - need + (size & 1u);
+        stream_collect(stream, STREAM_FMT, need);
+        return WAV_STREAM_NEED_MORE;
     }
-    return true;
+    if (memcmp(id, "data", 4)) {
+        stream_skip(stream, size + (size & 1u));
+        return WAV_STREAM_NEED_MORE;
+    }
+
+    wav_info_t *info = &stream->info;
+    if (!stream->have_fmt || !stream->fmt_ok) {
+        stream->state = STREAM_ERROR;
+        return WAV_STREAM_ERROR;
+    }
+    info->data = NULL;
+    info->data_size = usable_data_size(info, size);
+    if (info->data_size == 0) {
+        stream->state = STREAM_ERROR;
+        return WAV_STREAM_ERROR;
+    }
+    stream->data_left = (uint32_t)info->data_size;
+    stream->state = STREAM_DATA;
+    return WAV_STREAM_FORMAT;
+}
+
+// hold now has the bytes the current state was waiting for.
+static wav_stream_event_t stream_header(wav_stream_t *stream) {
+    const uint8_t *h = stream->hold;
+    switch (stream->state) {
+    case STREAM_RIFF:
+        if (memcmp(h, "RIFF", 4) || memcmp(h + 8, "WAVE", 4)) {
+            stream->state = STREAM_ERROR;
+            return WAV_STREAM_ERROR;
+        }
+        stream_collect(stream, STREAM_CHUNK, 8);
+        return WAV_STREAM_NEED_MORE;
+    case STREAM_CHUNK:
+        return stream_chunk(stream);
+    default:
+        stream->fmt_ok = read_fmt(h, stream->need, &stream->info);
+        stream->have_fmt = true;
+        stream_skip(stream, stream->skip);
+        return WAV_STREAM_NEED_MORE;
+    }
+}
+
+void wav_stream_init(wav_stream_t *stream) {
+    memset(stream, 0, sizeof(*stream));
+    stream_collect(stream, STREAM_RIFF, 12);
+}
+
+wav_stream_event_t wav_stream_feed(wav_stream_t *stream, const uint8_t *bytes, size_t length, size_t *consumed) {
+    size_t pos = 0;
+    wav_stream_event_t event = WAV_STREAM_NEED_MORE;
+    stream->span = NULL;
+    stream->span_size = 0;
+
+    while (event == WAV_STREAM_NEED_MORE) {
+        if (stream->state == STREAM_DONE) {
+            pos = length;
+            event = WAV_STREAM_DONE;
+        } else if (stream->state == STREAM_ERROR) {
+            event = WAV_STREAM_ERROR;
+        } else if (stream->state == STREAM_DATA) {
+            if (stream->data_left == 0) {
+                // Whatever follows the data chunk is of no interest.
+                stream->state = STREAM_DONE;
+                continue;
+            }
+            size_t n = length - pos < stream->data_left ? length - pos : stream->data_left;
+            if (n == 0) {
+                break;
+            }
+            stream->span = bytes + pos;
+            stream->span_size = n;
+            stream->data_left -= (uint32_t)n;
+            pos += n;
+            event = WAV_STREAM_DATA;
+        } else if (pos == length) {
+            break;
+        } else if (stream->state == STREAM_SKIP) {
+            size_t n = length - pos < stream->skip ? length - pos : stream->skip;
+            pos += n;
+            stream->skip -= (uint32_t)n;
+            if (stream->skip == 0) {
+                stream_collect(stream, STREAM_CHUNK, 8);
+            }
+        } else {
+            size_t n = stream->need - stream->held;
+            if (n > length - pos) {
+                n = length - pos;
+            }
+            memcpy(stream->hold + stream->held, bytes + pos, n);
+            stream->held = (uint8_t)(stream->held + n);
+            pos += n;
+            if (stream->held == stream->need) {
+                event = stream_header(stream);
+            }
+        }
+    }
+
+    if (consumed) {
+        *consumed = pos;
+    }
+    return event;
 }
@@ -5,15 +5,67 @@
 #include <stddef.h>
 #include <stdint.h>
 
+typedef enum {
+    WAV_ENCODING_PCM = 0,    // integer or float samples as stored
+    WAV_ENCODING_IMA_ADPCM,  // IMA/DVI ADPCM (format 0x11), 4 bits per sample
+    WAV_ENCODING_QOA,        // QOA frames (see qoa.h), about 3.2 bits per sample
+    WAV_ENCODING_ALAW,       // G.711 A-law (format 6), 8 bits per sample
+    WAV_ENCODING_MULAW,      // G.711 mu-law (format 7), 8 bits per sample
+} wav_encoding_t;
+
 typedef struct {
     const uint8_t *data;
     size_t data_size;
     uint32_t sample_rate;
     uint16_t bits_per_sample;
     uint16_t channels;
+    bool is_float;  // IEEE float samples (32-bit only); otherwise integer PCM
+    wav_encoding_t encoding;
+    uint16_t block_align;        // bytes per frame, or per block (QOA: per full frame)
+    uint16_t samples_per_block;  // IMA ADPCM and QOA only: frames per block
 } wav_info_t;
 
-// Minimal WAV parser for PCM mono/stereo, 8/16-bit.
+// Minimal WAV parser for mono/stereo PCM (8-bit unsigned, 16/24/32-bit
+// signed), 32-bit IEEE float, G.711 A-law and mu-law, in plain or
+// WAVE_FORMAT_EXTENSIBLE headers, and IMA ADPCM.
 bool parse_wav(const uint8_t *buffer, size_t length, wav_info_t *out);
 
+// Frames in a parsed WAV's data.
+size_t wav_frame_count(const wav_info_t *wav);
+
+// Push-style parser for WAVs that are not memory-resident (SD card, SPI
+// flash, USB). Feed the file in chunks of any size; the parser keeps at most
+// one header's worth of bytes and hands sample data back as spans of the
+// caller's own chunks, so nothing is copied.
+typedef enum {
+    WAV_STREAM_NEED_MORE = 0,  // input used up; feed the next chunk
+    WAV_STREAM_FORMAT,         // info holds the format; data is NULL, data_size the usable bytes
+    WAV_STREAM_DATA,           // span/span_size hold the next sample bytes, inside the fed chunk
+    WAV_STREAM_DONE,           // every usable data byte has been handed out
+    WAV_STREAM_ERROR,          // not a supported WAV
+} wav_stream_event_t;
+
+typedef struct {
+    uint8_t state;
+    uint8_t held;
+    uint8_t need;
+    bool have_fmt;
+    uint8_t hold[40];
+    uint32_t skip;
+    uint32_t data_left;
+    bool fmt_ok;
+    wav_info_t info;
+    const uint8_t *span;
+    size_t span_size;
+} wav_stream_t;
+
+void wav_stream_init(wav_stream_t *stream);
+
+// Parses up to length bytes and stops at the first event, setting *consumed
+// to the bytes used. Call again with the rest of the chunk (or an empty
+// one) until it returns WAV_STREAM_NEED_MORE, DONE or ERROR. Accepts what
+// parse_wav() accepts, except that "fmt " must come before "data" and the
+// first data chunk is the one played.
+wav_stream_event_t wav_stream_feed(wav_stream_t *stream, const uint8_t *bytes, size_t length, size_t *consumed);
+
 #endif